@@ -0,0 +1,32 @@
+# 适用于Linux，在image目录下运行，需先执行img-write-linux.sh
+# 无界面启动qemu，通过监视器向shell输入/bench.elf，结果从串口写入bench.log
+# 用法: bench-run-linux.sh [等待的秒数]
+#
+WAIT_SECS=${1:-60}
+LOG_FILE=bench.log
+
+rm -f $LOG_FILE
+
+# 模拟按键输入命令
+send_keys() {
+    for key in "$@"; do
+        echo "sendkey $key"
+        sleep 0.1
+    done
+}
+
+{
+    # 等待系统启动到shell
+    sleep 5
+    send_keys slash b e n c h dot e l f ret
+    sleep $WAIT_SECS
+    echo "quit"
+} | qemu-system-i386 -m 128M -display none -serial file:$LOG_FILE -monitor stdio -drive file=disk1.img,index=0,media=disk,format=raw -drive file=disk2.img,index=1,media=disk,format=raw > /dev/null
+
+if ! grep -q "^BENCH done" $LOG_FILE; then
+    echo "error: benchmark not finished, try a longer wait time"
+    grep "^BENCH" $LOG_FILE
+    exit -1
+fi
+
+grep "^BENCH" $LOG_FILE | grep -v -E "^BENCH (start|done) "
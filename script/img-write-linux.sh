@@ -31,6 +31,9 @@ dd if=kernel.elf of=$DISK1_NAME bs=512 conv=notrunc seek=100
 # dd if=init.elf of=$DISK1_NAME bs=512 conv=notrunc seek=5000
 dd if=shell.elf of=$DISK1_NAME bs=512 conv=notrunc seek=5000
 
+# 写基准测试程序，临时使用，在shell中输入/bench.elf运行
+dd if=bench.elf of=$DISK1_NAME bs=512 conv=notrunc seek=5200
+
 # 写应用程序，使用系统的挂载命令
 # export DISK2_NAME=disk2.img
 # export TARGET_PATH=mp
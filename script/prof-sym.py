@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+#
+# 将shell中prof命令的输出符号化，在主机上运行
+# 用法: prof-sym.py <kernel_elf.txt> [应用的xxx_elf.txt] < prof输出
+# xxx_elf.txt为构建时readelf -a生成的文件，位于build/source/kernel、build/source/shell等目录下
+# 标记为k的地址按内核符号查找，标记为u的地址按应用的符号查找
+#
+import re
+import sys
+import bisect
+
+def load_symbols(path):
+    # readelf的符号表行: Num: Value Size Type Bind Vis Ndx Name
+    syms = []
+    pattern = re.compile(r'^\s*\d+:\s+([0-9a-f]+)\s+(\d+)\s+(FUNC|NOTYPE)\s+\S+\s+\S+\s+(\d+)\s+(\S+)')
+    with open(path) as f:
+        for line in f:
+            m = pattern.match(line)
+            if m:
+                syms.append((int(m.group(1), 16), int(m.group(2)), m.group(5)))
+    syms.sort()
+    return syms
+
+def lookup(syms, addrs, addr):
+    i = bisect.bisect_right(addrs, addr) - 1
+    if i < 0:
+        return None
+    value, size, name = syms[i]
+    if size and (addr >= value + size):
+        return None
+    return '%s+0x%x' % (name, addr - value)
+
+def main():
+    if len(sys.argv) < 2:
+        print('usage: %s kernel_elf.txt [app_elf.txt] < prof.txt' % sys.argv[0], file=sys.stderr)
+        return 1
+
+    kernel = load_symbols(sys.argv[1])
+    user = []
+    for path in sys.argv[2:]:
+        user += load_symbols(path)
+    user.sort()
+    tables = {'k': (kernel, [s[0] for s in kernel]), 'u': (user, [s[0] for s in user])}
+
+    addr_pattern = re.compile(r'([ku]) 0x([0-9a-f]{8})')
+    for line in sys.stdin:
+        line = line.rstrip('\n')
+        m = addr_pattern.search(line)
+        if m:
+            syms, addrs = tables[m.group(1)]
+            name = lookup(syms, addrs, int(m.group(2), 16))
+            if name:
+                line += '  ' + name
+        print(line)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
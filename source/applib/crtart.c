@@ -19,5 +19,8 @@ void cstart (int argc, char ** argv) {
         *start++ = 0;
     }
 
+    // 主线程的线程局部存储，之后才能使用pthread及malloc
+    pthread_main_init();
+
     exit(main(argc, argv));
 }
\ No newline at end of file
@@ -4,11 +4,15 @@
 #include "core/syscall.h"
 #include "os_cfg.h"
 #include "lib_syscall.h"
+#include "dev/time.h"
+#include <errno.h>
+
+static int syscall_mode;        // 0-未检测，1-调用门，2-sysenter
 
 /**
- * 执行系统调用
+ * 通过调用门执行系统调用
  */
-static inline int sys_call (syscall_args_t * args) {
+static int sys_call_gate (syscall_args_t * args) {
     // 一个门描述符由8个字节组成，一个long为4字节，两个long填充一个门描述符
     const unsigned long sys_gate_addr[] = {0, SELECTOR_SYSCALL | 0};  // 使用特权级0
     int ret;
@@ -30,6 +34,55 @@ static inline int sys_call (syscall_args_t * args) {
     return ret;
 }
 
+/**
+ * 通过sysenter执行系统调用，参数全部经寄存器传递，省去了调用门的描述符检查和参数复制
+ * eax为调用号，ebx/esi/edi/ebp为参数；ecx/edx告诉内核返回时的栈和地址
+ */
+static int sys_call_fast (syscall_args_t * args) {
+    int ret;
+    int arg3 = args->arg3;
+
+    // ebp可能被用作帧指针，先保存，再用于传递arg3
+    __asm__ __volatile__(
+            "push %%ebp\n\t"
+            "mov %%ecx, %%ebp\n\t"
+            "mov %%esp, %%ecx\n\t"
+            "lea 1f, %%edx\n\t"
+            "sysenter\n\t"
+            "1: pop %%ebp\n\t"
+            :"=a"(ret), "+c"(arg3)
+            :"0"(args->id), "b"(args->arg0), "S"(args->arg1), "D"(args->arg2)
+            :"edx", "memory");
+    return ret;
+}
+
+/**
+ * 选择系统调用的方式，返回原来的设置。enable为-1时只查询
+ * CPU不支持sysenter时总是使用调用门
+ */
+int syscall_set_fast (int enable) {
+    if (syscall_mode == 0) {
+        syscall_mode = syscall_sysenter_supported() ? 2 : 1;
+    }
+
+    int old = (syscall_mode == 2);
+    if ((enable >= 0) && syscall_sysenter_supported()) {
+        syscall_mode = enable ? 2 : 1;
+    }
+    return old;
+}
+
+/**
+ * 执行系统调用，优先使用sysenter，调用门保留作为兼容
+ */
+static inline int sys_call (syscall_args_t * args) {
+    if (syscall_mode == 0) {
+        syscall_set_fast(-1);
+    }
+
+    return (syscall_mode == 2) ? sys_call_fast(args) : sys_call_gate(args);
+}
+
 int msleep (int ms) {
     if (ms <= 0) {
         return 0;
@@ -41,6 +94,142 @@ int msleep (int ms) {
     return sys_call(&args);
 }
 
+/**
+ * TSC的频率，单位KHz，没有TSC时为0。用于将周期数换算为时间
+ */
+unsigned clock_tsc_khz (void) {
+    const volatile time_page_t * page = (const volatile time_page_t *)TIME_PAGE_ADDR;
+    return page->tsc_khz;
+}
+
+/**
+ * 64位除以32位，用于将周期数、ns换算为较大的单位，结果只保留低32位
+ * 应用不链接libgcc，不能直接使用64位除法。先对高32位取余，保证divl不溢出
+ */
+uint32_t div64 (uint64_t n, uint32_t d) {
+    uint32_t hi = (uint32_t)(n >> 32) % d, lo = (uint32_t)n, q;
+
+    __asm__ __volatile__("divl %[d]" : "=a"(q), "+d"(hi) : "a"(lo), [d]"rm"(d));
+    return q;
+}
+
+/**
+ * 获取时间，直接读取内核映射的时间页，不需要进行系统调用
+ */
+int clock_gettime (clockid_t clock_id, struct timespec *tp) {
+    const volatile time_page_t * page = (const volatile time_page_t *)TIME_PAGE_ADDR;
+
+    if (!tp) {
+        return -1;
+    }
+
+    time_spec_t ts;
+    switch (clock_id) {
+    case CLOCK_REALTIME:
+        time_page_read(page, &ts);
+        ts.sec += page->real_sec;
+        break;
+    case CLOCK_MONOTONIC:
+    case CLOCK_MONOTONIC_RAW:
+        time_page_read(page, &ts);
+        break;
+    default:
+        return -1;
+    }
+
+    tp->tv_sec = ts.sec;
+    tp->tv_nsec = ts.nsec;
+    return 0;
+}
+
+int gettimeofday (struct timeval * tv, void * tz) {
+    struct timespec ts;
+
+    if (tv) {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        tv->tv_sec = ts.tv_sec;
+        tv->tv_usec = ts.tv_nsec / 1000;
+    }
+    return 0;
+}
+
+int _gettimeofday (struct timeval * tv, void * tz) {
+    return gettimeofday(tv, tz);
+}
+
+int nanosleep (const struct timespec * req, struct timespec * rem) {
+    syscall_args_t args;
+    args.id = SYS_nanosleep;
+    args.arg0 = (int)req;
+    args.arg1 = (int)rem;
+    return sys_call(&args);
+}
+
+/**
+ * tick数转换为clock_t的单位
+ */
+static inline clock_t ticks_to_clock (uint32_t ticks) {
+    return (clock_t)(ticks * (OS_TICK_MS * CLOCKS_PER_SEC / 1000));
+}
+
+/**
+ * tick数转换为timeval
+ */
+static inline void ticks_to_timeval (uint32_t ticks, struct timeval * tv) {
+    uint32_t ms = ticks * OS_TICK_MS;
+    tv->tv_sec = ms / 1000;
+    tv->tv_usec = (ms % 1000) * 1000;
+}
+
+clock_t times (struct tms * buf) {
+    task_times_t t;
+
+    syscall_args_t args;
+    args.id = SYS_times;
+    args.arg0 = (int)&t;
+    uint32_t ticks = (uint32_t)sys_call(&args);
+
+    if (buf) {
+        buf->tms_utime = ticks_to_clock(t.utime);
+        buf->tms_stime = ticks_to_clock(t.stime);
+        buf->tms_cutime = ticks_to_clock(t.cutime);
+        buf->tms_cstime = ticks_to_clock(t.cstime);
+    }
+    return ticks_to_clock(ticks);
+}
+
+/**
+ * 获取完整的统计，包括切换和异常次数
+ */
+int task_getrusage (int who, task_usage_t * usage) {
+    syscall_args_t args;
+    args.id = SYS_getrusage;
+    args.arg0 = who;
+    args.arg1 = (int)usage;
+    return sys_call(&args);
+}
+
+int getrusage (int who, struct rusage * usage) {
+    task_usage_t u;
+
+    int err = task_getrusage(who, &u);
+    if (err < 0) {
+        return err;
+    }
+
+    ticks_to_timeval(u.utime, &usage->ru_utime);
+    ticks_to_timeval(u.stime, &usage->ru_stime);
+    return 0;
+}
+
+int task_info (task_info_t * info, int count) {
+    syscall_args_t args;
+    args.id = SYS_task_info;
+    args.arg0 = (int)info;
+    args.arg1 = count;
+    return sys_call(&args);
+}
+
 int getpid() {
     syscall_args_t args;
     args.id = SYS_getpid;
@@ -61,6 +250,41 @@ int fork() {
     return sys_call(&args);
 }
 
+/**
+ * 直接从文件创建子进程，不复制当前进程的地址空间
+ * 暂不支持文件操作和属性，env也不会传给子进程
+ */
+int posix_spawn (pid_t * pid, const char * path, const posix_spawn_file_actions_t * file_actions,
+        const posix_spawnattr_t * attrp, char * const argv[], char * const envp[]) {
+    if (file_actions || attrp) {
+        return ENOTSUP;
+    }
+
+    syscall_args_t args;
+    args.id = SYS_spawn;
+    args.arg0 = (int)path;
+    args.arg1 = (int)argv;
+    args.arg2 = (int)envp;
+    int ret = sys_call(&args);
+    if (ret < 0) {
+        // 内核不区分失败原因，多数情况下是文件无法加载
+        return ENOENT;
+    }
+
+    if (pid) {
+        *pid = ret;
+    }
+    return 0;
+}
+
+/**
+ * 没有PATH环境变量，与posix_spawn相同
+ */
+int posix_spawnp (pid_t * pid, const char * file, const posix_spawn_file_actions_t * file_actions,
+        const posix_spawnattr_t * attrp, char * const argv[], char * const envp[]) {
+    return posix_spawn(pid, file, file_actions, attrp, argv, envp);
+}
+
 int execve(const char *name, char * const *argv, char * const *env) {
     syscall_args_t args;
     args.id = SYS_execve;
@@ -70,6 +294,148 @@ int execve(const char *name, char * const *argv, char * const *env) {
     return sys_call(&args);
 }
 
+int futex (int * uaddr, int op, int val) {
+    syscall_args_t args;
+    args.id = SYS_futex;
+    args.arg0 = (int)uaddr;
+    args.arg1 = op;
+    args.arg2 = val;
+    return sys_call(&args);
+}
+
+/**
+ * 创建共用地址空间的线程，从entry开始在栈stack上运行
+ */
+int clone (void * entry, void * stack, void * tls, int * clear_tid) {
+    syscall_args_t args;
+    args.id = SYS_clone;
+    args.arg0 = (int)entry;
+    args.arg1 = (int)stack;
+    args.arg2 = (int)tls;
+    args.arg3 = (int)clear_tid;
+    return sys_call(&args);
+}
+
+/**
+ * 设置当前线程的线程局部存储，之后可通过gs访问
+ */
+int set_tls (void * base) {
+    syscall_args_t args;
+    args.id = SYS_set_tls;
+    args.arg0 = (int)base;
+    return sys_call(&args);
+}
+
+/**
+ * 互斥锁，state为0表示未锁定，1表示已锁定，2表示已锁定且可能有等待者
+ * 没有竞争时只需一次原子操作，不进入内核
+ */
+void umutex_init (umutex_t * mutex) {
+    mutex->state = 0;
+}
+
+int umutex_trylock (umutex_t * mutex) {
+    int expected = 0;
+    return __atomic_compare_exchange_n(&mutex->state, &expected, 1, 0,
+                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ? 0 : -1;
+}
+
+void umutex_lock (umutex_t * mutex) {
+    int c = 0;
+    if (__atomic_compare_exchange_n(&mutex->state, &c, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    // 有竞争，标记为有等待者后睡眠，醒来后继续以有等待者的状态抢锁
+    if (c != 2) {
+        c = __atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE);
+    }
+    while (c != 0) {
+        futex(&mutex->state, FUTEX_WAIT, 2);
+        c = __atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+void umutex_unlock (umutex_t * mutex) {
+    // 原来是1说明没有等待者，否则需要唤醒一个
+    if (__atomic_fetch_sub(&mutex->state, 1, __ATOMIC_RELEASE) != 1) {
+        __atomic_store_n(&mutex->state, 0, __ATOMIC_RELEASE);
+        futex(&mutex->state, FUTEX_WAKE, 1);
+    }
+}
+
+/**
+ * 条件变量，每次通知时序号加1，等待者在序号未变时睡眠
+ */
+void ucond_init (ucond_t * cond) {
+    cond->seq = 0;
+}
+
+void ucond_wait (ucond_t * cond, umutex_t * mutex) {
+    int seq = __atomic_load_n(&cond->seq, __ATOMIC_ACQUIRE);
+
+    umutex_unlock(mutex);
+    futex(&cond->seq, FUTEX_WAIT, seq);
+
+    // 被唤醒时可能还有其它等待者，按有竞争的方式加锁
+    while (__atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE) != 0) {
+        futex(&mutex->state, FUTEX_WAIT, 2);
+    }
+}
+
+void ucond_signal (ucond_t * cond) {
+    __atomic_fetch_add(&cond->seq, 1, __ATOMIC_RELEASE);
+    futex(&cond->seq, FUTEX_WAKE, 1);
+}
+
+void ucond_broadcast (ucond_t * cond) {
+    __atomic_fetch_add(&cond->seq, 1, __ATOMIC_RELEASE);
+    futex(&cond->seq, FUTEX_WAKE, 0x7FFFFFFF);
+}
+
+/**
+ * 设置任务的调度策略，pid为0时为当前任务
+ */
+int sched_setattr (int pid, const task_sched_attr_t * attr) {
+    syscall_args_t args;
+    args.id = SYS_sched_setattr;
+    args.arg0 = pid;
+    args.arg1 = (int)attr;
+    return sys_call(&args);
+}
+
+int sched_getattr (int pid, task_sched_attr_t * attr) {
+    syscall_args_t args;
+    args.id = SYS_sched_getattr;
+    args.arg0 = pid;
+    args.arg1 = (int)attr;
+    return sys_call(&args);
+}
+
+uring_t * uring_setup (void) {
+    syscall_args_t args;
+    args.id = SYS_uring_setup;
+    int ret = sys_call(&args);
+    return (ret == -1) ? (uring_t *)0 : (uring_t *)ret;
+}
+
+int uring_enter (int to_submit) {
+    syscall_args_t args;
+    args.id = SYS_uring_enter;
+    args.arg0 = to_submit;
+    return sys_call(&args);
+}
+
+int profil (unsigned short * buf, size_t bufsiz, size_t offset, unsigned int scale) {
+    syscall_args_t args;
+    args.id = SYS_profil;
+    args.arg0 = (int)buf;
+    args.arg1 = bufsiz;
+    args.arg2 = offset;
+    args.arg3 = scale;
+    return sys_call(&args);
+}
+
 int yield (void) {
     syscall_args_t args;
     args.id = SYS_yield;
@@ -83,6 +449,15 @@ int wait(int* status) {
     return sys_call(&args);
 }
 
+int waitpid(int pid, int * status, int options) {
+    syscall_args_t args;
+    args.id = SYS_waitpid;
+    args.arg0 = pid;
+    args.arg1 = (int)status;
+    args.arg2 = options;
+    return sys_call(&args);
+}
+
 void _exit(int status) {
     syscall_args_t args;
     args.id = SYS_exit;
@@ -100,7 +475,7 @@ int open(const char *name, int flags, ...) {
     return sys_call(&args);
 }
 
-int read(int file, char *ptr, int len) {
+ssize_t read(int file, void *ptr, size_t len) {
     syscall_args_t args;
     args.id = SYS_read;
     args.arg0 = (int)file;
@@ -109,7 +484,7 @@ int read(int file, char *ptr, int len) {
     return sys_call(&args);
 }
 
-int write(int file, char *ptr, int len) {
+ssize_t write(int file, const void *ptr, size_t len) {
     syscall_args_t args;
     args.id = SYS_write;
     args.arg0 = (int)file;
@@ -125,7 +500,7 @@ int close(int file) {
     return sys_call(&args);
 }
 
-int lseek(int file, int ptr, int dir) {
+off_t lseek(int file, off_t ptr, int dir) {
     syscall_args_t args;
     args.id = SYS_lseek;
     args.arg0 = (int)file;
@@ -6,8 +6,49 @@
 
 #include "core/syscall.h"
 #include "os_cfg.h"
+#include "core/task_info.h"
+#include "core/task_sched.h"
+#include "core/uring.h"
+#include "core/syscall_stat.h"
+#include "core/prof.h"
+#include "core/trace.h"
+#include "ipc/futex.h"
+#include "ipc/lock_stat.h"
+#include "cpu/irqlat.h"
+#include "core/boottime.h"
+#include "core/schedstat.h"
 
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/times.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <spawn.h>
+#include <sched.h>
+#include <time.h>
+
+// newlib仅在部分平台上定义了这些时钟
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC         ((clockid_t) 4)
+#endif
+
+#ifndef CLOCK_MONOTONIC_RAW
+#define CLOCK_MONOTONIC_RAW     ((clockid_t) 5)
+#endif
+
+/**
+ * 基于futex的互斥锁，无竞争时不进入内核
+ */
+typedef struct _umutex_t {
+    int state;
+}umutex_t;
+
+/**
+ * 基于futex的条件变量
+ */
+typedef struct _ucond_t {
+    int seq;
+}ucond_t;
 
 typedef struct _syscall_args_t {
     int id;
@@ -17,20 +58,59 @@ typedef struct _syscall_args_t {
     int arg3;
 }syscall_args_t;
 
+int syscall_set_fast (int enable);
+
 int msleep (int ms);
 int fork(void);
+int vfork(void);
 int getpid(void);
 int yield (void);
 int execve(const char *name, char * const *argv, char * const *env);
 int print_msg(char * fmt, int arg);
 int wait(int* status);
+int waitpid(int pid, int * status, int options);
+
+int futex (int * uaddr, int op, int val);
+int clone (void * entry, void * stack, void * tls, int * clear_tid);
+int set_tls (void * base);
+void pthread_main_init (void);
+void umutex_init (umutex_t * mutex);
+int umutex_trylock (umutex_t * mutex);
+void umutex_lock (umutex_t * mutex);
+void umutex_unlock (umutex_t * mutex);
+void ucond_init (ucond_t * cond);
+void ucond_wait (ucond_t * cond, umutex_t * mutex);
+void ucond_signal (ucond_t * cond);
+void ucond_broadcast (ucond_t * cond);
 void _exit(int status);
 
+int clock_gettime (clockid_t clock_id, struct timespec *tp);
+int gettimeofday (struct timeval * tv, void * tz);
+int nanosleep (const struct timespec * req, struct timespec * rem);
+
+clock_t times (struct tms * buf);
+int getrusage (int who, struct rusage * usage);
+int task_getrusage (int who, task_usage_t * usage);
+int task_info (task_info_t * info, int count);
+
+int sched_setattr (int pid, const task_sched_attr_t * attr);
+int sched_getattr (int pid, task_sched_attr_t * attr);
+uring_t * uring_setup (void);
+int uring_enter (int to_submit);
+int profil (unsigned short * buf, size_t bufsiz, size_t offset, unsigned int scale);
+void profil_dump (const unsigned short * buf, size_t bufsiz, size_t offset, unsigned int scale, int top);
+unsigned clock_tsc_khz (void);
+uint32_t div64 (uint64_t n, uint32_t d);
+int sched_setscheduler (pid_t pid, int policy, const struct sched_param * param);
+int sched_getscheduler (pid_t pid);
+int sched_get_priority_max (int policy);
+int sched_get_priority_min (int policy);
+
 int open(const char *name, int flags, ...);
-int read(int file, char *ptr, int len);
-int write(int file, char *ptr, int len);
+ssize_t read(int file, void *ptr, size_t len);
+ssize_t write(int file, const void *ptr, size_t len);
 int close(int file);
-int lseek(int file, int ptr, int dir);
+off_t lseek(int file, off_t ptr, int dir);
 int isatty(int file);
 int fstat(int file, struct stat *st);
 void * sbrk(ptrdiff_t incr);
@@ -0,0 +1,60 @@
+/**
+ * profil直方图的输出
+ * 与lib_syscall.c分开，因为其中用到了newlib的printf，而lib_syscall.c也会链接进内核
+ */
+#include "lib_syscall.h"
+#include <stdio.h>
+
+#define PROFIL_TOP_MAX          32          // 最多输出的计数项
+
+/**
+ * @brief 第index个计数对应的起始代码地址，即profil中地址到下标换算的逆运算
+ * scale不超过0x10000，不需要64位除法
+ */
+static uint32_t profil_addr (uint32_t index, size_t offset, unsigned int scale) {
+    uint32_t units = (index / scale << 16) + (((index % scale) << 16) + scale - 1) / scale;
+    return offset + units * 2;
+}
+
+/**
+ * @brief 按计数从多到少输出最多top项，地址可用script/prof-sym.py符号化
+ */
+void profil_dump (const unsigned short * buf, size_t bufsiz, size_t offset, unsigned int scale, int top) {
+    uint32_t index[PROFIL_TOP_MAX];
+    int count = 0;
+
+    if (top > PROFIL_TOP_MAX) {
+        top = PROFIL_TOP_MAX;
+    }
+
+    // 插入排序保留计数最多的top项
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < bufsiz / sizeof(unsigned short); i++) {
+        if (!buf[i]) {
+            continue;
+        }
+        total += buf[i];
+
+        int pos = count;
+        while ((pos > 0) && (buf[index[pos - 1]] < buf[i])) {
+            if (pos < top) {
+                index[pos] = index[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < top) {
+            index[pos] = i;
+            if (count < top) {
+                count++;
+            }
+        }
+    }
+
+    printf("profil: %u samples\n", (unsigned)total);
+    printf("%8s %6s  %s\n", "count", "pct", "address");
+    for (int i = 0; i < count; i++) {
+        unsigned short n = buf[index[i]];
+        printf("%8u %5u%%  u 0x%08x\n", n, (unsigned)(n * 100 / total),
+                (unsigned)profil_addr(index[i], offset, scale));
+    }
+}
@@ -0,0 +1,420 @@
+/**
+ * POSIX线程
+ * 线程由内核的clone创建，与进程共用地址空间和打开的文件。每个线程有一个控制块，
+ * 同时作为线程局部存储，gs段以控制块为起始地址，%gs:0中即为控制块自身的地址。
+ * 互斥锁和条件变量基于futex实现，没有竞争时不进入内核。
+ */
+#include "lib_syscall.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <reent.h>
+
+#define PTHREAD_STACK_DEFAULT       (64 * 1024)     // 默认的线程栈大小
+#define PTHREAD_STACK_MINSIZE       (4 * 1024)      // 最小的线程栈大小
+#define PTHREAD_KEY_NR              32              // 线程私有数据键的数量
+#define PTHREAD_MUTEX_STATIC        0xFFFFFFFF      // 静态初始化的值，首次使用时再初始化
+
+/**
+ * 线程控制块
+ */
+typedef struct _pthread_tcb_t {
+    struct _pthread_tcb_t * self;       // 必须在最前，pthread_self通过%gs:0读取
+    void * (*start)(void *);            // 线程入口及参数
+    void * arg;
+    void * result;                      // 线程的返回值
+    volatile int tid;                   // 运行中为非0，线程退出后由内核清0并唤醒等待者
+    int pid;                            // 内核中任务的pid
+    int detached;                       // 已分离，退出后自动回收
+    int exiting;                        // 已调用pthread_exit
+    void * mem;                         // 栈及控制块所在的内存，主线程为0
+    struct _pthread_tcb_t * next;       // 已分离、等待回收的线程队列
+    const void * specific[PTHREAD_KEY_NR];  // 线程私有数据
+}pthread_tcb_t;
+
+static pthread_tcb_t main_tcb;          // 主线程的控制块
+static umutex_t thread_mutex;           // 保护以下的数据
+static umutex_t once_mutex;             // pthread_once的初始化过程互斥执行
+static pthread_tcb_t * dead_list;       // 已分离的线程退出后，由后续创建线程时回收
+static struct {
+    int used;
+    void (*destructor)(void *);
+}key_table[PTHREAD_KEY_NR];
+
+// newlib的malloc不可重入，多线程使用时要加锁，同一线程可能重复进入
+static umutex_t malloc_mutex;
+static pthread_tcb_t * malloc_owner;
+static int malloc_count;
+
+/**
+ * @brief 获取当前线程的控制块
+ */
+static inline pthread_tcb_t * tcb_self (void) {
+    pthread_tcb_t * self;
+    __asm__ __volatile__("movl %%gs:0, %0" : "=r"(self));
+    return self;
+}
+
+/**
+ * @brief 主线程的初始化，在进入main之前调用
+ */
+void pthread_main_init (void) {
+    main_tcb.self = &main_tcb;
+    main_tcb.tid = 1;
+    main_tcb.pid = getpid();
+    set_tls(&main_tcb);
+}
+
+/**
+ * @brief 回收已退出的分离线程，调用前需持有thread_mutex
+ */
+static void reap_dead_threads (void) {
+    pthread_tcb_t ** pp = &dead_list;
+    while (*pp) {
+        pthread_tcb_t * tcb = *pp;
+        if (tcb->tid == 0) {
+            *pp = tcb->next;
+            free(tcb->mem);
+        } else {
+            pp = &tcb->next;
+        }
+    }
+}
+
+/**
+ * @brief 新线程的入口，由内核从新栈上进入，参数为控制块
+ */
+static void pthread_start (pthread_tcb_t * tcb) {
+    pthread_exit(tcb->start(tcb->arg));
+}
+
+int pthread_attr_init (pthread_attr_t * attr) {
+    memset(attr, 0, sizeof(pthread_attr_t));
+    attr->is_initialized = 1;
+    attr->stacksize = PTHREAD_STACK_DEFAULT;
+    attr->detachstate = PTHREAD_CREATE_JOINABLE;
+    return 0;
+}
+
+int pthread_attr_destroy (pthread_attr_t * attr) {
+    attr->is_initialized = 0;
+    return 0;
+}
+
+int pthread_attr_setstacksize (pthread_attr_t * attr, size_t stacksize) {
+    if (stacksize < PTHREAD_STACK_MINSIZE) {
+        return EINVAL;
+    }
+    attr->stacksize = stacksize;
+    return 0;
+}
+
+int pthread_attr_getstacksize (const pthread_attr_t * attr, size_t * stacksize) {
+    *stacksize = attr->stacksize;
+    return 0;
+}
+
+int pthread_attr_setstack (pthread_attr_t * attr, void * stackaddr, size_t stacksize) {
+    if (stacksize < PTHREAD_STACK_MINSIZE) {
+        return EINVAL;
+    }
+    attr->stackaddr = stackaddr;
+    attr->stacksize = stacksize;
+    return 0;
+}
+
+int pthread_attr_getstack (const pthread_attr_t * attr, void ** stackaddr, size_t * stacksize) {
+    *stackaddr = attr->stackaddr;
+    *stacksize = attr->stacksize;
+    return 0;
+}
+
+int pthread_attr_setdetachstate (pthread_attr_t * attr, int detachstate) {
+    if ((detachstate != PTHREAD_CREATE_JOINABLE) && (detachstate != PTHREAD_CREATE_DETACHED)) {
+        return EINVAL;
+    }
+    attr->detachstate = detachstate;
+    return 0;
+}
+
+int pthread_attr_getdetachstate (const pthread_attr_t * attr, int * detachstate) {
+    *detachstate = attr->detachstate;
+    return 0;
+}
+
+/**
+ * @brief 创建线程
+ * 栈和控制块在同一块内存中分配，控制块放在栈顶之上；指定了栈时只分配控制块
+ */
+int pthread_create (pthread_t * thread, const pthread_attr_t * attr,
+                    void * (*start_routine)(void *), void * arg) {
+    umutex_lock(&thread_mutex);
+    reap_dead_threads();
+    umutex_unlock(&thread_mutex);
+
+    size_t stack_size = (attr && attr->stacksize) ? attr->stacksize : PTHREAD_STACK_DEFAULT;
+    void * stack_addr = attr ? attr->stackaddr : (void *)0;
+
+    uint8_t * mem;
+    pthread_tcb_t * tcb;
+    uint32_t stack_top;
+    if (stack_addr) {
+        mem = (uint8_t *)malloc(sizeof(pthread_tcb_t));
+        tcb = (pthread_tcb_t *)mem;
+        stack_top = ((uint32_t)stack_addr + stack_size) & ~0xF;
+    } else {
+        mem = (uint8_t *)malloc(stack_size + sizeof(pthread_tcb_t) + 16);
+        tcb = (pthread_tcb_t *)(((uint32_t)mem + stack_size + 15) & ~0xF);
+        stack_top = (uint32_t)tcb;
+    }
+    if (mem == (uint8_t *)0) {
+        return EAGAIN;
+    }
+
+    memset(tcb, 0, sizeof(pthread_tcb_t));
+    tcb->self = tcb;
+    tcb->start = start_routine;
+    tcb->arg = arg;
+    tcb->mem = mem;
+    tcb->tid = 1;
+    tcb->detached = attr && (attr->detachstate == PTHREAD_CREATE_DETACHED);
+
+    // 模拟一次函数调用：参数为控制块，返回地址为0
+    uint32_t * sp = (uint32_t *)stack_top - 2;
+    sp[0] = 0;
+    sp[1] = (uint32_t)tcb;
+
+    int pid = clone((void *)pthread_start, sp, tcb, (int *)&tcb->tid);
+    if (pid < 0) {
+        free(mem);
+        return EAGAIN;
+    }
+
+    tcb->pid = pid;
+    *thread = (pthread_t)tcb;
+    return 0;
+}
+
+/**
+ * @brief 当前线程退出
+ * 主线程退出时只结束自身，其它线程继续运行
+ */
+void pthread_exit (void * value_ptr) {
+    pthread_tcb_t * self = tcb_self();
+    self->result = value_ptr;
+
+    // 调用各私有数据的析构函数
+    for (int i = 0; i < PTHREAD_KEY_NR; i++) {
+        void * value = (void *)self->specific[i];
+        if (value && key_table[i].used && key_table[i].destructor) {
+            self->specific[i] = (void *)0;
+            key_table[i].destructor(value);
+        }
+    }
+
+    // 已分离的线程交给其它线程回收，栈在退出前仍要使用
+    umutex_lock(&thread_mutex);
+    self->exiting = 1;
+    if (self->detached && self->mem) {
+        self->next = dead_list;
+        dead_list = self;
+    }
+    umutex_unlock(&thread_mutex);
+
+    _exit(0);
+    for (;;) {}
+}
+
+/**
+ * @brief 等待线程退出，并回收其资源
+ */
+int pthread_join (pthread_t thread, void ** value_ptr) {
+    pthread_tcb_t * tcb = (pthread_tcb_t *)thread;
+    if (tcb == tcb_self()) {
+        return EDEADLK;
+    }
+    if (tcb->detached || (tcb->mem == (void *)0)) {
+        return EINVAL;
+    }
+
+    for (;;) {
+        int tid = tcb->tid;
+        if (tid == 0) {
+            break;
+        }
+        futex((int *)&tcb->tid, FUTEX_WAIT, tid);
+    }
+
+    if (value_ptr) {
+        *value_ptr = tcb->result;
+    }
+    free(tcb->mem);
+    return 0;
+}
+
+/**
+ * @brief 分离线程，线程退出后自动回收
+ */
+int pthread_detach (pthread_t thread) {
+    pthread_tcb_t * tcb = (pthread_tcb_t *)thread;
+
+    umutex_lock(&thread_mutex);
+    if (tcb->detached) {
+        umutex_unlock(&thread_mutex);
+        return EINVAL;
+    }
+
+    tcb->detached = 1;
+    if (tcb->exiting && tcb->mem) {
+        tcb->next = dead_list;
+        dead_list = tcb;
+    }
+    umutex_unlock(&thread_mutex);
+    return 0;
+}
+
+pthread_t pthread_self (void) {
+    return (pthread_t)tcb_self();
+}
+
+int pthread_equal (pthread_t t1, pthread_t t2) {
+    return t1 == t2;
+}
+
+/**
+ * @brief 获取互斥锁，静态初始化的在首次使用时初始化
+ */
+static umutex_t * mutex_get (pthread_mutex_t * mutex) {
+    pthread_mutex_t expected = PTHREAD_MUTEX_STATIC;
+    __atomic_compare_exchange_n(mutex, &expected, 0, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    return (umutex_t *)mutex;
+}
+
+int pthread_mutex_init (pthread_mutex_t * mutex, const pthread_mutexattr_t * attr) {
+    umutex_init((umutex_t *)mutex);
+    return 0;
+}
+
+int pthread_mutex_destroy (pthread_mutex_t * mutex) {
+    return 0;
+}
+
+int pthread_mutex_lock (pthread_mutex_t * mutex) {
+    umutex_lock(mutex_get(mutex));
+    return 0;
+}
+
+int pthread_mutex_trylock (pthread_mutex_t * mutex) {
+    return (umutex_trylock(mutex_get(mutex)) == 0) ? 0 : EBUSY;
+}
+
+int pthread_mutex_unlock (pthread_mutex_t * mutex) {
+    umutex_unlock(mutex_get(mutex));
+    return 0;
+}
+
+/**
+ * 条件变量的值即为序号，静态初始化的值可直接作为初始序号
+ */
+int pthread_cond_init (pthread_cond_t * cond, const pthread_condattr_t * attr) {
+    ucond_init((ucond_t *)cond);
+    return 0;
+}
+
+int pthread_cond_destroy (pthread_cond_t * cond) {
+    return 0;
+}
+
+int pthread_cond_wait (pthread_cond_t * cond, pthread_mutex_t * mutex) {
+    ucond_wait((ucond_t *)cond, mutex_get(mutex));
+    return 0;
+}
+
+int pthread_cond_signal (pthread_cond_t * cond) {
+    ucond_signal((ucond_t *)cond);
+    return 0;
+}
+
+int pthread_cond_broadcast (pthread_cond_t * cond) {
+    ucond_broadcast((ucond_t *)cond);
+    return 0;
+}
+
+int pthread_key_create (pthread_key_t * key, void (*destructor)(void *)) {
+    umutex_lock(&thread_mutex);
+    for (int i = 0; i < PTHREAD_KEY_NR; i++) {
+        if (!key_table[i].used) {
+            key_table[i].used = 1;
+            key_table[i].destructor = destructor;
+            umutex_unlock(&thread_mutex);
+            *key = i;
+            return 0;
+        }
+    }
+    umutex_unlock(&thread_mutex);
+    return EAGAIN;
+}
+
+int pthread_key_delete (pthread_key_t key) {
+    if (key >= PTHREAD_KEY_NR) {
+        return EINVAL;
+    }
+
+    umutex_lock(&thread_mutex);
+    key_table[key].used = 0;
+    key_table[key].destructor = (void (*)(void *))0;
+    umutex_unlock(&thread_mutex);
+    return 0;
+}
+
+int pthread_setspecific (pthread_key_t key, const void * value) {
+    if (key >= PTHREAD_KEY_NR) {
+        return EINVAL;
+    }
+    tcb_self()->specific[key] = value;
+    return 0;
+}
+
+void * pthread_getspecific (pthread_key_t key) {
+    return (key < PTHREAD_KEY_NR) ? (void *)tcb_self()->specific[key] : (void *)0;
+}
+
+/**
+ * @brief 只执行一次初始化，执行期间其它线程等待
+ */
+int pthread_once (pthread_once_t * once_control, void (*init_routine)(void)) {
+    if (__atomic_load_n(&once_control->init_executed, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    umutex_lock(&once_mutex);
+    if (!once_control->init_executed) {
+        init_routine();
+        __atomic_store_n(&once_control->init_executed, 1, __ATOMIC_RELEASE);
+    }
+    umutex_unlock(&once_mutex);
+    return 0;
+}
+
+/**
+ * @brief newlib的malloc加锁，同一线程可重复进入
+ */
+void __malloc_lock (struct _reent * reent) {
+    pthread_tcb_t * self = tcb_self();
+    if (malloc_owner == self) {
+        malloc_count++;
+        return;
+    }
+
+    umutex_lock(&malloc_mutex);
+    malloc_owner = self;
+    malloc_count = 1;
+}
+
+void __malloc_unlock (struct _reent * reent) {
+    if (--malloc_count == 0) {
+        malloc_owner = (pthread_tcb_t *)0;
+        umutex_unlock(&malloc_mutex);
+    }
+}
@@ -0,0 +1,40 @@
+/**
+ * POSIX调度接口，基于sched_setattr实现
+ * 与lib_syscall.c分开，因为其中用到了newlib的errno，而lib_syscall.c也会链接进内核
+ */
+#include "lib_syscall.h"
+#include <errno.h>
+
+int sched_setscheduler (pid_t pid, int policy, const struct sched_param * param) {
+    if ((policy != SCHED_OTHER) && (policy != SCHED_FIFO)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    task_sched_attr_t attr;
+    attr.policy = policy;
+    attr.priority = param ? param->sched_priority : 0;
+    attr.runtime = attr.period = 0;
+    if (sched_setattr(pid, &attr) < 0) {
+        errno = EPERM;
+        return -1;
+    }
+    return 0;
+}
+
+int sched_getscheduler (pid_t pid) {
+    task_sched_attr_t attr;
+    if (sched_getattr(pid, &attr) < 0) {
+        errno = ESRCH;
+        return -1;
+    }
+    return attr.policy;
+}
+
+int sched_get_priority_max (int policy) {
+    return (policy == SCHED_FIFO) ? TASK_RT_PRIO_MAX : 0;
+}
+
+int sched_get_priority_min (int policy) {
+    return (policy == SCHED_FIFO) ? TASK_RT_PRIO_MIN : 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * 操作系统微基准测试
+ * 依次测量各项基本操作的耗时，每项结果输出一行"BENCH 名称 数值 单位"，便于脚本解析。
+ * 结果同时写到/dev/serial0，在QEMU中可用-serial file:xxx收集，见script/bench-run-linux.sh
+ */
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include "lib_syscall.h"
+
+#define BENCH_SYSCALL_COUNT         100000      // 空系统调用的次数
+#define BENCH_FORK_COUNT            100         // fork+wait的次数
+#define BENCH_EXEC_COUNT            10          // fork+exec+wait的次数，每次都要从磁盘读取程序
+#define BENCH_PINGPONG_COUNT        10000       // 线程间来回切换的轮数
+#define BENCH_SLEEP_COUNT           10          // 每种时长的msleep次数
+#define BENCH_SBRK_PAGES            256         // 扩展堆的页数
+#define BENCH_TTY_BYTES             (16 * 1024) // 写入tty的字节数
+#define BENCH_PAGE_SIZE             4096
+
+static int serial_fd = -1;
+
+/**
+ * 单调时钟，单位ns，读取共享时间页，不进入内核
+ */
+static uint64_t now_ns (void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * 输出一项结果
+ */
+static void report (const char * name, uint32_t value, const char * unit) {
+    char line[80];
+    int len = sprintf(line, "BENCH %s %u %s\n", name, (unsigned)value, unit);
+
+    fputs(line, stdout);
+    fflush(stdout);
+    if (serial_fd >= 0) {
+        write(serial_fd, line, len);
+    }
+}
+
+/**
+ * 空系统调用，分别测量调用门和sysenter
+ */
+static void bench_syscall (void) {
+    int fast = syscall_set_fast(-1);
+
+    for (int mode = 0; mode < 2; mode++) {
+        syscall_set_fast(mode);
+        if ((mode == 1) && !syscall_set_fast(-1)) {
+            // 不支持sysenter
+            break;
+        }
+
+        uint64_t start = now_ns();
+        for (int i = 0; i < BENCH_SYSCALL_COUNT; i++) {
+            getpid();
+        }
+        uint64_t ns = now_ns() - start;
+        report(mode ? "syscall_sysenter" : "syscall_gate", div64(ns, BENCH_SYSCALL_COUNT), "ns");
+    }
+
+    syscall_set_fast(fast);
+}
+
+/**
+ * fork后子进程立即退出，父进程等待
+ */
+static void bench_fork (void) {
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_FORK_COUNT; i++) {
+        int pid = fork();
+        if (pid < 0) {
+            fprintf(stderr, "bench: fork failed\n");
+            return;
+        } else if (pid == 0) {
+            _exit(0);
+        }
+
+        int status;
+        waitpid(pid, &status, 0);
+    }
+    uint64_t ns = now_ns() - start;
+    report("fork_wait", div64(ns, BENCH_FORK_COUNT * 1000), "us");
+}
+
+/**
+ * fork后子进程加载本程序并立即退出，父进程等待
+ */
+static void bench_exec (const char * path) {
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_EXEC_COUNT; i++) {
+        int pid = fork();
+        if (pid < 0) {
+            fprintf(stderr, "bench: fork failed\n");
+            return;
+        } else if (pid == 0) {
+            char * argv[] = {(char *)path, "-x", (char *)0};
+            execve(path, argv, (char **)0);
+            _exit(-1);
+        }
+
+        int status;
+        waitpid(pid, &status, 0);
+    }
+    uint64_t ns = now_ns() - start;
+    report("fork_exec_wait", div64(ns, BENCH_EXEC_COUNT * 1000), "us");
+}
+
+// 乒乓测试中轮到哪个线程，0为主线程
+static volatile int pp_turn;
+
+static void pp_wait (int me) {
+    while (pp_turn != me) {
+        futex((int *)&pp_turn, FUTEX_WAIT, !me);
+    }
+}
+
+static void pp_pass (int to) {
+    pp_turn = to;
+    futex((int *)&pp_turn, FUTEX_WAKE, 1);
+}
+
+static void * pp_entry (void * arg) {
+    for (int i = 0; i < BENCH_PINGPONG_COUNT; i++) {
+        pp_wait(1);
+        pp_pass(0);
+    }
+    return (void *)0;
+}
+
+/**
+ * 两个线程通过futex交替运行，每轮包含两次唤醒和切换
+ */
+static void bench_pingpong (void) {
+    pthread_t thread;
+
+    pp_turn = 0;
+    if (pthread_create(&thread, (const pthread_attr_t *)0, pp_entry, (void *)0)) {
+        fprintf(stderr, "bench: pthread_create failed\n");
+        return;
+    }
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_PINGPONG_COUNT; i++) {
+        pp_pass(1);
+        pp_wait(0);
+    }
+    uint64_t ns = now_ns() - start;
+    pthread_join(thread, (void **)0);
+    report("pingpong_switch", div64(ns, BENCH_PINGPONG_COUNT * 2), "ns");
+}
+
+/**
+ * msleep实际睡眠的平均和最长时间
+ */
+static void bench_msleep (void) {
+    static const int sleep_ms[] = {1, 10, 50};
+
+    for (int i = 0; i < sizeof(sleep_ms) / sizeof(sleep_ms[0]); i++) {
+        uint64_t total = 0, max = 0;
+        for (int j = 0; j < BENCH_SLEEP_COUNT; j++) {
+            uint64_t start = now_ns();
+            msleep(sleep_ms[i]);
+            uint64_t ns = now_ns() - start;
+
+            total += ns;
+            max = (ns > max) ? ns : max;
+        }
+
+        char name[32];
+        sprintf(name, "msleep_%d_avg", sleep_ms[i]);
+        report(name, div64(total, BENCH_SLEEP_COUNT * 1000), "us");
+        sprintf(name, "msleep_%d_max", sleep_ms[i]);
+        report(name, div64(max, 1000), "us");
+    }
+}
+
+/**
+ * 逐页扩展堆并写入，内核在sbrk时即分配物理页，不是缺页时分配
+ */
+static void bench_sbrk (void) {
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_SBRK_PAGES; i++) {
+        char * page = (char *)sbrk(BENCH_PAGE_SIZE);
+        if (page == (char *)-1) {
+            fprintf(stderr, "bench: sbrk failed\n");
+            return;
+        }
+        page[0] = 1;
+    }
+    uint64_t ns = now_ns() - start;
+    report("sbrk_page", div64(ns, BENCH_SBRK_PAGES), "ns");
+}
+
+/**
+ * 向标准输出写满屏的字符，包括显示及滚屏的开销
+ */
+static void bench_tty (void) {
+    char line[80];
+    memset(line, '#', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\n';
+
+    uint64_t start = now_ns();
+    for (int len = 0; len < BENCH_TTY_BYTES; len += sizeof(line)) {
+        write(1, line, sizeof(line));
+    }
+    uint64_t ns = now_ns() - start;
+
+    // 字节数/us*1000即KB/s，先把ns换成us，避免64位除法
+    uint32_t us = div64(ns, 1000);
+    report("tty_write", us ? (uint32_t)BENCH_TTY_BYTES * 1000 / us : 0, "KB/s");
+}
+
+int main (int argc, char ** argv) {
+    int ch;
+    while ((ch = getopt(argc, argv, "xh")) != -1) {
+        switch (ch) {
+            case 'x':
+                // 只用于fork+exec的测试
+                return 0;
+            case 'h':
+                puts("bench run OS microbenchmarks");
+                puts("Usage: bench [-x]");
+                puts("  -x  exit immediately, used by the exec test");
+                return 0;
+            default:
+                return -1;
+        }
+    }
+
+    serial_fd = open("/dev/serial0", O_RDWR);
+
+    report("start", 0, "-");
+    bench_syscall();
+    bench_fork();
+    bench_exec(argv[0]);
+    bench_pingpong();
+    bench_msleep();
+    bench_sbrk();
+    bench_tty();
+    report("done", 0, "-");
+
+    if (serial_fd >= 0) {
+        close(serial_fd);
+    }
+    return 0;
+}
@@ -4,10 +4,24 @@
 #ifndef BOOT_INFO_H
 #define BOOT_INFO_H
 
-#include "comm/types.h"
-
 #define BOOT_RAM_REGION_MAX			10		// RAM区最大数量
 
+// 启动各阶段的TSC时间戳，boot扇区没有空间处理boot_info，先放在固定地址，由loader取回
+// 0x500开始的低端内存未被BIOS使用，离栈底很远
+#define BOOT_TSC_ADDR				0x500
+
+// 由boot和loader记录的阶段，内核中的阶段见core/boottime.h
+#define BOOT_STAGE_BOOT				0		// boot扇区开始运行
+#define BOOT_STAGE_LOADER			1		// loader开始运行
+#define BOOT_STAGE_DETECT_MEM		2		// 内存检测完成
+#define BOOT_STAGE_PROTECT			3		// 进入保护模式，开始读内核
+#define BOOT_STAGE_READ_DISK		4		// 内核文件读取完成
+#define BOOT_STAGE_RELOAD_ELF		5		// ELF解析完成，即将进入内核
+#define BOOT_STAGE_EARLY_NR			6
+
+#ifndef __ASSEMBLER__
+#include "comm/types.h"
+
 /**
  * 启动信息参数
  */
@@ -18,9 +32,12 @@ typedef struct _boot_info_t {
         uint32_t size;
     }ram_region_cfg[BOOT_RAM_REGION_MAX];
     int ram_region_count;
+
+    uint64_t stage_tsc[BOOT_STAGE_EARLY_NR];	// 各阶段的TSC
 }boot_info_t;
 
 #define SECTOR_SIZE		512			// 磁盘扇区大小
 #define SYS_KERNEL_LOAD_ADDR		(1024*1024)		// 内核加载的起始地址
+#endif
 
 #endif // BOOT_INFO_H
@@ -44,6 +44,10 @@ static inline void lgdt(uint32_t start, uint32_t size) {
 	__asm__ __volatile__("lgdt %[g]"::[g]"m"(gdt));
 }
 
+static inline void sgdt (void * desc) {
+	__asm__ __volatile__("sgdt (%[d])"::[d]"r"(desc):"memory");
+}
+
 static inline uint32_t read_cr0() {
 	uint32_t cr0;
 	__asm__ __volatile__("mov %%cr0, %[v]":[v]"=r"(cr0));
@@ -111,6 +115,22 @@ static inline void write_tr (uint32_t tss_selector) {
     __asm__ __volatile__("ltr %%ax"::"a"(tss_selector));
 }
 
+static inline uint16_t read_tr (void) {
+    uint16_t tss_selector;
+    __asm__ __volatile__("str %[v]":[v]"=r"(tss_selector));
+    return tss_selector;
+}
+
+// 原子交换，用于实现自旋锁
+static inline uint32_t xchg (volatile uint32_t * addr, uint32_t v) {
+	__asm__ __volatile__("xchgl %[v], %[m]" : [v]"+r"(v), [m]"+m"(*addr) :: "memory");
+	return v;
+}
+
+static inline void pause (void) {
+	__asm__ __volatile__("pause");
+}
+
 static inline uint32_t read_eflags (void) {
     uint32_t eflags;
 
@@ -122,4 +142,52 @@ static inline void write_eflags (uint32_t eflags) {
     __asm__ __volatile__("pushl %%eax\n\tpopfl"::"a"(eflags));
 }
 
+// 读时间戳计数器
+static inline uint64_t rdtsc (void) {
+	uint32_t lo, hi;
+	__asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+static inline uint64_t rdmsr (uint32_t msr) {
+	uint32_t lo, hi;
+	__asm__ __volatile__("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void wrmsr (uint32_t msr, uint64_t v) {
+	__asm__ __volatile__("wrmsr" :: "c"(msr), "a"((uint32_t)v), "d"((uint32_t)(v >> 32)));
+}
+
+static inline void cpuid (uint32_t leaf, uint32_t * eax, uint32_t * ebx, uint32_t * ecx, uint32_t * edx) {
+	__asm__ __volatile__("cpuid"
+			: "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+			: "a"(leaf), "c"(0));
+}
+
+// 清除CR0.TS，允许使用FPU/SSE指令
+static inline void clts (void) {
+	__asm__ __volatile__("clts");
+}
+
+static inline void fninit (void) {
+	__asm__ __volatile__("fninit");
+}
+
+static inline void fxsave (void * state) {
+	__asm__ __volatile__("fxsave (%[s])"::[s]"r"(state):"memory");
+}
+
+static inline void fxrstor (void * state) {
+	__asm__ __volatile__("fxrstor (%[s])"::[s]"r"(state):"memory");
+}
+
+static inline void fnsave (void * state) {
+	__asm__ __volatile__("fnsave (%[s])"::[s]"r"(state):"memory");
+}
+
+static inline void frstor (void * state) {
+	__asm__ __volatile__("frstor (%[s])"::[s]"r"(state):"memory");
+}
+
 #endif
@@ -0,0 +1,42 @@
+/**
+ * 启动各阶段的时间戳
+ * 只在启动过程中由BSP写入，之后只读，不需要加锁
+ */
+#include "core/boottime.h"
+#include "comm/cpu_instr.h"
+#include "tools/klib.h"
+
+static uint64_t boot_stage_tsc[BOOT_STAGE_NR];
+
+/**
+ * @brief 取回boot和loader记录的时间戳，并记录进入内核的时刻
+ * boot_info位于loader的内存中，在内存初始化前复制出来
+ */
+void boottime_init (boot_info_t * boot_info) {
+    kernel_memcpy(boot_stage_tsc, boot_info->stage_tsc, sizeof(boot_info->stage_tsc));
+    boottime_stamp(BOOT_STAGE_KERNEL);
+}
+
+/**
+ * @brief 记录某阶段结束的时刻，只记录第一次
+ */
+void boottime_stamp (int stage) {
+    if ((stage >= 0) && (stage < BOOT_STAGE_NR) && !boot_stage_tsc[stage]) {
+        boot_stage_tsc[stage] = rdtsc();
+    }
+}
+
+/**
+ * @brief 从offset处读取各阶段的时间戳，返回读取的字节数
+ */
+int boottime_read (int offset, char * buf, int size) {
+    if ((offset < 0) || (offset >= sizeof(boot_stage_tsc))) {
+        return 0;
+    }
+
+    if (size > sizeof(boot_stage_tsc) - offset) {
+        size = sizeof(boot_stage_tsc) - offset;
+    }
+    kernel_memcpy(buf, (char *)boot_stage_tsc + offset, size);
+    return size;
+}
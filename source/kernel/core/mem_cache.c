@@ -0,0 +1,90 @@
+/**
+ * 固定大小对象的缓存
+ * 页一旦取得就留在缓存中不再归还，频繁创建和销毁对象时不会反复调用页分配器
+ */
+#include "core/mem_cache.h"
+#include "core/memory.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+/**
+ * @brief 初始化对象缓存，对象不能超过一页
+ */
+void mem_cache_init (mem_cache_t * cache, const char * name, int obj_size, int align, int max_count) {
+    if (obj_size < (int)sizeof(void *)) {
+        obj_size = (int)sizeof(void *);
+    }
+    if (align < (int)sizeof(void *)) {
+        align = (int)sizeof(void *);
+    }
+    obj_size = up2(obj_size, align);
+    ASSERT(obj_size <= MEM_PAGE_SIZE);
+
+    cache->name = name;
+    cache->obj_size = obj_size;
+    cache->obj_per_page = MEM_PAGE_SIZE / obj_size;
+    cache->max_count = max_count;
+    cache->count = 0;
+    cache->page_count = 0;
+    cache->free_obj = (void *)0;
+    spinlock_init(&cache->lock);
+}
+
+/**
+ * @brief 取一页内存切分后放入空闲链表，页分配器使用互斥锁，不能在持有自旋锁时调用
+ */
+static int mem_cache_grow (mem_cache_t * cache) {
+    uint32_t page = memory_alloc_page();
+    if (page == 0) {
+        log_printf("%s: no memory.", cache->name);
+        return -1;
+    }
+
+    irq_state_t state = spin_lock_irqsave(&cache->lock);
+    for (int i = 0; i < cache->obj_per_page; i++) {
+        void ** obj = (void **)(page + i * cache->obj_size);
+        *obj = cache->free_obj;
+        cache->free_obj = obj;
+    }
+    cache->page_count++;
+    spin_unlock_irqrestore(&cache->lock, state);
+    return 0;
+}
+
+/**
+ * @brief 分配一个对象，内容未初始化，失败返回0
+ */
+void * mem_cache_alloc (mem_cache_t * cache) {
+    for (;;) {
+        irq_state_t state = spin_lock_irqsave(&cache->lock);
+        if (cache->max_count && (cache->count >= cache->max_count)) {
+            spin_unlock_irqrestore(&cache->lock, state);
+            return (void *)0;
+        }
+
+        void ** obj = (void **)cache->free_obj;
+        if (obj) {
+            cache->free_obj = *obj;
+            cache->count++;
+            spin_unlock_irqrestore(&cache->lock, state);
+            return obj;
+        }
+        spin_unlock_irqrestore(&cache->lock, state);
+
+        // 没有空闲对象，扩充后重试
+        if (mem_cache_grow(cache) < 0) {
+            return (void *)0;
+        }
+    }
+}
+
+/**
+ * @brief 释放对象，放回空闲链表头部
+ */
+void mem_cache_free (mem_cache_t * cache, void * obj) {
+    irq_state_t state = spin_lock_irqsave(&cache->lock);
+    *(void **)obj = cache->free_obj;
+    cache->free_obj = obj;
+    cache->count--;
+    spin_unlock_irqrestore(&cache->lock, state);
+}
@@ -7,9 +7,12 @@
 #include "tools/klib.h"
 #include "cpu/mmu.h"
 #include "dev/console.h"
+#include "dev/time.h"
+#include "core/trace.h"
 
 static addr_alloc_t paddr_alloc;        // 物理地址分配结构
 static pde_t kernel_page_dir[PDE_CNT] __attribute__((aligned(MEM_PAGE_SIZE))); // 内核页目录表
+static uint32_t mmio_next = MEM_MMIO_BASE;     // 设备映射区下一个空闲的地址
 
 
 /**
@@ -49,6 +52,8 @@ static uint32_t addr_alloc_page (addr_alloc_t * alloc, int page_count) {
     }
 
     mutex_unlock(&alloc->mutex);
+
+    trace_event(TRACE_CLASS_MEM, TRACE_PAGE_ALLOC, addr, page_count);
     return addr;
 }
 
@@ -56,6 +61,8 @@ static uint32_t addr_alloc_page (addr_alloc_t * alloc, int page_count) {
  * @brief 释放多页内存
  */
 static void addr_free_page (addr_alloc_t * alloc, uint32_t addr, int page_count) {
+    trace_event(TRACE_CLASS_MEM, TRACE_PAGE_FREE, addr, page_count);
+
     mutex_lock(&alloc->mutex);
 
     uint32_t pg_idx = (addr - alloc->start) / alloc->page_size;
@@ -156,6 +163,7 @@ int memory_create_map (pde_t * page_dir, uint32_t vaddr, uint32_t paddr, int cou
 void create_kernel_table (void) {
     extern uint8_t s_text[], e_text[], s_data[], e_data[];
     extern uint8_t kernel_base[];
+    extern time_page_t time_page;
 
     // 地址映射表, 用于建立内核级的地址映射，内核映射是等价映射，虚拟地址和物理地址相同
     // 地址不变，但是添加了属性
@@ -167,6 +175,9 @@ void create_kernel_table (void) {
 
         // 扩展存储空间一一映射，方便直接操作
         {(void *)MEM_EXT_START, (void *)MEM_EXT_END,     (void *)MEM_EXT_START, PTE_W},
+
+        // 共享时间页，应用只读
+        {(void *)TIME_PAGE_ADDR, (void *)(TIME_PAGE_ADDR + (MEM_PAGE_SIZE - 1)), &time_page, PTE_U},
     };
 
     // 清空页目录表，kernel_page_dir为基地址
@@ -188,6 +199,38 @@ void create_kernel_table (void) {
     }
 }
 
+/**
+ * @brief 将设备寄存器等物理区域映射到内核空间，禁止缓存
+ * 进程创建时才复制内核页目录项，因此需要在创建进程之前调用
+ * @return 对应paddr的虚拟地址，失败返回0
+ */
+uint32_t memory_map_mmio (uint32_t paddr, uint32_t size) {
+    uint32_t pstart = down2(paddr, MEM_PAGE_SIZE);
+    uint32_t pend = up2(paddr + size, MEM_PAGE_SIZE);
+    int page_count = (pend - pstart) / MEM_PAGE_SIZE;
+
+    if (mmio_next + page_count * MEM_PAGE_SIZE > MEM_MMIO_BASE + MEM_MMIO_SIZE) {
+        log_printf("mmio space is full.");
+        return 0;
+    }
+
+    uint32_t vaddr = mmio_next;
+    int err = memory_create_map(kernel_page_dir, vaddr, pstart, page_count, PTE_W | PTE_PCD | PTE_PWT);
+    if (err < 0) {
+        return 0;
+    }
+
+    mmio_next += page_count * MEM_PAGE_SIZE;
+    return vaddr + (paddr - pstart);
+}
+
+/**
+ * @brief 内核页表，内核线程直接使用
+ */
+uint32_t memory_kernel_page_dir (void) {
+    return (uint32_t)kernel_page_dir;
+}
+
 /**
  * @brief 创建进程的初始页表
  * 主要的工作创建页目录表，然后从内核页表中复制一部分
@@ -308,6 +351,18 @@ uint32_t memory_get_paddr (uint32_t page_dir, uint32_t vaddr) {
     return pte_paddr(pte) + (vaddr & (MEM_PAGE_SIZE - 1));
 }
 
+/**
+ * @brief 检查vaddr所在页是否已映射且允许用户访问，可在中断中调用
+ */
+int memory_user_mapped (uint32_t page_dir, uint32_t vaddr) {
+    if (vaddr < MEMORY_TASK_BASE) {
+        return 0;
+    }
+
+    pte_t * pte = find_pte((pde_t *)page_dir, vaddr, 0);
+    return pte && pte->present && pte->user_mode_acc;
+}
+
 /**
  * @brief 在不同的进程空间中拷贝字符串
  * page_dir为目标页表，当前仍为老页表
@@ -386,6 +441,13 @@ uint32_t memory_alloc_page (void) {
     return addr_alloc_page(&paddr_alloc, 1);
 }
 
+/**
+ * @brief 分配连续的多页内存，用于内核中较大的缓冲区
+ */
+uint32_t memory_alloc_pages (int page_count) {
+    return addr_alloc_page(&paddr_alloc, page_count);
+}
+
 /**
  * @brief 释放一页内存
  */
@@ -430,6 +492,7 @@ void memory_init (boot_info_t * boot_info) {
     // 4GB大小需要总共4*1024*1024*1024/4096/8=128KB的位图, 使用低1MB的RAM空间中足够
     // 该部分的内存仅跟在mem_free_start开始放置
     addr_alloc_init(&paddr_alloc, mem_free, MEM_EXT_START, mem_up1MB_free, MEM_PAGE_SIZE);
+    mutex_set_name(&paddr_alloc.mutex, "paddr");
     mem_free += bitmap_byte_count(paddr_alloc.size / MEM_PAGE_SIZE);
 
     // 到这里，mem_free应该比EBDA地址要小，mem_free小于0x80000
@@ -448,7 +511,7 @@ void memory_init (boot_info_t * boot_info) {
  */
 char * sys_sbrk(int incr) {
     task_t * task = task_current();
-    char * pre_heap_end = (char * )task->heap_end;
+    char * pre_heap_end = (char * )task->mm->heap_end;
     int pre_incr = incr;
 
     ASSERT(incr >= 0);
@@ -459,7 +522,7 @@ char * sys_sbrk(int incr) {
         return pre_heap_end;
     } 
     
-    uint32_t start = task->heap_end;
+    uint32_t start = task->mm->heap_end;
     uint32_t end = start + incr;
 
     // 起始偏移非0
@@ -467,7 +530,7 @@ char * sys_sbrk(int incr) {
     if (start_offset) {
         // 不超过1页，只调整
         if (start_offset + incr <= MEM_PAGE_SIZE) {
-            task->heap_end = end;
+            task->mm->heap_end = end;
             return pre_heap_end;
         } else {
             // 超过1页，先只调本页的
@@ -488,6 +551,6 @@ char * sys_sbrk(int incr) {
     }
 
     //log_printf("sbrk(%d): end = 0x%x", pre_incr, end);
-    task->heap_end = end;
+    task->mm->heap_end = end;
     return (char * )pre_heap_end;        
 }
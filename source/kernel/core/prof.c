@@ -0,0 +1,255 @@
+/**
+ * 定时器采样的性能分析
+ * 样本在时钟中断中写入当前CPU的环形缓冲区，由读/dev/prof的任务取走。
+ * 内核和应用都以-O0编译，保留了帧指针，调用栈沿ebp链回溯即可。
+ * 采样地址的符号化在主机上进行，见script/prof-sym.py。
+ */
+#include "core/prof.h"
+#include "core/task.h"
+#include "core/memory.h"
+#include "cpu/irq.h"
+#include "cpu/smp.h"
+#include "ipc/spinlock.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+/**
+ * @brief 每个CPU的样本缓冲区，head/tail为一直递增的计数
+ */
+typedef struct _prof_ring_t {
+    uint32_t head;                          // 已取走的样本数
+    uint32_t tail;                          // 已写入的样本数
+    uint32_t dropped;                       // 缓冲区满丢弃的样本数
+    prof_sample_t samples[PROF_RING_SIZE];
+}prof_ring_t;
+
+static prof_ring_t * prof_rings[SMP_CPU_MAX];
+static volatile int prof_mode;              // 0-停止，否则为开始时的命令
+static spinlock_t prof_lock;                // 保护各缓冲区的head/tail
+
+/**
+ * @brief 沿内核栈的帧指针回溯，只在被中断的栈所在页内进行
+ */
+static int prof_walk_kernel (uint32_t stack, uint32_t ebp, uint32_t * chain) {
+    uint32_t bottom = stack & ~(MEM_PAGE_SIZE - 1);
+    uint32_t top = bottom + MEM_PAGE_SIZE;
+
+    int depth = 0;
+    while ((depth < PROF_DEPTH) && (ebp >= bottom) && (ebp + 8 <= top) && !(ebp & 3)) {
+        uint32_t * frame = (uint32_t *)ebp;
+        chain[depth++] = frame[1];
+
+        // 栈向低地址增长，上一帧总在更高处，防止出现环
+        if (frame[0] <= ebp) {
+            break;
+        }
+        ebp = frame[0];
+    }
+    return depth;
+}
+
+/**
+ * @brief 沿用户栈的帧指针回溯，每次读取前检查页是否映射
+ */
+static int prof_walk_user (uint32_t page_dir, uint32_t ebp, uint32_t * chain) {
+    int depth = 0;
+    // ebp由应用控制，帧的两项可能跨页，两处都要检查
+    while ((depth < PROF_DEPTH) && !(ebp & 3) && memory_user_mapped(page_dir, ebp)
+            && memory_user_mapped(page_dir, ebp + 4)) {
+        uint32_t * frame = (uint32_t *)ebp;
+        chain[depth++] = frame[1];
+
+        if (frame[0] <= ebp) {
+            break;
+        }
+        ebp = frame[0];
+    }
+    return depth;
+}
+
+/**
+ * @brief profil的采样，被中断的是用户态时计入当前进程的直方图
+ * 同一进程的多个线程可能同时在不同CPU上计数，偶尔丢失一次计数可以接受
+ */
+static void prof_user_tick (exception_frame_t * frame) {
+    task_t * task = task_current();
+    task_mm_t * mm = task ? task->mm : (task_mm_t *)0;
+    if (!mm || !mm->prof_scale || (frame->eip < mm->prof_offset)) {
+        return;
+    }
+
+    uint32_t index = (uint32_t)(((uint64_t)((frame->eip - mm->prof_offset) >> 1) * mm->prof_scale) >> 16);
+    if (index >= mm->prof_size / sizeof(uint16_t)) {
+        return;
+    }
+
+    // 当前页表即该进程的页表，计数所在页可能已被应用释放
+    uint32_t addr = mm->prof_buf + index * sizeof(uint16_t);
+    if (memory_user_mapped(mm->page_dir, addr)) {
+        (*(uint16_t *)addr)++;
+    }
+}
+
+/**
+ * @brief 时钟中断中采样，中断已关闭
+ */
+void prof_tick (exception_frame_t * frame) {
+    if (frame->cs & SEG_RPL3) {
+        prof_user_tick(frame);
+    }
+
+    int mode = prof_mode;
+    if (!mode) {
+        return;
+    }
+
+    cpu_t * cpu = cpu_current();
+    prof_ring_t * ring = prof_rings[cpu->id];
+    if (!ring) {
+        return;
+    }
+
+    spin_lock(&prof_lock);
+    if (ring->tail - ring->head >= PROF_RING_SIZE) {
+        ring->dropped++;
+        spin_unlock(&prof_lock);
+        return;
+    }
+    prof_sample_t * sample = ring->samples + (ring->tail & (PROF_RING_SIZE - 1));
+    spin_unlock(&prof_lock);
+
+    // 只有本CPU写入该项，tail更新前读取者不会访问
+    task_t * task = cpu->curr_task;
+    sample->eip = frame->eip;
+    sample->cs = frame->cs;
+    sample->cpu = cpu->id;
+    sample->pid = task ? task->pid : 0;
+    sample->depth = 0;
+    if (mode == PROF_CMD_CALLGRAPH) {
+        if (frame->cs & SEG_RPL3) {
+            sample->depth = prof_walk_user(task->tss.cr3, frame->ebp, sample->callchain);
+        } else {
+            sample->depth = prof_walk_kernel((uint32_t)frame, frame->ebp, sample->callchain);
+        }
+    }
+
+    spin_lock(&prof_lock);
+    ring->tail++;
+    spin_unlock(&prof_lock);
+}
+
+/**
+ * @brief 取走各CPU已缓存的样本，返回读取的字节数
+ */
+int prof_read (char * buf, int size) {
+    int len = 0;
+    for (int i = 0; i < smp_cpu_count(); i++) {
+        prof_ring_t * ring = prof_rings[i];
+        if (!ring) {
+            continue;
+        }
+
+        while (len + (int)sizeof(prof_sample_t) <= size) {
+            prof_sample_t sample;
+
+            irq_state_t state = spin_lock_irqsave(&prof_lock);
+            if (ring->head == ring->tail) {
+                spin_unlock_irqrestore(&prof_lock, state);
+                break;
+            }
+            sample = ring->samples[ring->head & (PROF_RING_SIZE - 1)];
+            ring->head++;
+            spin_unlock_irqrestore(&prof_lock, state);
+
+            // 在锁外复制到应用的缓冲区
+            kernel_memcpy(buf + len, &sample, sizeof(prof_sample_t));
+            len += sizeof(prof_sample_t);
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief 开始或停止采样，开始时清空缓冲区
+ */
+int prof_control (int cmd) {
+    switch (cmd) {
+    case PROF_CMD_STOP: {
+        prof_mode = 0;
+
+        uint32_t dropped = 0;
+        for (int i = 0; i < smp_cpu_count(); i++) {
+            dropped += prof_rings[i] ? prof_rings[i]->dropped : 0;
+        }
+        if (dropped) {
+            log_printf("prof: %d sample(s) dropped", dropped);
+        }
+        return 0;
+    }
+    case PROF_CMD_START:
+    case PROF_CMD_CALLGRAPH:
+        break;
+    default:
+        return -1;
+    }
+
+    // 第一次使用时才分配缓冲区
+    prof_mode = 0;
+    for (int i = 0; i < smp_cpu_count(); i++) {
+        if (!prof_rings[i]) {
+            prof_rings[i] = (prof_ring_t *)memory_alloc_page();
+            if (!prof_rings[i]) {
+                return -1;
+            }
+        }
+
+        irq_state_t state = spin_lock_irqsave(&prof_lock);
+        prof_rings[i]->head = prof_rings[i]->tail = prof_rings[i]->dropped = 0;
+        spin_unlock_irqrestore(&prof_lock, state);
+    }
+
+    prof_mode = cmd;
+    return 0;
+}
+
+/**
+ * @brief 停止采样，不统计丢弃数，可在持有自旋锁时调用
+ */
+void prof_stop (void) {
+    prof_mode = 0;
+}
+
+/**
+ * @brief 设置当前进程的profil直方图，scale为0或1时停止
+ * 被中断的用户态地址pc计入第((pc - offset) / 2 * scale) >> 16个计数，超出size时忽略
+ */
+int sys_profil (uint16_t * buf, uint32_t size, uint32_t offset, uint32_t scale) {
+    task_mm_t * mm = task_current()->mm;
+
+    if (scale <= 1) {
+        mm->prof_scale = 0;
+        return 0;
+    }
+
+    uint32_t start = (uint32_t)buf;
+    if ((start < MEMORY_TASK_BASE) || (start & 1) || (start + size < start)) {
+        return -1;
+    }
+
+    // 先停止，避免时钟中断看到一半的设置
+    mm->prof_scale = 0;
+    mm->prof_buf = start;
+    mm->prof_size = size;
+    mm->prof_offset = offset;
+    __asm__ __volatile__("" ::: "memory");
+    mm->prof_scale = scale;
+    return 0;
+}
+
+/**
+ * @brief 性能分析初始化
+ */
+void prof_init (void) {
+    spinlock_init(&prof_lock);
+    ASSERT(sizeof(prof_ring_t) <= MEM_PAGE_SIZE);
+}
@@ -0,0 +1,133 @@
+/**
+ * 调度延迟及负载的统计
+ * 各项统计都在持有调度锁时更新和读取。没有TSC时不统计延迟，负载照常计算。
+ */
+#include "core/schedstat.h"
+#include "core/task.h"
+#include "cpu/smp.h"
+#include "dev/time.h"
+#include "comm/cpu_instr.h"
+#include "tools/klib.h"
+
+#define LOAD_FIXED_1            (1 << SCHED_LOAD_SHIFT)
+#define LOAD_EXP_1              1884        // 2048/exp(5s/1min)
+#define LOAD_EXP_5              2014        // 2048/exp(5s/5min)
+#define LOAD_EXP_15             2037        // 2048/exp(5s/15min)
+
+static sched_wait_t sched_wait;             // 全局的唤醒延迟
+static uint32_t sched_loadavg[3];
+static uint32_t sched_nr_running;
+static uint32_t sched_load_ticks;           // 距下次计算负载的tick数
+
+/**
+ * @brief 任务进入就绪队列，正在运行的任务(如时间片用完后重新排队)不算唤醒
+ */
+void schedstat_wakeup (task_t * task) {
+    if ((task != task->cpu->curr_task) && time_get_tsc_khz()) {
+        task->ready_tsc = rdtsc();
+    }
+}
+
+/**
+ * @brief 记入一次延迟
+ */
+static void wait_add (sched_wait_t * wait, uint64_t cycles, int bucket) {
+    wait->wakeups++;
+    wait->total += cycles;
+    if (cycles > wait->max) {
+        wait->max = cycles;
+    }
+    wait->hist[bucket]++;
+}
+
+/**
+ * @brief 任务即将在当前CPU上运行，计入从唤醒到此时的延迟
+ */
+void schedstat_run (task_t * task) {
+    if (!task->ready_tsc) {
+        return;
+    }
+
+    uint64_t cycles = rdtsc() - task->ready_tsc;
+    task->ready_tsc = 0;
+
+    int bucket = log2_bucket(cycles, SCHED_HIST_SHIFT, SCHED_HIST_NR);
+    wait_add(&sched_wait, cycles, bucket);
+    wait_add(&task->sched_wait, cycles, bucket);
+}
+
+/**
+ * @brief 指数平均，与Linux的calc_load相同
+ */
+static uint32_t calc_load (uint32_t load, uint32_t exp, uint32_t active) {
+    return (load * exp + active * (LOAD_FIXED_1 - exp)) >> SCHED_LOAD_SHIFT;
+}
+
+/**
+ * @brief 在BSP的时钟处理中调用，已持有调度锁，每SCHED_LOAD_FREQ_MS统计一次负载
+ */
+void schedstat_tick (void) {
+    if (sched_load_ticks) {
+        sched_load_ticks--;
+        return;
+    }
+    sched_load_ticks = SCHED_LOAD_FREQ_MS / OS_TICK_MS - 1;
+
+    // 就绪队列中包含正在运行的任务，空闲任务不在其中
+    uint32_t nr = 0;
+    for (int i = 0; i < smp_cpu_count(); i++) {
+        cpu_t * cpu = smp_cpu(i);
+        nr += list_count(&cpu->ready_list) + list_count(&cpu->rt_list);
+    }
+    sched_nr_running = nr;
+
+    uint32_t active = nr * LOAD_FIXED_1;
+    sched_loadavg[0] = calc_load(sched_loadavg[0], LOAD_EXP_1, active);
+    sched_loadavg[1] = calc_load(sched_loadavg[1], LOAD_EXP_5, active);
+    sched_loadavg[2] = calc_load(sched_loadavg[2], LOAD_EXP_15, active);
+}
+
+/**
+ * @brief 读取全局(pid为0)或指定任务的统计
+ */
+int schedstat_read (int pid, sched_stat_t * stat) {
+    kernel_memset(stat, 0, sizeof(sched_stat_t));
+    stat->pid = pid;
+
+    irq_state_t state = task_lock();
+    if (pid == 0) {
+        stat->nr_running = sched_nr_running;
+        kernel_memcpy(stat->loadavg, sched_loadavg, sizeof(sched_loadavg));
+        stat->wait = sched_wait;
+    } else {
+        task_t * task = task_find_pid(pid);
+        if (!task) {
+            task_unlock(state);
+            return -1;
+        }
+        stat->wait = task->sched_wait;
+    }
+    task_unlock(state);
+    return 0;
+}
+
+/**
+ * @brief 清零全局或指定任务的延迟统计，负载不清零
+ */
+int schedstat_reset (int pid) {
+    int err = 0;
+
+    irq_state_t state = task_lock();
+    if (pid == 0) {
+        kernel_memset(&sched_wait, 0, sizeof(sched_wait_t));
+    } else {
+        task_t * task = task_find_pid(pid);
+        if (task) {
+            kernel_memset(&task->sched_wait, 0, sizeof(sched_wait_t));
+        } else {
+            err = -1;
+        }
+    }
+    task_unlock(state);
+    return err;
+}
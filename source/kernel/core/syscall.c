@@ -7,6 +7,19 @@
 #include "tools/log.h"
 #include "core/memory.h"
 #include "fs/fs.h"
+#include "dev/time.h"
+#include "ipc/futex.h"
+#include "core/uring.h"
+#include "core/prof.h"
+#include "core/syscall_stat.h"
+#include "core/trace.h"
+#include "core/mem_cache.h"
+#include "cpu/irq.h"
+#include "cpu/smp.h"
+#include "comm/cpu_instr.h"
+#include "os_cfg.h"
+
+static int sysenter_enabled;		// 是否启用了sysenter快速系统调用
 
 
 // 系统调用处理函数类型
@@ -26,7 +39,26 @@ static const syscall_handler_t sys_table[] = {
 	[SYS_execve] = (syscall_handler_t)sys_execve,
     [SYS_yield] = (syscall_handler_t)sys_yield,
 	[SYS_wait] = (syscall_handler_t)sys_wait,
+	[SYS_waitpid] = (syscall_handler_t)sys_waitpid,
 	[SYS_exit] = (syscall_handler_t)sys_exit,
+	[SYS_vfork] = (syscall_handler_t)sys_vfork,
+	[SYS_spawn] = (syscall_handler_t)sys_spawn,
+	[SYS_futex] = (syscall_handler_t)sys_futex,
+	[SYS_clone] = (syscall_handler_t)sys_clone,
+	[SYS_set_tls] = (syscall_handler_t)sys_set_tls,
+	[SYS_sched_setattr] = (syscall_handler_t)sys_sched_setattr,
+	[SYS_sched_getattr] = (syscall_handler_t)sys_sched_getattr,
+	[SYS_uring_setup] = (syscall_handler_t)sys_uring_setup,
+	[SYS_uring_enter] = (syscall_handler_t)sys_uring_enter,
+	[SYS_profil] = (syscall_handler_t)sys_profil,
+
+	[SYS_clock_gettime] = (syscall_handler_t)sys_clock_gettime,
+	[SYS_gettimeofday] = (syscall_handler_t)sys_gettimeofday,
+	[SYS_nanosleep] = (syscall_handler_t)sys_nanosleep,
+
+	[SYS_times] = (syscall_handler_t)sys_times,
+	[SYS_getrusage] = (syscall_handler_t)sys_getrusage,
+	[SYS_task_info] = (syscall_handler_t)sys_task_info,
 
 	[SYS_open] = (syscall_handler_t)sys_open,
 	[SYS_read] = (syscall_handler_t)sys_read,
@@ -40,17 +72,195 @@ static const syscall_handler_t sys_table[] = {
 	
 };
 
+#define SYS_TABLE_NR		(sizeof(sys_table) / sizeof(sys_table[0]))
+
+// 统计只为已实现的系统调用分配槽位，节省每个任务的空间
+static uint8_t stat_slot[SYS_TABLE_NR];	// 系统调用号对应的槽位加1，0表示未实现
+static int stat_id[SYSCALL_STAT_NR];	// 槽位对应的系统调用号
+static int stat_count;					// 使用的槽位数
+static int stat_tsc;					// 是否可用TSC计时
+static mem_cache_t stat_cache;			// 任务的统计
+
+/**
+ * @brief 读取当前的周期数，没有TSC时只统计次数
+ */
+static inline uint64_t stat_cycles (void) {
+	return stat_tsc ? rdtsc() : 0;
+}
+
+/**
+ * @brief 清空一组统计，保留系统调用号
+ */
+static void stat_clear (syscall_stat_t * stat) {
+	kernel_memset(stat, 0, sizeof(syscall_stat_t) * stat_count);
+	for (int i = 0; i < stat_count; i++) {
+		stat[i].id = stat_id[i];
+	}
+}
+
+/**
+ * @brief 记入一次调用
+ */
+static inline void stat_add (syscall_stat_t * stat, int ret, uint64_t cycles, int bucket) {
+	stat->count++;
+	stat->errors += (ret < 0);
+	stat->cycles += cycles;
+	stat->hist[bucket]++;
+}
+
+/**
+ * @brief 记入当前CPU和当前任务的统计
+ */
+static void syscall_stat_add (int id, int ret, uint64_t cycles) {
+	int slot = stat_slot[id] - 1;
+
+	int bucket = log2_bucket(cycles, SYSCALL_HIST_SHIFT, SYSCALL_HIST_NR);
+
+	// 关中断防止中途被切换到其它CPU
+	irq_state_t state = irq_enter_protection();
+	cpu_t * cpu = cpu_current();
+	if (cpu->sysstat) {
+		stat_add(cpu->sysstat + slot, ret, cycles, bucket);
+	}
+	irq_leave_protection(state);
+
+	// 任务的统计只由自己更新
+	task_t * task = task_current();
+	if (!task->sysstat) {
+		task->sysstat = (syscall_stat_t *)mem_cache_alloc(&stat_cache);
+		if (!task->sysstat) {
+			return;
+		}
+		stat_clear(task->sysstat);
+	}
+	stat_add(task->sysstat + slot, ret, cycles, bucket);
+}
+
+/**
+ * @brief 读取第index项统计，pid为0时为所有CPU的汇总
+ * 没有该项或没有该任务时返回-1
+ */
+int syscall_stat_read (int pid, int index, syscall_stat_t * stat) {
+	if ((index < 0) || (index >= stat_count)) {
+		return -1;
+	}
+
+	kernel_memset(stat, 0, sizeof(syscall_stat_t));
+	stat->id = stat_id[index];
+
+	if (pid == 0) {
+		for (int i = 0; i < smp_cpu_count(); i++) {
+			cpu_t * cpu = smp_cpu(i);
+			if (!cpu->sysstat) {
+				continue;
+			}
+
+			syscall_stat_t * curr = cpu->sysstat + index;
+			stat->count += curr->count;
+			stat->errors += curr->errors;
+			stat->cycles += curr->cycles;
+			for (int j = 0; j < SYSCALL_HIST_NR; j++) {
+				stat->hist[j] += curr->hist[j];
+			}
+		}
+		return 0;
+	}
+
+	// 持有调度锁，防止任务被回收
+	irq_state_t state = task_lock();
+	task_t * task = task_find_pid(pid);
+	if (!task) {
+		task_unlock(state);
+		return -1;
+	}
+	if (task->sysstat) {
+		kernel_memcpy(stat, task->sysstat + index, sizeof(syscall_stat_t));
+	}
+	task_unlock(state);
+	return 0;
+}
+
+/**
+ * @brief 清零统计，pid为0时清零所有CPU的统计
+ */
+int syscall_stat_reset (int pid) {
+	if (pid == 0) {
+		for (int i = 0; i < smp_cpu_count(); i++) {
+			cpu_t * cpu = smp_cpu(i);
+			if (cpu->sysstat) {
+				stat_clear(cpu->sysstat);
+			}
+		}
+		return 0;
+	}
+
+	irq_state_t state = task_lock();
+	task_t * task = task_find_pid(pid);
+	if (!task) {
+		task_unlock(state);
+		return -1;
+	}
+	if (task->sysstat) {
+		stat_clear(task->sysstat);
+	}
+	task_unlock(state);
+	return 0;
+}
+
+/**
+ * @brief 任务回收时释放其统计
+ */
+void syscall_stat_free (task_t * task) {
+	if (task->sysstat) {
+		mem_cache_free(&stat_cache, task->sysstat);
+		task->sysstat = (syscall_stat_t *)0;
+	}
+}
+
+/**
+ * @brief 建立统计的槽位，并为每个CPU分配全局统计
+ */
+static void syscall_stat_init (void) {
+	for (int i = 0; i < SYS_TABLE_NR; i++) {
+		if (!sys_table[i]) {
+			continue;
+		}
+
+		ASSERT(stat_count < SYSCALL_STAT_NR);
+		stat_id[stat_count] = i;
+		stat_slot[i] = ++stat_count;
+	}
+
+	uint32_t eax, ebx, ecx, edx;
+	cpuid(1, &eax, &ebx, &ecx, &edx);
+	stat_tsc = (edx & CPUID_FEAT_EDX_TSC) != 0;
+
+	mem_cache_init(&stat_cache, "sysstat", sizeof(syscall_stat_t) * stat_count,
+			__alignof__(syscall_stat_t), TASK_NR);
+	for (int i = 0; i < smp_cpu_count(); i++) {
+		cpu_t * cpu = smp_cpu(i);
+		cpu->sysstat = (syscall_stat_t *)memory_alloc_page();
+		if (cpu->sysstat) {
+			stat_clear(cpu->sysstat);
+		}
+	}
+}
+
 /**
  * 处理系统调用。该函数由系统调用函数调用
  */
 void do_handler_syscall (syscall_frame_t * frame) {
 	// 超出边界，返回错误
-    if (frame->func_id < sizeof(sys_table) / sizeof(sys_table[0])) {
+    if (frame->func_id < SYS_TABLE_NR) {
 		// 查表取得处理函数，然后调用处理
 		syscall_handler_t handler = sys_table[frame->func_id];
 		if (handler) {
+			trace_event(TRACE_CLASS_SYSCALL, TRACE_SYSCALL_ENTER, frame->func_id, frame->arg0);
+			uint64_t start = stat_cycles();
 			int ret = handler(frame->arg0, frame->arg1, frame->arg2, frame->arg3);
 			frame->eax = ret;  // 设置系统调用的返回值，由eax传递
+			syscall_stat_add(frame->func_id, ret, stat_cycles() - start);
+			trace_event(TRACE_CLASS_SYSCALL, TRACE_SYSCALL_EXIT, frame->func_id, ret);
             return;
 		}
 	}
@@ -59,4 +269,50 @@ void do_handler_syscall (syscall_frame_t * frame) {
 	task_t * task = task_current();
 	log_printf("task: %s, Unknown syscall: %d", task->name,  frame->func_id);
     frame->eax = -1;  // 设置系统调用的返回值，由eax传递
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 设置当前CPU的sysenter入口，使用内核代码段
+ * sysexit返回时使用的段由IA32_SYSENTER_CS推出，见APP_SELECTOR_CS
+ */
+static void sysenter_setup (void) {
+	wrmsr(IA32_SYSENTER_CS, KERNEL_SELECTOR_CS);
+	wrmsr(IA32_SYSENTER_EIP, (uint32_t)exception_handler_sysenter);
+	wrmsr(IA32_SYSENTER_ESP, 0);		// 进入任务时再设置为其内核栈
+}
+
+/**
+ * @brief 系统调用初始化，CPU支持时启用sysenter，调用门始终保留
+ * 需在多处理器初始化之后调用，以便为每个CPU分配统计
+ */
+void syscall_init (void) {
+	syscall_stat_init();
+
+	if (!syscall_sysenter_supported()) {
+		log_printf("sysenter not supported, use call gate.");
+		return;
+	}
+
+	sysenter_setup();
+	sysenter_enabled = 1;
+	log_printf("sysenter enabled.");
+}
+
+/**
+ * @brief AP上的初始化，MSR是每个CPU私有的
+ */
+void syscall_ap_init (void) {
+	if (sysenter_enabled) {
+		sysenter_setup();
+	}
+}
+
+/**
+ * @brief 设置sysenter进入时使用的内核栈，即将要运行的任务的esp0
+ * 硬件任务切换不会更新该MSR，需在每次切换前设置
+ */
+void syscall_set_kernel_stack (uint32_t esp0) {
+	if (sysenter_enabled) {
+		wrmsr(IA32_SYSENTER_ESP, esp0);
+	}
+}
@@ -13,11 +13,195 @@
 #include "core/syscall.h"
 #include "comm/elf.h"
 #include "fs/fs.h"
+#include "dev/time.h"
+#include "cpu/smp.h"
+#include "tools/bitmap.h"
+#include "core/mem_cache.h"
+#include "ipc/futex.h"
+#include "core/trace.h"
 
 static task_manager_t task_manager;     // 任务管理器
-static uint32_t idle_task_stack[IDLE_STACK_SIZE];	// 空闲任务堆栈
-static task_t task_table[TASK_NR];      // 用户进程表
-static mutex_t task_table_mutex;        // 进程表互斥访问锁
+static mem_cache_t task_cache;          // 任务结构的分配缓存
+static mem_cache_t mm_cache;            // 地址空间结构的分配缓存
+static mem_cache_t files_cache;         // 文件表的分配缓存
+static task_t * tss_task[GDT_TABLE_SIZE];   // TSS选择子到任务的映射，用于查找当前任务
+
+// pid分配，以下均由调度锁保护
+static uint8_t pid_bits[TASK_PID_MAX / 8];
+static bitmap_t pid_bitmap;             // 已分配的pid
+static int pid_last;                    // 上次分配的pid，循环向后分配，避免刚释放的pid立即被复用
+static list_t pid_hash[TASK_PID_HASH_SIZE];
+
+/**
+ * @brief 分配一个pid，失败返回-1
+ */
+static int pid_alloc (void) {
+    irq_state_t state = task_lock();
+    int pid = pid_last;
+    for (int i = 1; i < TASK_PID_MAX; i++) {
+        if (++pid >= TASK_PID_MAX) {
+            pid = 1;
+        }
+
+        if (!bitmap_get_bit(&pid_bitmap, pid)) {
+            bitmap_set_bit(&pid_bitmap, pid, 1, 1);
+            pid_last = pid;
+            task_unlock(state);
+            return pid;
+        }
+    }
+    task_unlock(state);
+    return -1;
+}
+
+/**
+ * @brief 释放pid
+ */
+static void pid_free (int pid) {
+    if (pid > 0) {
+        irq_state_t state = task_lock();
+        bitmap_set_bit(&pid_bitmap, pid, 1, 0);
+        task_unlock(state);
+    }
+}
+
+/**
+ * @brief 根据pid查找任务，调用前需持有调度锁
+ */
+task_t * task_find_pid (int pid) {
+    if (pid <= 0) {
+        return (task_t *)0;
+    }
+
+    list_t * list = pid_hash + (pid % TASK_PID_HASH_SIZE);
+    for (list_node_t * node = list_first(list); node; node = list_node_next(node)) {
+        task_t * task = list_node_parent(node, task_t, pid_node);
+        if (task->pid == pid) {
+            return task;
+        }
+    }
+    return (task_t *)0;
+}
+
+/**
+ * @brief 创建新的地址空间
+ */
+static task_mm_t * task_mm_create (void) {
+    task_mm_t * mm = (task_mm_t *)mem_cache_alloc(&mm_cache);
+    if (mm == (task_mm_t *)0) {
+        return (task_mm_t *)0;
+    }
+
+    mm->page_dir = memory_create_uvm();
+    if (mm->page_dir == 0) {
+        mem_cache_free(&mm_cache, mm);
+        return (task_mm_t *)0;
+    }
+
+    mm->ref = 1;
+    mm->heap_start = mm->heap_end = 0;
+    mm->uring = 0;
+    mm->uring_busy = 0;
+    mm->prof_buf = mm->prof_size = 0;
+    mm->prof_offset = mm->prof_scale = 0;
+    return mm;
+}
+
+/**
+ * @brief 增加地址空间的引用
+ */
+static task_mm_t * task_mm_get (task_mm_t * mm) {
+    irq_state_t state = task_lock();
+    mm->ref++;
+    task_unlock(state);
+    return mm;
+}
+
+/**
+ * @brief 释放地址空间的引用，最后一个引用时销毁页表
+ * 调用者不能正在使用该页表
+ */
+static void task_mm_put (task_mm_t * mm) {
+    irq_state_t state = task_lock();
+    int ref = --mm->ref;
+    task_unlock(state);
+
+    if (ref == 0) {
+        if (mm->page_dir) {
+            memory_destroy_uvm(mm->page_dir);
+        }
+        mem_cache_free(&mm_cache, mm);
+    }
+}
+
+/**
+ * @brief 创建空的文件表
+ */
+static task_files_t * task_files_create (void) {
+    task_files_t * files = (task_files_t *)mem_cache_alloc(&files_cache);
+    if (files) {
+        kernel_memset(files, 0, sizeof(task_files_t));
+        files->ref = 1;
+        spinlock_init(&files->lock);
+    }
+    return files;
+}
+
+/**
+ * @brief 增加文件表的引用
+ */
+static task_files_t * task_files_get (task_files_t * files) {
+    irq_state_t state = task_lock();
+    files->ref++;
+    task_unlock(state);
+    return files;
+}
+
+/**
+ * @brief 释放任务对文件表的引用，最后一个引用时关闭其中所有的文件
+ */
+static void task_files_put (task_t * task) {
+    task_files_t * files = task->files;
+    if (files == (task_files_t *)0) {
+        return;
+    }
+
+    irq_state_t state = task_lock();
+    task->files = (task_files_t *)0;
+    int ref = --files->ref;
+    task_unlock(state);
+
+    if (ref == 0) {
+        for (int fd = 0; fd < TASK_OFILE_NR; fd++) {
+            file_t * file = files->file_table[fd];
+            if (file) {
+                fs_file_close(file);
+            }
+        }
+        mem_cache_free(&files_cache, files);
+    }
+}
+
+/**
+ * @brief 设置任务的线程局部存储，分配一个以base为起始地址的数据段，通过gs访问
+ */
+static int task_set_tls (task_t * task, uint32_t base) {
+    if (task->tls_sel == 0) {
+        int sel = gdt_alloc_desc();
+        if (sel < 0) {
+            return -1;
+        }
+        task->tls_sel = sel;
+    }
+
+    segment_desc_set(task->tls_sel, base, 0xFFFFFFFF,
+                     SEG_P_PRESENT | SEG_DPL3 | SEG_S_NORMAL |
+                     SEG_TYPE_DATA | SEG_TYPE_RW | SEG_D);
+    task->tls_base = base;
+    return 0;
+}
+
+void task_entry_trampoline (void);      // 在.S文件中定义
 
 static int tss_init (task_t * task, int flag, uint32_t entry, uint32_t esp) {
     // 为TSS分配GDT
@@ -41,7 +225,7 @@ static int tss_init (task_t * task, int flag, uint32_t entry, uint32_t esp) {
     
     // 根据不同的权限选择不同的访问选择子
     int code_sel, data_sel;
-    if (flag & TASK_FLAG_SYSTEM) {
+    if (flag & (TASK_FLAG_SYSTEM | TASK_FLAG_KERNEL)) {
         code_sel = KERNEL_SELECTOR_CS;
         data_sel = KERNEL_SELECTOR_DS;
     } else {
@@ -50,26 +234,39 @@ static int tss_init (task_t * task, int flag, uint32_t entry, uint32_t esp) {
         data_sel = task_manager.app_data_sel | SEG_RPL3;
     }
     
-    task->tss.eip = entry;
-    task->tss.esp = esp ? esp : kernel_stack + MEM_PAGE_SIZE;  // 未指定栈则用内核栈，即运行在特权级0的进程
+    // 任务入口放在内核栈顶，由跳板代码释放调度锁后再进入
+    task_start_frame_t * frame = (task_start_frame_t *)(kernel_stack + MEM_PAGE_SIZE - sizeof(task_start_frame_t));
+    frame->eip = entry;
+    frame->cs = code_sel;
+    frame->eflags = EFLAGS_DEFAULT | EFLAGS_IF;
+    frame->esp = esp ? esp : kernel_stack + MEM_PAGE_SIZE;  // 未指定栈则用内核栈，即运行在特权级0的进程
+    frame->ss = data_sel;
+
+    // 首次切换进来时在特权级0、关中断运行跳板代码
+    task->tss.eip = (uint32_t)task_entry_trampoline;
+    task->tss.esp = (uint32_t)frame;
     task->tss.esp0 = kernel_stack + MEM_PAGE_SIZE;
     task->tss.ss0 = KERNEL_SELECTOR_DS;
-    task->tss.eflags = EFLAGS_DEFAULT | EFLAGS_IF;
-    task->tss.es = task->tss.ss = task->tss.ds = task->tss.fs 
-            = task->tss.gs = data_sel;   // 全部采用同一数据段
-    task->tss.cs = code_sel; 
+    task->tss.eflags = EFLAGS_DEFAULT;
+    task->tss.es = task->tss.ds = task->tss.fs = task->tss.gs = data_sel;   // 全部采用同一数据段
+    task->tss.ss = KERNEL_SELECTOR_DS;
+    task->tss.cs = KERNEL_SELECTOR_CS;
     task->tss.iomap = 0;
 
 
-    // 页表初始化
-    uint32_t page_dir = memory_create_uvm();
-    if (page_dir == 0) {
-        goto tss_init_failed;
+    // 页表初始化，内核线程没有用户空间，直接共用内核页表；线程共用当前进程的地址空间
+    if (flag & TASK_FLAG_KERNEL) {
+        task->tss.cr3 = memory_kernel_page_dir();
+    } else {
+        task->mm = (flag & TASK_FLAG_THREAD) ? task_mm_get(task_current()->mm) : task_mm_create();
+        if (task->mm == (task_mm_t *)0) {
+            goto tss_init_failed;
+        }
+        task->tss.cr3 = task->mm->page_dir;
     }
-
-    task->tss.cr3 = page_dir;
     
     task->tss_sel = tss_sel;
+    tss_task[tss_sel >> 3] = task;
     return 0;
 
     // 使用goto，减少代码冗余
@@ -88,51 +285,136 @@ tss_init_failed:
 int task_init (task_t *task, const char * name, int flag, uint32_t entry, uint32_t esp) {
     ASSERT(task != (task_t *)0);
 
+    // 空闲任务的pid都为0
+    int pid = (flag & TASK_FLAG_SYSTEM) ? 0 : pid_alloc();
+    if (pid < 0) {
+        log_printf("alloc pid failed.\n");
+        return -1;
+    }
+
+    // 文件表，线程共用当前进程的
+    task_files_t * files = (task_files_t *)0;
+    if (!(flag & TASK_FLAG_KERNEL)) {
+        files = (flag & TASK_FLAG_THREAD) ? task_files_get(task_current()->files) : task_files_create();
+        if (files == (task_files_t *)0) {
+            log_printf("alloc file table failed.\n");
+            pid_free(pid);
+            return -1;
+        }
+    }
+
     int err = tss_init(task, flag, entry, esp);
     if (err < 0) {
         log_printf("init task failed.\n");
+        task->files = files;
+        task_files_put(task);
+        pid_free(pid);
         return err;
     }
 
     // 任务字段初始化
     kernel_strncpy(task->name, name, TASK_NAME_SIZE);
     task->state = TASK_CREATED;
+    task->flags = flag;
     task->sleep_ticks = 0;
     task->time_slice = TASK_TIME_SLICE_DEFAULT;
     task->slice_ticks = task->time_slice;
     task->parent = (task_t *)0;
-    task->heap_start = 0;
-    task->heap_end = 0;
+    task->policy = TASK_SCHED_NORMAL;
+    task->rt_priority = 0;
+    task->dl_runtime = task->dl_period = 0;
+    task->dl_deadline = 0;
+    task->dl_left = 0;
+    task->dl_bw = 0;
+    task->files = files;
+    task->tls_sel = 0;
+    task->tls_base = 0;
+    task->clear_tid = (int *)0;
+    task->fpu_used = 0;
+    task->cpu = (cpu_t *)0;
+    kernel_memset(&task->usage, 0, sizeof(task_usage_t));
+    kernel_memset(&task->child_usage, 0, sizeof(task_usage_t));
+    task->ready_tsc = 0;
+    kernel_memset(&task->sched_wait, 0, sizeof(sched_wait_t));
     list_node_init(&task->all_node);
     list_node_init(&task->run_node);
     list_node_init(&task->wait_node);
-
-    // 文件相关
-    kernel_memset(task->file_table, 0, sizeof(task->file_table));
-
-    // 插入就绪队列中和所有的任务队列中
-    irq_state_t state = irq_enter_protection();
-    task->pid = (uint32_t)task;   // 使用地址，能唯一
-
-    //task_set_ready(task);
+    list_node_init(&task->child_node);
+    list_node_init(&task->pid_node);
+    list_init(&task->child_list);
+    list_init(&task->zombie_list);
+
+    // 插入所有的任务队列和pid哈希表中
+    irq_state_t state = task_lock();
+    task->pid = pid;
+    if (pid > 0) {
+        list_insert_last(pid_hash + (pid % TASK_PID_HASH_SIZE), &task->pid_node);
+    }
     list_insert_last(&task_manager.task_list, &task->all_node);
-    irq_leave_protection(state);
+    task_unlock(state);
     return 0;
 }
 
+/**
+ * @brief 为新任务选择CPU，取就绪任务最少的那个
+ */
+static cpu_t * task_select_cpu (void) {
+    cpu_t * best = smp_cpu(0);
+    for (int i = 1; i < smp_cpu_count(); i++) {
+        cpu_t * cpu = smp_cpu(i);
+        if (cpu->started && (list_count(&cpu->ready_list) < list_count(&best->ready_list))) {
+            best = cpu;
+        }
+    }
+    return best;
+}
+
 /**
  * @brief 启动任务
  */
 void task_start(task_t * task) {
-    irq_state_t state = irq_enter_protection();
+    irq_state_t state = task_lock();
+    task->cpu = task_select_cpu();
     task_set_ready(task);
-    irq_leave_protection(state);
+    task_unlock(state);
+}
+
+/**
+ * @brief 新任务第一次运行时由跳板代码调用
+ * 切换前的任务持有调度锁跳转过来，由这里代为释放
+ */
+void task_start_finish (void) {
+    irqlat_switch_done();
+    spin_unlock(&task_manager.lock);
+}
+
+/**
+ * @brief 获取调度锁
+ * 锁在任务切换期间一直保持，由切换后的任务释放，保证TSS保存完成前任务不会被其它CPU选中
+ */
+irq_state_t task_lock (void) {
+    return spin_lock_irqsave(&task_manager.lock);
+}
+
+/**
+ * @brief 释放调度锁
+ */
+void task_unlock (irq_state_t state) {
+    spin_unlock_irqrestore(&task_manager.lock, state);
 }
 
 /**
  * @brief 任务任务初始时分配的各项资源
  */
 void task_uninit (task_t * task) {
+    irq_state_t state = task_lock();
+    list_remove(&task_manager.task_list, &task->all_node);
+    if (task->pid > 0) {
+        list_remove(pid_hash + (task->pid % TASK_PID_HASH_SIZE), &task->pid_node);
+        bitmap_set_bit(&pid_bitmap, task->pid, 1, 0);
+    }
+    task_unlock(state);
+
     if (task->tss_sel) {
         gdt_free_sel(task->tss_sel);
     }
@@ -141,9 +423,15 @@ void task_uninit (task_t * task) {
         memory_free_page(task->tss.esp0 - MEM_PAGE_SIZE);
     }
 
-    if (task->tss.cr3) {
-        memory_destroy_uvm(task->tss.cr3);
+    if (task->tls_sel) {
+        gdt_free_sel(task->tls_sel);
+    }
+
+    task_files_put(task);
+    if (task->mm) {
+        task_mm_put(task->mm);
     }
+    syscall_stat_free(task);
 
     kernel_memset(task, 0, sizeof(task_t));
 }
@@ -154,6 +442,7 @@ void simple_switch (uint32_t ** from, uint32_t * to);
  * @brief 切换至指定任务
  */
 void task_switch_from_to (task_t * from, task_t * to) {
+    syscall_set_kernel_stack(to->tss.esp0);
     switch_to_tss(to->tss_sel);
     // simple_switch(&from->stack, to->stack);
 }
@@ -183,9 +472,8 @@ void task_first_init (void) {
     // 第一个任务代码量小一些，好和栈放在1个页面呢
     // 这样就不要立即考虑还要给栈分配空间的问题
     task_init(&task_manager.first_task, "first task", 0, first_start, first_start + alloc_size);
-    task_manager.first_task.heap_start = (uint32_t)e_first_task;  // 这里不对
-    task_manager.first_task.heap_end = task_manager.first_task.heap_start;
-    task_manager.curr_task = &task_manager.first_task;
+    task_manager.first_task.mm->heap_start = (uint32_t)e_first_task;  // 这里不对
+    task_manager.first_task.mm->heap_end = task_manager.first_task.mm->heap_start;
 
     // 更新页表地址为自己的
     mmu_set_page_dir(task_manager.first_task.tss.cr3);
@@ -194,11 +482,17 @@ void task_first_init (void) {
     memory_alloc_page_for(first_start,  alloc_size, PTE_P | PTE_W | PTE_U);
     kernel_memcpy((void *)first_start, (void *)&s_first_task, copy_size);
 
-    // 启动进程
-    task_start(&task_manager.first_task);
     // 写TR寄存器，指示当前运行的第一个任务
     write_tr(task_manager.first_task.tss_sel);
-
+    syscall_set_kernel_stack(task_manager.first_task.tss.esp0);
+
+    // 固定在BSP上启动，先设为当前任务，防止被其它CPU取走
+    irq_state_t state = task_lock();
+    cpu_t * cpu = smp_cpu(0);
+    task_manager.first_task.cpu = cpu;
+    cpu->curr_task = &task_manager.first_task;
+    task_set_ready(&task_manager.first_task);
+    task_unlock(state);
 }
 
 /**
@@ -221,46 +515,144 @@ static void idle_task_entry (void) {
  * @brief 任务管理器初始化
  */
 void task_manager_init (void) {
-    kernel_memset(task_table, 0, sizeof(task_table));
-    mutex_init(&task_table_mutex);
-
-    //数据段和代码段，使用DPL3，所有应用共用同一个
-    //为调试方便，暂时使用DPL0
-    int sel = gdt_alloc_desc();
-    segment_desc_set(sel, 0x00000000, 0xFFFFFFFF,
-                     SEG_P_PRESENT | SEG_DPL3 | SEG_S_NORMAL |
-                     SEG_TYPE_DATA | SEG_TYPE_RW | SEG_D);
-    task_manager.app_data_sel = sel;
+    mem_cache_init(&task_cache, "task", sizeof(task_t), __alignof__(task_t), TASK_NR);
+    mem_cache_init(&mm_cache, "mm", sizeof(task_mm_t), __alignof__(task_mm_t), TASK_NR);
+    mem_cache_init(&files_cache, "files", sizeof(task_files_t), __alignof__(task_files_t), TASK_NR);
 
-    sel = gdt_alloc_desc();
-    segment_desc_set(sel, 0x00000000, 0xFFFFFFFF,
-                     SEG_P_PRESENT | SEG_DPL3 | SEG_S_NORMAL |
-                     SEG_TYPE_CODE | SEG_TYPE_RW | SEG_D);
-    task_manager.app_code_sel = sel;
+    // 数据段和代码段，使用DPL3，所有应用共用同一个，已在GDT初始化时设置好
+    task_manager.app_data_sel = APP_SELECTOR_DS;
+    task_manager.app_code_sel = APP_SELECTOR_CS;
 
     // 各队列初始化
-    list_init(&task_manager.ready_list);
+    spinlock_init(&task_manager.lock);
     list_init(&task_manager.task_list);
     list_init(&task_manager.sleep_list);
 
-    // 空闲任务初始化
-    task_init(&task_manager.idle_task,
-                "idle task",
-                TASK_FLAG_SYSTEM,
+    bitmap_init(&pid_bitmap, pid_bits, TASK_PID_MAX, 0);
+    bitmap_set_bit(&pid_bitmap, 0, 1, 1);
+    pid_last = 0;
+    for (int i = 0; i < TASK_PID_HASH_SIZE; i++) {
+        list_init(pid_hash + i);
+    }
+
+    // 每个CPU的空闲任务初始化，空闲任务不进入就绪队列
+    // AP启动后直接以空闲任务的身份运行，BSP的空闲任务在首次调度时从入口开始运行
+    for (int i = 0; i < smp_cpu_count(); i++) {
+        task_t * idle = task_manager.idle_task + i;
+        task_init(idle, "idle task", TASK_FLAG_SYSTEM | TASK_FLAG_KERNEL,
                 (uint32_t)idle_task_entry,
                 0);     // 运行于内核模式，无需指定特权级3的栈
 
-    task_manager.curr_task = (task_t *)0;
-    task_start(&task_manager.idle_task);
+        cpu_t * cpu = smp_cpu(i);
+        idle->cpu = cpu;
+        cpu->idle_task = idle;
+    }
+}
+
+/**
+ * @brief 实时任务a是否应排在b之前运行
+ * DEADLINE任务优先于FIFO任务，之间按截止时间排序；FIFO任务按优先级排序
+ */
+static int task_rt_before (task_t * a, task_t * b) {
+    if (a->policy != b->policy) {
+        return a->policy == TASK_SCHED_DEADLINE;
+    }
+
+    if (a->policy == TASK_SCHED_DEADLINE) {
+        return (int32_t)(a->dl_deadline - b->dl_deadline) < 0;
+    }
+    return a->rt_priority > b->rt_priority;
+}
+
+/**
+ * @brief 任务是否应抢占正在运行的任务，实时任务总是抢占普通任务
+ */
+static int task_preempts (task_t * task, task_t * curr) {
+    if (task->policy == TASK_SCHED_NORMAL) {
+        return 0;
+    } else if (curr->policy == TASK_SCHED_NORMAL) {
+        return 1;
+    }
+    return task_rt_before(task, curr);
+}
+
+/**
+ * @brief 任务所在的就绪队列
+ */
+static list_t * task_run_list (task_t * task) {
+    return (task->policy == TASK_SCHED_NORMAL) ? &task->cpu->ready_list : &task->cpu->rt_list;
+}
+
+/**
+ * @brief 任务是否在就绪队列中，队列中只有它一个时前后结点都为空，须另外判断
+ */
+static int task_is_queued (task_t * task) {
+    return (task->state == TASK_READY) && (task->run_node.pre || task->run_node.next
+            || (list_first(task_run_list(task)) == &task->run_node));
+}
+
+/**
+ * @brief 通知其它CPU有任务可运行
+ * 目标CPU空闲或应被抢占时直接让其重新调度；否则若队列中有等待的任务，让某个空闲的CPU来取走
+ */
+static void task_kick (task_t * task) {
+    cpu_t * cpu = task->cpu;
+    cpu_t * curr = cpu_current();
+    if (cpu != curr) {
+        if (cpu->started && ((cpu->curr_task == cpu->idle_task) || task_preempts(task, cpu->curr_task))) {
+            smp_send_resched(cpu);
+            return;
+        }
+    }
+
+    if (list_count(&cpu->ready_list) < 2) {
+        return;
+    }
+
+    for (int i = 0; i < smp_cpu_count(); i++) {
+        cpu_t * other = smp_cpu(i);
+        if ((other != curr) && (other != cpu) && other->started
+                && (other->curr_task == other->idle_task) && (list_count(&other->ready_list) == 0)) {
+            smp_send_resched(other);
+            break;
+        }
+    }
 }
 
 /**
- * @brief 将任务插入就绪队列
+ * @brief 将实时任务按顺序插入所在CPU的实时队列
+ * 同优先级的排在后面，先到先运行。DEADLINE任务的截止时间已过时开始新的周期
+ */
+static void task_rt_enqueue (task_t * task) {
+    if (task->policy == TASK_SCHED_DEADLINE) {
+        uint32_t now = time_get_ticks();
+        if ((int32_t)(now - task->dl_deadline) >= 0) {
+            task->dl_deadline = now + task->dl_period;
+            task->dl_left = task->dl_runtime;
+        }
+    }
+
+    list_t * list = &task->cpu->rt_list;
+    list_node_t * node = list_first(list);
+    while (node && !task_rt_before(task, list_node_parent(node, task_t, run_node))) {
+        node = list_node_next(node);
+    }
+    list_insert_before(list, node, &task->run_node);
+}
+
+/**
+ * @brief 将任务插入所在CPU的就绪队列
  */
 void task_set_ready(task_t *task) {
-    if (task != &task_manager.idle_task) {
-        list_insert_last(&task_manager.ready_list, &task->run_node);
+    if (task != task->cpu->idle_task) {
+        if (task->policy == TASK_SCHED_NORMAL) {
+            list_insert_last(&task->cpu->ready_list, &task->run_node);
+        } else {
+            task_rt_enqueue(task);
+        }
         task->state = TASK_READY;
+        schedstat_wakeup(task);
+        task_kick(task);
     }
 }
 
@@ -268,21 +660,66 @@ void task_set_ready(task_t *task) {
  * @brief 将任务从就绪队列移除
  */
 void task_set_block (task_t *task) {
-    if (task != &task_manager.idle_task) {
-        list_remove(&task_manager.ready_list, &task->run_node);
+    if (task != task->cpu->idle_task) {
+        list_remove(task_run_list(task), &task->run_node);
     }
 }
+
+/**
+ * @brief 从其它CPU的就绪队列中取一个任务过来
+ * 自己空闲时取任意一个未运行的任务，否则仅在负载相差2个以上时才取，避免任务来回迁移
+ */
+static void task_steal (cpu_t * cpu) {
+    int count = list_count(&cpu->ready_list);
+
+    cpu_t * busiest = (cpu_t *)0;
+    for (int i = 0; i < smp_cpu_count(); i++) {
+        cpu_t * other = smp_cpu(i);
+        if ((other != cpu) && other->started
+                && (!busiest || (list_count(&other->ready_list) > list_count(&busiest->ready_list)))) {
+            busiest = other;
+        }
+    }
+
+    if (!busiest) {
+        return;
+    }
+
+    int max = list_count(&busiest->ready_list);
+    if (count ? (max - count < 2) : (max == 0)) {
+        return;
+    }
+
+    // 正在其它CPU上运行的任务不能取
+    for (list_node_t * node = list_first(&busiest->ready_list); node; node = list_node_next(node)) {
+        task_t * task = list_node_parent(node, task_t, run_node);
+        if (task != busiest->curr_task) {
+            list_remove(&busiest->ready_list, node);
+            task->cpu = cpu;
+            list_insert_last(&cpu->ready_list, node);
+            return;
+        }
+    }
+}
+
 /**
  * @brief 获取下一将要运行的任务
  */
-static task_t * task_next_run (void) {
+static task_t * task_next_run (cpu_t * cpu) {
+    task_steal(cpu);
+
+    // 实时任务总是优先于普通任务
+    if (list_count(&cpu->rt_list)) {
+        return list_node_parent(list_first(&cpu->rt_list), task_t, run_node);
+    }
+
     // 如果没有任务，则运行空闲任务
-    if (list_count(&task_manager.ready_list) == 0) {
-        return &task_manager.idle_task;
+    if (list_count(&cpu->ready_list) == 0) {
+        return cpu->idle_task;
     }
     
     // 普通任务
-    list_node_t * task_node = list_first(&task_manager.ready_list);
+    list_node_t * task_node = list_first(&cpu->ready_list);
     // 寻找任务控制块返回，涉及指针转换
     return list_node_parent(task_node, task_t, run_node);
 }
@@ -313,7 +750,7 @@ void task_set_wakeup (task_t *task) {
  * @brief 获取当前正在运行的任务
  */
 task_t * task_current (void) {
-    return task_manager.curr_task;
+    return tss_task[read_tr() >> 3];
 }
 
 
@@ -321,8 +758,9 @@ task_t * task_current (void) {
  * @brief 获取当前进程指定的文件描述符
  */
 file_t * task_file (int fd) {
-    if ((fd >= 0) && (fd < TASK_OFILE_NR)) {
-        file_t * file = task_current()->file_table[fd];
+    task_files_t * files = task_current()->files;
+    if (files && (fd >= 0) && (fd < TASK_OFILE_NR)) {
+        file_t * file = files->file_table[fd];
         return file;
     }
 
@@ -331,37 +769,60 @@ file_t * task_file (int fd) {
 
 /**
  * @brief 为指定的file分配一个新的文件id
+ * 文件表可能由多个线程共用，分配时要加锁
  */
 int task_alloc_fd (file_t * file) {
-    task_t * task = task_current();
+    task_files_t * files = task_current()->files;
+    if (files == (task_files_t *)0) {
+        return -1;
+    }
 
+    irq_state_t state = spin_lock_irqsave(&files->lock);
     for (int i = 0; i < TASK_OFILE_NR; i++) {
-        file_t * p = task->file_table[i];
+        file_t * p = files->file_table[i];
         if (p == (file_t *)0) {
-            task->file_table[i] = file;
+            files->file_table[i] = file;
+            spin_unlock_irqrestore(&files->lock, state);
             return i;
         }
     }
+    spin_unlock_irqrestore(&files->lock, state);
 
     return -1;
 }
 
+/**
+ * @brief 从文件表中取出fd对应的file，并清空该项
+ * 多个线程同时关闭同一fd时只有一个能取到
+ */
+file_t * task_take_fd (int fd) {
+    task_files_t * files = task_current()->files;
+    if (!files || (fd < 0) || (fd >= TASK_OFILE_NR)) {
+        return (file_t *)0;
+    }
+
+    irq_state_t state = spin_lock_irqsave(&files->lock);
+    file_t * file = files->file_table[fd];
+    files->file_table[fd] = (file_t *)0;
+    spin_unlock_irqrestore(&files->lock, state);
+    return file;
+}
+
 /**
  * @brief 移除任务中打开的文件fd
  */
 void task_remove_fd (int fd) {
-    if ((fd >= 0) && (fd < TASK_OFILE_NR)) {
-        task_current()->file_table[fd] = (file_t *)0;
-    }
+    task_take_fd(fd);
 }
 
 /**
  * @brief 当前任务主动放弃CPU
  */
 int sys_yield (void) {
-    irq_state_t state = irq_enter_protection();
+    irq_state_t state = task_lock();
 
-    if (list_count(&task_manager.ready_list) > 1) {
+    cpu_t * cpu = cpu_current();
+    if (list_count(&cpu->ready_list) + list_count(&cpu->rt_list) > 1) {
         task_t * curr_task = task_current();
 
         // 如果队列中还有其它任务，则将当前任务移入到队列尾部
@@ -372,34 +833,73 @@ int sys_yield (void) {
         // 由于某些原因运行后阻塞或删除，再回到这里切换将发生问题
         task_dispatch();
     }
-    irq_leave_protection(state);
+    task_unlock(state);
 
     return 0;
 }
 
 /**
- * @brief 进行一次任务调度
+ * @brief 进行一次任务调度，调用前需持有调度锁
+ * 软中断处理期间只做标记，等到中断返回前再切换
  */
 void task_dispatch (void) {
-    task_t * to = task_next_run();
-    if (to != task_manager.curr_task) {
-        task_t * from = task_manager.curr_task;
-        task_manager.curr_task = to;
+    cpu_t * cpu = cpu_current();
+    if (cpu->softirq_active) {
+        cpu->need_resched = 1;
+        return;
+    }
+
+    cpu->need_resched = 0;
+    task_t * to = task_next_run(cpu);
+    if (to != cpu->curr_task) {
+        task_t * from = cpu->curr_task;
+        cpu->curr_task = to;
+        schedstat_run(to);
+        trace_event(TRACE_CLASS_SCHED, TRACE_SCHED_SWITCH, to->pid, from->state);
+
+        // 切出时仍在就绪队列中的是被抢占的，否则是主动睡眠或等待
+        if (from != cpu->idle_task) {
+            if (task_is_queued(from)) {
+                from->usage.nivcsw++;
+            } else {
+                from->usage.nvcsw++;
+            }
+        }
 
+        // 切出的任务可能在其它CPU上恢复，FPU状态不能留在本CPU的寄存器中
+        fpu_task_switch_out(from);
         task_switch_from_to(from, to);
     }
 }
 
 /**
  * @brief 时间处理
- * 该函数在中断处理函数中调用
+ * 该函数在定时器软中断中调用，切换推迟到中断返回前进行
  */
 void task_time_tick (void) {
-    task_t * curr_task = task_current();
-
-    // 时间片的处理
-    irq_state_t state = irq_enter_protection();
-    if (--curr_task->slice_ticks == 0) {
+    irq_state_t state = task_lock();
+    cpu_t * cpu = cpu_current();
+    task_t * curr_task = cpu->curr_task;
+
+    // 计入中断时记下的运行时间，空闲任务的时间即CPU的空闲时间
+    curr_task->usage.utime += cpu->pending_utime;
+    curr_task->usage.stime += cpu->pending_stime;
+    cpu->pending_utime = cpu->pending_stime = 0;
+
+    // DEADLINE任务本周期的运行时间用完，推迟到截止时间，届时开始新的周期
+    if (curr_task->policy == TASK_SCHED_DEADLINE) {
+        if ((curr_task->state == TASK_READY) && (--curr_task->dl_left <= 0)) {
+            task_set_block(curr_task);
+
+            int wait = (int)(curr_task->dl_deadline - time_get_ticks());
+            if (wait > 0) {
+                task_set_sleep(curr_task, wait);
+            } else {
+                task_set_ready(curr_task);
+            }
+        }
+    } else if ((curr_task->policy == TASK_SCHED_NORMAL) && (--curr_task->slice_ticks == 0)) {
+        // 时间片的处理，FIFO任务不轮转
         // 时间片用完，重新加载时间片
         // 对于空闲任务，此处减未用
         curr_task->slice_ticks = curr_task->time_slice;
@@ -409,8 +909,11 @@ void task_time_tick (void) {
         task_set_ready(curr_task);
     }
     
-    // 睡眠处理
-    list_node_t * curr = list_first(&task_manager.sleep_list);
+    // 睡眠处理，延时队列是全局的，只在BSP上处理，负载同样
+    list_node_t * curr = (cpu->id == 0) ? list_first(&task_manager.sleep_list) : (list_node_t *)0;
+    if (cpu->id == 0) {
+        schedstat_tick();
+    }
     while (curr) {
         list_node_t * next = list_node_next(curr);
 
@@ -424,7 +927,7 @@ void task_time_tick (void) {
     }
 
     task_dispatch();
-    irq_leave_protection(state);
+    task_unlock(state);
 }
 
 
@@ -432,28 +935,124 @@ void task_time_tick (void) {
  * @brief 分配一个任务结构
  */
 static task_t * alloc_task (void) {
-    task_t * task = (task_t *)0;
+    task_t * task = (task_t *)mem_cache_alloc(&task_cache);
+    if (task) {
+        kernel_memset(task, 0, sizeof(task_t));
+    }
+    return task;
+}
 
-    mutex_lock(&task_table_mutex);
-    for (int i = 0; i < TASK_NR; i++) {
-        task_t * curr = task_table + i;
-        if (curr->name[0] == 0) {
-            task = curr;
+/**
+ * @brief 释放任务结构
+ */
+static void free_task (task_t * task) {
+    mem_cache_free(&task_cache, task);
+}
+
+/**
+ * @brief 回收已退出的内核线程或用户线程，在系统工作队列中执行
+ */
+static void task_reap (work_t * work) {
+    task_t * task = list_node_parent(work, task_t, exit_work);
+
+    // 线程加入工作后才切出，要等到切换完成才能释放其内核栈
+    for (;;) {
+        irq_state_t state = task_lock();
+        int dead = (task->state == TASK_ZOMBIE);
+        task_unlock(state);
+        if (dead) {
             break;
         }
+        sys_yield();
+    }
+
+    task_uninit(task);
+    free_task(task);
+}
+
+/**
+ * @brief 内核线程的入口，从返回后退出
+ */
+static void kthread_entry (void) {
+    task_t * task = task_current();
+    task->kthread_fn(task->kthread_arg);
+    kthread_exit();
+}
+
+/**
+ * @brief 创建并启动内核线程
+ * 线程运行在特权级0，使用内核页表和单独的一页内核栈，不能访问任何进程的用户空间
+ */
+task_t * kthread_create (const char * name, void (*fn)(void * arg), void * arg) {
+    task_t * task = alloc_task();
+    if (task == (task_t *)0) {
+        return (task_t *)0;
     }
-    mutex_unlock(&task_table_mutex);
 
+    int err = task_init(task, name, TASK_FLAG_KERNEL, (uint32_t)kthread_entry, 0);
+    if (err < 0) {
+        free_task(task);
+        return (task_t *)0;
+    }
+
+    task->kthread_fn = fn;
+    task->kthread_arg = arg;
+    work_init(&task->exit_work, task_reap);
+
+    task_start(task);
     return task;
 }
 
 /**
- * @brief 释放任务结构
+ * @brief 当前内核线程退出，资源交给工作队列回收
  */
-static void free_task (task_t * task) {
-    mutex_lock(&task_table_mutex);
-    task->name[0] = 0;
-    mutex_unlock(&task_table_mutex);
+void kthread_exit (void) {
+    task_t * task = task_current();
+    ASSERT(task->flags & TASK_FLAG_KERNEL);
+
+    fpu_task_exit(task);
+    schedule_work(&task->exit_work);
+
+    irq_state_t state = task_lock();
+    task->state = TASK_ZOMBIE;
+    task_set_block(task);
+    task_dispatch();
+    task_unlock(state);
+}
+
+/**
+ * @brief 当前任务睡眠指定的ns数
+ * 整数个tick的部分在睡眠队列中等待，不足一个tick的部分让出CPU并查询TSC，
+ * 因此精度不再受限于tick
+ */
+static void task_sleep_ns (uint64_t ns) {
+    uint64_t deadline = time_get_ns() + ns;
+
+    for (;;) {
+        uint64_t now = time_get_ns();
+        if (now >= deadline) {
+            break;
+        }
+
+        // 下一个tick可能马上就到，按向下取整计算，避免睡过头
+        uint64_t ticks = kernel_div64(deadline - now, TIME_NSEC_PER_TICK, (uint32_t *)0);
+        if (ticks == 0) {
+            sys_yield();
+            continue;
+        }
+
+        irq_state_t state = task_lock();
+
+        // 从就绪队列移除，加入睡眠队列
+        task_t * curr_task = task_current();
+        task_set_block(curr_task);
+        task_set_sleep(curr_task, ticks > 0x7FFFFFFF ? 0x7FFFFFFF : (uint32_t)ticks);
+
+        // 进行一次调度
+        task_dispatch();
+
+        task_unlock(state);
+    }
 }
 
 /**
@@ -462,22 +1061,27 @@ static void free_task (task_t * task) {
  * @param ms 
  */
 void sys_msleep (uint32_t ms) {
-    // 至少延时1个tick
-    if (ms < OS_TICK_MS) {
-        ms = OS_TICK_MS;
-    }
+    task_sleep_ns((uint64_t)ms * 1000000);
+}
 
-    irq_state_t state = irq_enter_protection();
+/**
+ * @brief 任务进入睡眠状态，精度为ns
+ */
+int sys_nanosleep (const time_spec_t * req, time_spec_t * rem) {
+    if (!req || (req->nsec >= TIME_NSEC_PER_SEC)) {
+        return -1;
+    }
 
-    // 从就绪队列移除，加入睡眠队列
-    task_set_block(task_manager.curr_task);
-    // 中断10ms一次触发，但为了用户更好的设置事件，这里做了处理，用户的1000会在这里降一次，所以睡眠定时的精度为10ms
-    task_set_sleep(task_manager.curr_task, (ms + (OS_TICK_MS - 1)) / OS_TICK_MS);
-    
-    // 进行一次调度
-    task_dispatch();
+    // 过大的秒数按最大值处理，避免乘法溢出
+    uint32_t sec = (req->sec >> 32) ? 0xFFFFFFFF : (uint32_t)req->sec;
+    task_sleep_ns((uint64_t)sec * TIME_NSEC_PER_SEC + req->nsec);
 
-    irq_leave_protection(state);
+    // 不会被中途唤醒，剩余时间总是0
+    if (rem) {
+        rem->sec = 0;
+        rem->nsec = 0;
+    }
+    return 0;
 }
 
 
@@ -488,18 +1092,18 @@ static void copy_opened_files(task_t * child_task) {
     task_t * parent = task_current();
 
     for (int i = 0; i < TASK_OFILE_NR; i++) {
-        file_t * file = parent->file_table[i];
+        file_t * file = parent->files->file_table[i];
         if (file) {
             file_inc_ref(file);
-            child_task->file_table[i] = parent->file_table[i];
+            child_task->files->file_table[i] = file;
         }
     }
 }
 
 /**
- * @brief 创建进程的副本
+ * @brief 创建进程的副本，flag为TASK_FLAG_VFORK时子进程共用父进程的地址空间
  */
-int sys_fork (void) {
+static int task_fork (int flag) {
     task_t * parent_task = task_current();
 
     // 分配任务结构
@@ -516,14 +1120,23 @@ int sys_fork (void) {
     int err = task_init(child_task,  parent_task->name, 0, frame->eip,
                         frame->esp + sizeof(uint32_t)*SYSCALL_PARAM_COUNT);
     if (err < 0) {
-        goto fork_failed;
+        free_task(child_task);
+        return -1;
     }
 
     // 拷贝打开的文件
     copy_opened_files(child_task);
 
+    // 子进程继承父进程的浮点状态
+    fpu_task_fork(parent_task, child_task);
+
     // 从父进程的栈中取部分状态，然后写入tss。
     // 注意检查esp, eip等是否在用户空间范围内，不然会造成page_fault
+    // cs和eflags由跳板代码通过iret加载，写入内核栈顶的启动帧中
+    task_start_frame_t * start = (task_start_frame_t *)(child_task->tss.esp0 - sizeof(task_start_frame_t));
+    start->cs = frame->cs;
+    start->eflags = frame->eflags;
+
     tss_t * tss = &child_task->tss;
     tss->eax = 0;                       // 子进程返回0
     tss->ebx = frame->ebx;
@@ -533,27 +1146,66 @@ int sys_fork (void) {
     tss->edi = frame->edi;
     tss->ebp = frame->ebp;
 
-    tss->cs = frame->cs;
     tss->ds = frame->ds;
     tss->es = frame->es;
     tss->fs = frame->fs;
     tss->gs = frame->gs;
-    tss->eflags = frame->eflags;
 
-    child_task->parent = parent_task;
+    // 线程局部存储的段不能共用，否则一方释放后另一方将无法使用
+    if (parent_task->tls_sel) {
+        if (task_set_tls(child_task, parent_task->tls_base) < 0) {
+            goto fork_failed;
+        }
+        tss->gs = child_task->tls_sel | SEG_RPL3;
+    }
 
-    // 复制父进程的内存空间到子进程
+    // 复制父进程的内存空间到子进程，vfork则直接共用父进程的地址空间
     // 复制前需要销毁原来创建的物理页表
-    memory_destroy_uvm(child_task->tss.cr3);
-    if ((child_task->tss.cr3 = memory_copy_uvm(parent_task->tss.cr3)) < 0) {
-        goto fork_failed;
+    task_mm_t * mm = child_task->mm;
+    if (flag & TASK_FLAG_VFORK) {
+        task_mm_put(mm);
+        child_task->mm = task_mm_get(parent_task->mm);
+        child_task->vfork_parent = parent_task;
+    } else {
+        memory_destroy_uvm(mm->page_dir);
+        if ((mm->page_dir = memory_copy_uvm(parent_task->mm->page_dir)) == 0) {
+            goto fork_failed;
+        }
+        mm->heap_start = parent_task->mm->heap_start;
+        mm->heap_end = parent_task->mm->heap_end;
+        mm->uring = parent_task->mm->uring;
     }
+    child_task->tss.cr3 = child_task->mm->page_dir;
 
+    // 加入父进程的子进程队列
+    irq_state_t state = task_lock();
+    child_task->parent = parent_task;
+    list_insert_last(&parent_task->child_list, &child_task->child_node);
+    task_unlock(state);
 
     // 将子进程任务加入就绪任务列表
+    int pid = child_task->pid;
     task_start(child_task);
-    // 创建成功，返回子进程的pid(任务块地址)
-    return child_task->pid;
+
+    // vfork的父进程挂起，直到子进程exec或退出后归还地址空间
+    // 子进程只能由父进程回收，等待期间child_task一直有效
+    if (flag & TASK_FLAG_VFORK) {
+        for (;;) {
+            state = task_lock();
+            if (child_task->vfork_parent == (task_t *)0) {
+                task_unlock(state);
+                break;
+            }
+
+            task_set_block(parent_task);
+            parent_task->state = TASK_WAITING;
+            task_dispatch();
+            task_unlock(state);
+        }
+    }
+
+    // 创建成功，返回子进程的pid
+    return pid;
 fork_failed:
     if (child_task) {
         task_uninit (child_task);
@@ -562,6 +1214,34 @@ fork_failed:
     return -1;
 }
 
+/**
+ * @brief 创建进程的副本
+ */
+int sys_fork (void) {
+    return task_fork(0);
+}
+
+/**
+ * @brief 创建子进程，子进程在exec或退出前与父进程共用地址空间，父进程在此期间挂起
+ * 省去了复制整个地址空间，适合创建后立即exec的场合
+ */
+int sys_vfork (void) {
+    return task_fork(TASK_FLAG_VFORK);
+}
+
+/**
+ * @brief vfork的子进程归还借用的地址空间，唤醒父进程，调用前需持有调度锁
+ */
+static void task_vfork_release (task_t * task) {
+    task_t * parent = task->vfork_parent;
+    if (parent) {
+        task->vfork_parent = (task_t *)0;
+        if (parent->state == TASK_WAITING) {
+            task_set_ready(parent);
+        }
+    }
+}
+
 /**
  * @brief 加载一个程序表头的数据到内存中
  */
@@ -612,7 +1292,7 @@ static int load_phdr(int file, Elf32_Phdr * phdr, uint32_t page_dir) {
 /**
  * @brief 加载elf文件到内存中
  */
-static uint32_t load_elf_file (task_t * task, const char * name, uint32_t page_dir) {
+static uint32_t load_elf_file (task_mm_t * mm, const char * name) {
     Elf32_Ehdr elf_hdr;
     Elf32_Phdr elf_phdr;
 
@@ -671,15 +1351,15 @@ static uint32_t load_elf_file (task_t * task, const char * name, uint32_t page_d
         }
 
         // 加载当前程序头
-        int err = load_phdr(file, &elf_phdr, page_dir);
+        int err = load_phdr(file, &elf_phdr, mm->page_dir);
         if (err < 0) {
             log_printf("load program hdr failed");
             goto load_failed;
         }
 
         // 简单起见，不检查了，以最后的地址为bss的地址
-        task->heap_start = elf_phdr.p_vaddr + elf_phdr.p_memsz;
-        task->heap_end = task->heap_start;
+        mm->heap_start = elf_phdr.p_vaddr + elf_phdr.p_memsz;
+        mm->heap_end = mm->heap_start;
    }
 
     sys_close(file);
@@ -734,45 +1414,61 @@ static int copy_args (char * to, uint32_t page_dir, int argc, char **argv) {
 }
 
 /**
- * @brief 加载一个进程
- * 这个比较复杂，argv/name/env都是原进程空间中的数据，execve中涉及到页表的切换
- * 在对argv和name进行处理时，会涉及到不同进程空间中数据的传递。
+ * @brief 将程序加载到指定地址空间中，分配用户栈并复制参数，返回入口地址，失败返回0
+ * 参数保存在栈顶之上预留的区域中，程序开始运行时的栈为MEM_TASK_STACK_TOP - MEM_TASK_ARG_SIZE
  */
-int sys_execve(char *name, char **argv, char **env) {
-    task_t * task = task_current();
-
-    // 后面会切换页表，所以先处理需要从进程空间取数据的情况
-    kernel_strncpy(task->name, get_file_name(name), TASK_NAME_SIZE);
-
-    // 现在开始加载了，先准备应用页表，由于所有操作均在内核区中进行，所以可以直接先切换到新页表
-    uint32_t old_page_dir = task->tss.cr3;
-    uint32_t new_page_dir = memory_create_uvm();
-    if (!new_page_dir) {
-        goto exec_failed;
-    }
-
-    // 加载elf文件到内存中。要放在开启新页表之后，这样才能对相应的内存区域写
-    uint32_t entry = load_elf_file(task, name, new_page_dir);    // 暂时置用task->name表示
+static uint32_t load_image (task_mm_t * mm, const char * name, char ** argv) {
+    // 加载elf文件到内存中
+    uint32_t page_dir = mm->page_dir;
+    uint32_t entry = load_elf_file(mm, name);
     if (entry == 0) {
-        goto exec_failed;
+        return 0;
     }
 
     // 准备用户栈空间，预留环境环境及参数的空间
     uint32_t stack_top = MEM_TASK_STACK_TOP - MEM_TASK_ARG_SIZE;    // 预留一部分参数空间
-    int err = memory_alloc_for_page_dir(new_page_dir,
+    int err = memory_alloc_for_page_dir(page_dir,
                             MEM_TASK_STACK_TOP - MEM_TASK_STACK_SIZE,
                             MEM_TASK_STACK_SIZE, PTE_P | PTE_U | PTE_W);
     if (err < 0) {
-        goto exec_failed;
+        return 0;
     }
 
     // 复制参数，写入到栈顶的后边
     int argc = strings_count(argv);
-    err = copy_args((char *)stack_top, new_page_dir, argc, argv);
+    err = copy_args((char *)stack_top, page_dir, argc, argv);
     if (err < 0) {
+        return 0;
+    }
+
+    return entry;
+}
+
+/**
+ * @brief 加载一个进程
+ * 这个比较复杂，argv/name/env都是原进程空间中的数据，execve中涉及到页表的切换
+ * 在对argv和name进行处理时，会涉及到不同进程空间中数据的传递。
+ */
+int sys_execve(char *name, char **argv, char **env) {
+    task_t * task = task_current();
+
+    // 后面会切换页表，所以先处理需要从进程空间取数据的情况
+    kernel_strncpy(task->name, get_file_name(name), TASK_NAME_SIZE);
+
+    // 现在开始加载了，先准备新的地址空间，加载时不需要切换页表
+    task_mm_t * old_mm = task->mm;
+    task_mm_t * new_mm = task_mm_create();
+    if (!new_mm) {
         goto exec_failed;
     }
 
+    // 加载程序，准备好栈和参数
+    uint32_t entry = load_image(new_mm, name, argv);
+    if (entry == 0) {
+        goto exec_failed;
+    }
+    uint32_t stack_top = MEM_TASK_STACK_TOP - MEM_TASK_ARG_SIZE;
+
     // 加载完毕，为程序的执行做必要准备
     // 注意，exec的作用是替换掉当前进程，所以只要改变当前进程的执行流即可
     // 当该进程恢复运行时，像完全重新运行一样，所以用户栈要设置成初始模式
@@ -781,35 +1477,162 @@ int sys_execve(char *name, char **argv, char **env) {
     frame->eip = entry;   // 点睛之笔
     frame->eax = frame->ebx = frame->ecx = frame->edx = 0;
     frame->esi = frame->edi = frame->ebp = 0;
-    frame->eflags = EFLAGS_DEFAULT| EFLAGS_IF;  // 段寄存器无需修改
+    frame->eflags = EFLAGS_DEFAULT| EFLAGS_IF;
+
+    // 新程序没有线程局部存储，gs恢复成普通的数据段
+    if (task->tls_sel) {
+        gdt_free_sel(task->tls_sel);
+        task->tls_sel = 0;
+        task->tls_base = 0;
+    }
+    frame->gs = task_manager.app_data_sel | SEG_RPL3;
 
     // 内核栈不用设置，保持不变，后面调用memory_destroy_uvm并不会销毁内核栈的映射。
     // 但用户栈需要更改, 同样要加上调用门的参数压栈空间
     frame->esp = stack_top - sizeof(uint32_t)*SYSCALL_PARAM_COUNT;
 
+    // 新程序从干净的浮点状态开始
+    fpu_task_reset(task);
+
     // 切换到新的页表
-    task->tss.cr3 = new_page_dir;
-    mmu_set_page_dir(new_page_dir);   // 切换至新的页表。由于不用访问原栈及数据，所以并无问题
+    task->mm = new_mm;
+    task->tss.cr3 = new_mm->page_dir;
+    mmu_set_page_dir(new_mm->page_dir);   // 切换至新的页表。由于不用访问原栈及数据，所以并无问题
 
-    // 调整页表，切换成新的，同时释放掉之前的
+    // 释放对原地址空间的引用
     // 当前使用的是内核栈，而内核栈并未映射到进程地址空间中，所以下面的释放没有问题
-    memory_destroy_uvm(old_page_dir);            // 再释放掉了原进程的内容空间
+    // vfork的子进程与父进程共用，引用不为0，不会销毁，同时唤醒父进程
+    task_mm_put(old_mm);
+
+    irq_state_t state = task_lock();
+    task_vfork_release(task);
+    task_unlock(state);
 
     // 当从系统调用中返回时，将切换至新进程的入口地址运行，并且进程能够获取参数
     // 注意，如果用户栈设置不当，可能导致返回后运行出现异常。可在gdb中使用nexti单步观察运行流程
     return  0;
 
 exec_failed:    // 必要的资源释放
-    if (new_page_dir) {
-        // 有页表空间切换，切换至旧页表，销毁新页表
-        task->tss.cr3 = old_page_dir;
-        mmu_set_page_dir(old_page_dir);
-        memory_destroy_uvm(new_page_dir);
+    if (new_mm) {
+        // 还未切换页表，直接销毁新的地址空间
+        task_mm_put(new_mm);
+    }
+
+    return -1;
+}
+
+
+/**
+ * @brief 直接从程序文件创建子进程，返回子进程的pid
+ * 子进程的地址空间由ELF文件建立，不复制父进程的内存，耗时与父进程的大小无关。
+ * 子进程继承父进程打开的文件，env暂不支持。
+ */
+int sys_spawn (const char * name, char ** argv, char ** env) {
+    task_t * parent_task = task_current();
+
+    task_t * child_task = alloc_task();
+    if (child_task == (task_t *)0) {
+        return -1;
+    }
+
+    // 入口在加载完成后才知道，先创建好空的地址空间
+    uint32_t stack_top = MEM_TASK_STACK_TOP - MEM_TASK_ARG_SIZE;
+    int err = task_init(child_task, get_file_name((char *)name), 0, 0, stack_top);
+    if (err < 0) {
+        free_task(child_task);
+        return -1;
     }
 
+    // 页表尚未使用，直接加载到其中
+    uint32_t entry = load_image(child_task->mm, name, argv);
+    if (entry == 0) {
+        goto spawn_failed;
+    }
+
+    // 不经过系统调用返回，直接从启动帧进入程序入口，栈无需预留调用门参数
+    task_start_frame_t * start = (task_start_frame_t *)(child_task->tss.esp0 - sizeof(task_start_frame_t));
+    start->eip = entry;
+
+    copy_opened_files(child_task);
+
+    irq_state_t state = task_lock();
+    child_task->parent = parent_task;
+    list_insert_last(&parent_task->child_list, &child_task->child_node);
+    task_unlock(state);
+
+    int pid = child_task->pid;
+    task_start(child_task);
+    return pid;
+
+spawn_failed:
+    task_uninit(child_task);
+    free_task(child_task);
     return -1;
 }
 
+/**
+ * @brief 创建与当前进程共用地址空间和打开文件的线程，返回线程的pid
+ * 线程从entry开始运行，使用调用者准备好的栈stack；tls非0时为线程设置线程局部存储。
+ * clear_tid非0时，线程退出时将其清0并唤醒在其上等待的线程，供pthread_join使用。
+ * 线程不加入子进程队列，退出后由工作队列回收。
+ */
+int sys_clone (uint32_t entry, uint32_t stack, uint32_t tls, int * clear_tid) {
+    task_t * parent_task = task_current();
+    if ((entry < MEMORY_TASK_BASE) || (stack < MEMORY_TASK_BASE)) {
+        return -1;
+    }
+
+    // 退出时由内核写入，须是本进程已映射的用户地址，否则可被用来改写内核内存
+    uint32_t tid_addr = (uint32_t)clear_tid;
+    if (clear_tid && ((tid_addr & 3) || !memory_user_mapped(parent_task->mm->page_dir, tid_addr))) {
+        return -1;
+    }
+
+    task_t * child_task = alloc_task();
+    if (child_task == (task_t *)0) {
+        return -1;
+    }
+
+    int err = task_init(child_task, parent_task->name, TASK_FLAG_THREAD, entry, stack);
+    if (err < 0) {
+        free_task(child_task);
+        return -1;
+    }
+
+    if (tls) {
+        if (task_set_tls(child_task, tls) < 0) {
+            task_uninit(child_task);
+            free_task(child_task);
+            return -1;
+        }
+        child_task->tss.gs = child_task->tls_sel | SEG_RPL3;
+    }
+
+    child_task->clear_tid = clear_tid;
+    work_init(&child_task->exit_work, task_reap);
+
+    int pid = child_task->pid;
+    task_start(child_task);
+    return pid;
+}
+
+/**
+ * @brief 设置当前任务的线程局部存储，系统调用返回后gs即指向base开始的区域
+ */
+int sys_set_tls (uint32_t base) {
+    task_t * task = task_current();
+    if (task->mm == (task_mm_t *)0) {
+        return -1;
+    }
+
+    if (task_set_tls(task, base) < 0) {
+        return -1;
+    }
+
+    syscall_frame_t * frame = (syscall_frame_t *)(task->tss.esp0 - sizeof(syscall_frame_t));
+    frame->gs = task->tls_sel | SEG_RPL3;
+    return 0;
+}
 
 /**
  * 返回任务的pid
@@ -819,45 +1642,99 @@ int sys_getpid (void) {
     return curr_task->pid;
 }
 
+/**
+ * @brief 将一个队列中的子进程全部转给新的父进程，调用前需持有调度锁
+ */
+static int task_move_children (list_t * from, list_t * to, task_t * parent) {
+    int count = list_count(from);
+
+    list_node_t * node;
+    while ((node = list_remove_first(from)) != (list_node_t *)0) {
+        task_t * task = list_node_parent(node, task_t, child_node);
+        task->parent = parent;
+        list_insert_last(to, node);
+    }
+    return count;
+}
+
+/**
+ * @brief 累加统计
+ */
+static void task_usage_add (task_usage_t * to, task_usage_t * from) {
+    to->utime += from->utime;
+    to->stime += from->stime;
+    to->nvcsw += from->nvcsw;
+    to->nivcsw += from->nivcsw;
+    to->faults += from->faults;
+}
+
 /**
  * @brief 等待子进程退出
+ * pid大于0时等待指定的子进程，否则等待任意子进程。没有符合条件的子进程时返回-1，
+ * 设置TASK_WNOHANG且子进程都未退出时返回0
  */
-int sys_wait(int* status) {
+int sys_waitpid(int pid, int * status, int options) {
     task_t * curr_task = task_current();
 
     for (;;) {
-        // 遍历，找僵尸状态的进程，然后回收。如果收不到，则进入睡眠态
-        mutex_lock(&task_table_mutex);
-        for (int i = 0; i < TASK_NR; i++) {
-            task_t * task = task_table + i;
-            if (task->parent != curr_task) {
-                continue;
+        irq_state_t state = task_lock();
+
+        // 只在本进程的子进程队列中查找，与系统中的进程总数无关
+        task_t * zombie = (task_t *)0;
+        int has_child;
+        if (pid > 0) {
+            task_t * task = task_find_pid(pid);
+            has_child = task && (task->parent == curr_task);
+            if (has_child && (task->state == TASK_ZOMBIE)) {
+                zombie = task;
             }
+        } else {
+            has_child = list_count(&curr_task->child_list) || list_count(&curr_task->zombie_list);
+            list_node_t * node = list_first(&curr_task->zombie_list);
+            if (node) {
+                zombie = list_node_parent(node, task_t, child_node);
+            }
+        }
 
-            if (task->state == TASK_ZOMBIE) {
-                int pid = task->pid;
+        if (zombie) {
+            // 进入僵尸状态与切出是在持有调度锁时完成的，这里已可以安全回收
+            list_remove(&curr_task->zombie_list, &zombie->child_node);
+            task_unlock(state);
 
-                *status = task->status;
+            int zombie_pid = zombie->pid;
+            if (status) {
+                *status = zombie->status;
+            }
 
-                memory_destroy_uvm(task->tss.cr3);
-                memory_free_page(task->tss.esp0 - MEM_PAGE_SIZE);
-                kernel_memset(task, 0, sizeof(task_t));
+            // 子进程及其已回收的后代的统计累加到父进程
+            task_usage_add(&curr_task->child_usage, &zombie->usage);
+            task_usage_add(&curr_task->child_usage, &zombie->child_usage);
 
-                mutex_unlock(&task_table_mutex);
-                return pid;
-            }
+            task_uninit(zombie);
+            free_task(zombie);
+            return zombie_pid;
         }
-        mutex_unlock(&task_table_mutex);
 
-        // 找不到，则等待
-        irq_state_t state = irq_enter_protection();
+        if (!has_child || (options & TASK_WNOHANG)) {
+            task_unlock(state);
+            return has_child ? 0 : -1;
+        }
+
+        // 等待子进程退出时唤醒
         task_set_block(curr_task);
         curr_task->state = TASK_WAITING;
         task_dispatch();
-        irq_leave_protection(state);
+        task_unlock(state);
     }
 }
 
+/**
+ * @brief 等待任意子进程退出
+ */
+int sys_wait(int* status) {
+    return sys_waitpid(-1, status, 0);
+}
+
 /**
  * @brief 退出进程
  */
@@ -865,47 +1742,61 @@ void sys_exit(int status) {
     task_t * curr_task = task_current();
 
     // 关闭所有已经打开的文件, 标准输入输出库会由newlib自行关闭，但这里仍然再处理下
-    for (int fd = 0; fd < TASK_OFILE_NR; fd++) {
-        file_t * file = curr_task->file_table[fd];
-        if (file) {
-            sys_close(fd);
-            curr_task->file_table[fd] = (file_t *)0;
+    // 文件表与其它线程共用时，只释放引用
+    task_files_put(curr_task);
+
+    // 释放FPU的占用
+    fpu_task_exit(curr_task);
+
+    // 线程退出时通知等待的线程，然后由工作队列回收，不经过父进程
+    int is_thread = curr_task->flags & TASK_FLAG_THREAD;
+    if (is_thread) {
+        // 期间应用可能已释放该页，写入前再检查一次
+        uint32_t tid_addr = (uint32_t)curr_task->clear_tid;
+        if (tid_addr && memory_user_mapped(curr_task->mm->page_dir, tid_addr)) {
+            *curr_task->clear_tid = 0;
+            sys_futex((uint32_t *)curr_task->clear_tid, FUTEX_WAKE, 0x7FFFFFFF);
         }
+        schedule_work(&curr_task->exit_work);
     }
 
-    int move_child = 0;
+    irq_state_t state = task_lock();
 
-    // 找所有的子进程，将其转交给init进程
-    mutex_lock(&task_table_mutex);
-    for (int i = 0; i < TASK_OFILE_NR; i++) {
-        task_t * task = task_table + i;
-        if (task->parent == curr_task) {
-            // 有子进程，则转给init_task
-            task->parent = &task_manager.first_task;
-
-            // 如果子进程中有僵尸进程，唤醒回收资源
-            // 并不由自己回收，因为自己将要退出
-            if (task->state == TASK_ZOMBIE) {
-                move_child = 1;
-            }
-        }
+    // 归还DEADLINE任务占用的带宽，策略保持不变，以便从所在的队列中移除
+    if (curr_task->dl_bw) {
+        curr_task->cpu->dl_bw -= curr_task->dl_bw;
+        curr_task->dl_bw = 0;
     }
-    mutex_unlock(&task_table_mutex);
 
-    irq_state_t state = irq_enter_protection();
+    // 所有的子进程转交给init进程，已退出的由init回收
+    task_t * init_task = &task_manager.first_task;
+    task_move_children(&curr_task->child_list, &init_task->child_list, init_task);
+    int move_zombie = task_move_children(&curr_task->zombie_list, &init_task->zombie_list, init_task);
 
-    // 如果有移动子进程，则唤醒init进程
-    task_t * parent = curr_task->parent;
-    if (move_child && (parent != &task_manager.first_task)) {  // 如果父进程为init进程，在下方唤醒
-        if (task_manager.first_task.state == TASK_WAITING) {
-            task_set_ready(&task_manager.first_task);
-        }
+    // 有僵尸进程转给了init，唤醒init回收
+    if (move_zombie && (init_task->state == TASK_WAITING)) {
+        task_set_ready(init_task);
     }
 
-    // 如果有父任务在wait，则唤醒父任务进行回收
-    // 如果父进程没有等待，则一直处理僵死状态？
+    if (is_thread) {
+        curr_task->status = status;
+        curr_task->state = TASK_ZOMBIE;
+        task_set_block(curr_task);
+        task_dispatch();
+        task_unlock(state);
+        return;
+    }
+
+    // 移到父进程的僵尸队列中，等待父进程回收
+    task_t * parent = curr_task->parent;
+    list_remove(&parent->child_list, &curr_task->child_node);
+    list_insert_last(&parent->zombie_list, &curr_task->child_node);
+
+    // 如果有父任务在wait，则唤醒父任务进行回收；vfork的父进程也在这里唤醒
+    // 地址空间仍被父进程引用，task_uninit时不会销毁
+    task_vfork_release(curr_task);
     if (parent->state == TASK_WAITING) {
-        task_set_ready(curr_task->parent);
+        task_set_ready(parent);
     }
 
     // 保存返回值，进入僵尸状态
@@ -914,5 +1805,165 @@ void sys_exit(int status) {
     task_set_block(curr_task);
     task_dispatch();
 
-    irq_leave_protection(state);
+    task_unlock(state);
+}
+
+/**
+ * @brief 获取本进程及已回收子进程的运行时间，返回启动以来的tick数
+ */
+int sys_times (task_times_t * times) {
+    task_t * curr_task = task_current();
+
+    if (times) {
+        irq_state_t state = task_lock();
+        times->utime = curr_task->usage.utime;
+        times->stime = curr_task->usage.stime;
+        times->cutime = curr_task->child_usage.utime;
+        times->cstime = curr_task->child_usage.stime;
+        task_unlock(state);
+    }
+    return (int)time_get_ticks();
+}
+
+/**
+ * @brief 获取本进程或已回收子进程的资源使用统计
+ */
+int sys_getrusage (int who, task_usage_t * usage) {
+    task_t * curr_task = task_current();
+
+    if (!usage) {
+        return -1;
+    }
+
+    irq_state_t state = task_lock();
+    if (who == TASK_RUSAGE_SELF) {
+        *usage = curr_task->usage;
+    } else if (who == TASK_RUSAGE_CHILDREN) {
+        *usage = curr_task->child_usage;
+    } else {
+        task_unlock(state);
+        return -1;
+    }
+    task_unlock(state);
+    return 0;
+}
+
+/**
+ * @brief 获取系统中各任务的信息，包括各CPU的空闲任务，返回填写的数量
+ */
+int sys_task_info (task_info_t * info, int count) {
+    if (!info || (count <= 0)) {
+        return -1;
+    }
+
+    int n = 0;
+    irq_state_t state = task_lock();
+    list_node_t * node = list_first(&task_manager.task_list);
+    while (node && (n < count)) {
+        task_t * task = list_node_parent(node, task_t, all_node);
+        task_info_t * curr = info + n++;
+
+        curr->pid = task->pid;
+        curr->ppid = task->parent ? task->parent->pid : 0;
+        curr->state = task->state;
+        curr->cpu = task->cpu ? task->cpu->id : -1;
+        kernel_strncpy(curr->name, task->name, TASK_INFO_NAME_SIZE);
+        curr->usage = task->usage;
+
+        node = list_node_next(node);
+    }
+    task_unlock(state);
+    return n;
+}
+
+/**
+ * @brief 设置任务的调度策略，pid为0时为当前任务
+ * DEADLINE任务需通过准入检查：同一CPU上所有DEADLINE任务的带宽之和不超过TASK_DL_BW_MAX。
+ * 实时任务固定在设置时所在的CPU上运行，不会被其它CPU取走
+ */
+int sys_sched_setattr (int pid, const task_sched_attr_t * attr) {
+    if (!attr) {
+        return -1;
+    }
+
+    // 转换成tick，运行时间向上取整，带宽按取整后的值计算
+    int policy = attr->policy;
+    uint32_t runtime = 0, period = 0, bw = 0;
+    switch (policy) {
+    case TASK_SCHED_NORMAL:
+        break;
+    case TASK_SCHED_FIFO:
+        if ((attr->priority < TASK_RT_PRIO_MIN) || (attr->priority > TASK_RT_PRIO_MAX)) {
+            return -1;
+        }
+        break;
+    case TASK_SCHED_DEADLINE:
+        runtime = (attr->runtime + OS_TICK_MS - 1) / OS_TICK_MS;
+        period = attr->period / OS_TICK_MS;
+        if ((runtime == 0) || (runtime > period)) {
+            return -1;
+        }
+        bw = (uint32_t)kernel_div64((uint64_t)runtime * TASK_DL_BW_SCALE, period, (uint32_t *)0);
+        break;
+    default:
+        return -1;
+    }
+
+    irq_state_t state = task_lock();
+    task_t * task = pid ? task_find_pid(pid) : task_current();
+    if (!task || !task->cpu || (task->flags & TASK_FLAG_SYSTEM) || (task->state == TASK_ZOMBIE)) {
+        task_unlock(state);
+        return -1;
+    }
+
+    cpu_t * cpu = task->cpu;
+    if (cpu->dl_bw - task->dl_bw + bw > TASK_DL_BW_MAX) {
+        task_unlock(state);
+        return -1;
+    }
+    cpu->dl_bw = cpu->dl_bw - task->dl_bw + bw;
+
+    // 在就绪队列中的先移出，修改后按新的策略重新插入
+    int queued = task_is_queued(task);
+    if (queued) {
+        task_set_block(task);
+    }
+
+    task->policy = policy;
+    task->rt_priority = (policy == TASK_SCHED_FIFO) ? attr->priority : 0;
+    task->dl_runtime = runtime;
+    task->dl_period = period;
+    task->dl_bw = bw;
+    task->dl_deadline = time_get_ticks();     // 下次就绪时开始新的周期
+    task->dl_left = 0;
+
+    if (queued) {
+        task_set_ready(task);
+    }
+    task_dispatch();
+    task_unlock(state);
+    return 0;
+}
+
+/**
+ * @brief 获取任务的调度策略，pid为0时为当前任务
+ */
+int sys_sched_getattr (int pid, task_sched_attr_t * attr) {
+    if (!attr) {
+        return -1;
+    }
+
+    irq_state_t state = task_lock();
+    task_t * task = pid ? task_find_pid(pid) : task_current();
+    if (!task) {
+        task_unlock(state);
+        return -1;
+    }
+
+    attr->policy = task->policy;
+    attr->priority = task->rt_priority;
+    attr->runtime = task->dl_runtime * OS_TICK_MS;
+    attr->period = task->dl_period * OS_TICK_MS;
+    task_unlock(state);
+    return 0;
 }
@@ -0,0 +1,157 @@
+/**
+ * 内核事件跟踪
+ * 每个CPU一个环形缓冲区，只有本CPU在关中断下写入，读取者之间用互斥锁串行，
+ * 写入者与读取者之间不加锁：写入者只修改tail，读取者只修改head，重新开始时也只移动head。
+ */
+#include "core/trace.h"
+#include "core/task.h"
+#include "core/memory.h"
+#include "cpu/irq.h"
+#include "cpu/cpu.h"
+#include "cpu/smp.h"
+#include "ipc/mutex.h"
+#include "comm/cpu_instr.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+#define TRACE_RING_PAGES        (up2(sizeof(trace_event_t) * TRACE_RING_SIZE, MEM_PAGE_SIZE) / MEM_PAGE_SIZE)
+
+/**
+ * @brief 每个CPU的事件缓冲区，head/tail为一直递增的计数
+ */
+typedef struct _trace_ring_t {
+    volatile uint32_t head;                 // 已取走的事件数，由读取者修改
+    volatile uint32_t tail;                 // 已写入的事件数，由写入者修改
+    uint32_t dropped;                       // 缓冲区满丢弃的事件数
+    trace_event_t * buf;
+}trace_ring_t;
+
+volatile uint32_t trace_mask;               // 启用的事件类
+static trace_ring_t trace_rings[SMP_CPU_MAX];
+static mutex_t trace_mutex;                 // 读取及设置之间互斥
+static int trace_tsc;                       // 是否可用TSC
+
+/**
+ * @brief 写入一条事件，可在中断中调用
+ */
+void trace_write (int type, uint32_t arg0, uint32_t arg1) {
+    irq_state_t state = irq_enter_protection();
+
+    // 调用前检查过事件类，期间跟踪可能已停止，之后缓冲区又被清空
+    if (!trace_mask) {
+        irq_leave_protection(state);
+        return;
+    }
+
+    task_t * task = task_current();
+    cpu_t * cpu = cpu_current();
+    trace_ring_t * ring = trace_rings + cpu->id;
+    uint32_t tail = ring->tail;
+    if (!ring->buf) {
+        // 还未分配缓冲区
+    } else if (tail - ring->head >= TRACE_RING_SIZE) {
+        ring->dropped++;
+    } else {
+        trace_event_t * event = ring->buf + (tail & (TRACE_RING_SIZE - 1));
+        event->tsc = trace_tsc ? rdtsc() : 0;
+        event->type = type;
+        event->cpu = cpu->id;
+        event->pid = task ? task->pid : 0;
+        event->arg0 = arg0;
+        event->arg1 = arg1;
+
+        // 写完内容再更新tail，x86不会重排两次写
+        __asm__ __volatile__("" ::: "memory");
+        ring->tail = tail + 1;
+    }
+
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 从中断入口调用，汇编中已检查过事件类
+ */
+void trace_irq (exception_frame_t * frame) {
+    trace_write(TRACE_IRQ, frame->num, frame->eip);
+}
+
+/**
+ * @brief 取走各CPU缓存的事件，只返回完整的记录
+ */
+int trace_read (char * buf, int size) {
+    int len = 0;
+
+    mutex_lock(&trace_mutex);
+    for (int i = 0; i < smp_cpu_count(); i++) {
+        trace_ring_t * ring = trace_rings + i;
+        if (!ring->buf) {
+            continue;
+        }
+
+        while ((len + (int)sizeof(trace_event_t) <= size) && (ring->head != ring->tail)) {
+            uint32_t head = ring->head;
+            kernel_memcpy(buf + len, ring->buf + (head & (TRACE_RING_SIZE - 1)), sizeof(trace_event_t));
+            __asm__ __volatile__("" ::: "memory");
+            ring->head = head + 1;
+            len += sizeof(trace_event_t);
+        }
+    }
+    mutex_unlock(&trace_mutex);
+    return len;
+}
+
+/**
+ * @brief 设置启用的事件类，开始跟踪时分配并清空缓冲区
+ */
+int trace_set_mask (uint32_t mask) {
+    int err = 0;
+
+    mutex_lock(&trace_mutex);
+    if (mask && !trace_mask) {
+        for (int i = 0; i < smp_cpu_count(); i++) {
+            trace_ring_t * ring = trace_rings + i;
+            if (!ring->buf) {
+                ring->buf = (trace_event_t *)memory_alloc_pages(TRACE_RING_PAGES);
+                if (!ring->buf) {
+                    err = -1;
+                    goto set_mask_end;
+                }
+            }
+            // tail只由写入者修改，丢弃已有的事件只需移动head
+            ring->head = ring->tail;
+            ring->dropped = 0;
+        }
+    } else if (!mask && trace_mask) {
+        uint32_t dropped = 0;
+        for (int i = 0; i < smp_cpu_count(); i++) {
+            dropped += trace_rings[i].dropped;
+        }
+        if (dropped) {
+            log_printf("trace: %d event(s) dropped", dropped);
+        }
+    }
+    trace_mask = mask;
+
+set_mask_end:
+    mutex_unlock(&trace_mutex);
+    return err;
+}
+
+/**
+ * @brief 停止跟踪，不统计丢弃数，可在持有自旋锁时调用
+ * 正在写入的事件会在下次开始时被丢弃，不会影响缓冲区
+ */
+void trace_stop (void) {
+    trace_mask = 0;
+}
+
+/**
+ * @brief 跟踪初始化
+ */
+void trace_init (void) {
+    mutex_init(&trace_mutex);
+
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    trace_tsc = (edx & CPUID_FEAT_EDX_TSC) != 0;
+}
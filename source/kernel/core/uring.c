@@ -0,0 +1,112 @@
+/**
+ * 批量系统调用的提交/完成队列
+ * 队列页是进程的普通用户页，fork时随地址空间复制，execve后失效。
+ * 请求在uring_enter中由调用者自己的上下文执行，可以像普通系统调用一样阻塞。
+ */
+#include "core/uring.h"
+#include "core/task.h"
+#include "core/memory.h"
+#include "cpu/mmu.h"
+#include "fs/fs.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+/**
+ * @brief 执行一个请求，返回值放入完成项
+ */
+static int uring_do (uring_sqe_t * sqe) {
+    switch (sqe->opcode) {
+    case URING_OP_NOP:
+        return 0;
+    case URING_OP_READ:
+        return sys_read(sqe->fd, (char *)sqe->addr, sqe->len);
+    case URING_OP_WRITE:
+        return sys_write(sqe->fd, (char *)sqe->addr, sqe->len);
+    case URING_OP_OPEN:
+        return sys_open((const char *)sqe->addr, sqe->len);
+    case URING_OP_CLOSE:
+        return sys_close(sqe->fd);
+    case URING_OP_MSLEEP:
+        sys_msleep(sqe->len);
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief 在当前进程中建立队列，返回队列的地址，已建立过则直接返回
+ * 分配页时可能睡眠，不能持有调度锁，用uring_busy防止多个线程同时建立，
+ * 另一线程正在建立时返回-1
+ */
+int sys_uring_setup (void) {
+    task_mm_t * mm = task_current()->mm;
+
+    irq_state_t state = task_lock();
+    uint32_t uring = mm->uring;
+    int busy = mm->uring_busy;
+    if (!uring && !busy) {
+        mm->uring_busy = 1;
+    }
+    task_unlock(state);
+    if (uring) {
+        return uring;
+    } else if (busy) {
+        return -1;
+    }
+
+    int err = memory_alloc_page_for(URING_ADDR, sizeof(uring_t), PTE_P | PTE_U | PTE_W);
+    if ((err < 0) || (memory_get_paddr(mm->page_dir, URING_ADDR) == 0)) {
+        log_printf("uring: alloc page failed.");
+        mm->uring_busy = 0;
+        return -1;
+    }
+
+    // 当前使用的就是该进程的页表，直接访问
+    kernel_memset((void *)URING_ADDR, 0, sizeof(uring_t));
+    mm->uring = URING_ADDR;
+    mm->uring_busy = 0;
+    return URING_ADDR;
+}
+
+/**
+ * @brief 依次执行提交队列中最多to_submit个请求，返回执行的请求数
+ * 完成队列满时提前停止，应用取走完成项后再次调用即可。
+ * 同一地址空间的线程共用队列，同时只允许一个线程处理
+ */
+int sys_uring_enter (int to_submit) {
+    task_mm_t * mm = task_current()->mm;
+    if (!mm->uring) {
+        return -1;
+    }
+
+    irq_state_t state = task_lock();
+    int busy = mm->uring_busy;
+    mm->uring_busy = 1;
+    task_unlock(state);
+    if (busy) {
+        return -1;
+    }
+
+    uring_t * ring = (uring_t *)mm->uring;
+    int count = 0;
+    while (count < to_submit) {
+        uint32_t head = ring->sq_head;
+        if ((head == ring->sq_tail) || (ring->cq_tail - ring->cq_head >= URING_CQ_ENTRIES)) {
+            break;
+        }
+
+        // 先复制出来，执行期间应用可能改写该项
+        uring_sqe_t sqe = ring->sqes[head & (URING_SQ_ENTRIES - 1)];
+        ring->sq_head = head + 1;
+
+        uring_cqe_t * cqe = ring->cqes + (ring->cq_tail & (URING_CQ_ENTRIES - 1));
+        cqe->user_data = sqe.user_data;
+        cqe->res = uring_do(&sqe);
+        ring->cq_tail++;
+        count++;
+    }
+
+    mm->uring_busy = 0;
+    return count;
+}
@@ -0,0 +1,123 @@
+/**
+ * 工作队列
+ * 每个队列有一个内核线程，按加入的顺序执行工作。加入工作可在中断中进行。
+ */
+#include "core/workqueue.h"
+#include "core/task.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+static workqueue_t system_wq;           // 系统公用的工作队列
+
+/**
+ * @brief 用于等待队列中已有工作完成的屏障
+ */
+typedef struct _wq_barrier_t {
+    work_t work;
+    sem_t done;
+}wq_barrier_t;
+
+/**
+ * @brief 初始化一项工作
+ */
+void work_init (work_t * work, work_func_t func) {
+    list_node_init(&work->node);
+    work->func = func;
+    work->pending = 0;
+}
+
+/**
+ * @brief 工作线程，依次取出工作执行
+ */
+static void worker_entry (void * arg) {
+    workqueue_t * wq = (workqueue_t *)arg;
+
+    for (;;) {
+        sem_wait(&wq->sem);
+
+        irq_state_t state = spin_lock_irqsave(&wq->lock);
+        list_node_t * node = list_remove_first(&wq->work_list);
+        work_t * work = list_node_parent(node, work_t, node);
+        work->pending = 0;
+        spin_unlock_irqrestore(&wq->lock, state);
+
+        // 执行期间可以再次加入队列
+        work->func(work);
+    }
+}
+
+/**
+ * @brief 创建工作队列及其工作线程
+ */
+int workqueue_create (workqueue_t * wq, const char * name) {
+    list_init(&wq->work_list);
+    spinlock_init(&wq->lock);
+    sem_init(&wq->sem, 0);
+
+    wq->thread = kthread_create(name, worker_entry, wq);
+    if (wq->thread == (task_t *)0) {
+        log_printf("create workqueue %s failed.", name);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 将工作加入队列，已在队列中时不重复加入
+ * @return 1表示加入，0表示已在队列中
+ */
+int queue_work (workqueue_t * wq, work_t * work) {
+    irq_state_t state = spin_lock_irqsave(&wq->lock);
+    if (work->pending) {
+        spin_unlock_irqrestore(&wq->lock, state);
+        return 0;
+    }
+
+    work->pending = 1;
+    list_insert_last(&wq->work_list, &work->node);
+    spin_unlock_irqrestore(&wq->lock, state);
+
+    sem_notify(&wq->sem);
+    return 1;
+}
+
+static void wq_barrier_func (work_t * work) {
+    wq_barrier_t * barrier = list_node_parent(work, wq_barrier_t, work);
+    sem_notify(&barrier->done);
+}
+
+/**
+ * @brief 等待此前加入的工作全部完成，不能在工作线程中调用
+ */
+void flush_workqueue (workqueue_t * wq) {
+    ASSERT(task_current() != wq->thread);
+
+    wq_barrier_t barrier;
+    work_init(&barrier.work, wq_barrier_func);
+    sem_init(&barrier.done, 0);
+
+    queue_work(wq, &barrier.work);
+    sem_wait(&barrier.done);
+}
+
+/**
+ * @brief 在系统工作队列中执行工作
+ */
+int schedule_work (work_t * work) {
+    return queue_work(&system_wq, work);
+}
+
+/**
+ * @brief 等待系统工作队列中的工作完成
+ */
+void flush_scheduled_work (void) {
+    flush_workqueue(&system_wq);
+}
+
+/**
+ * @brief 创建系统工作队列
+ */
+void workqueue_init (void) {
+    int err = workqueue_create(&system_wq, "kworker");
+    ASSERT(err == 0);
+}
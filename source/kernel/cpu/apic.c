@@ -0,0 +1,239 @@
+/**
+ * Local APIC与IOAPIC
+ * 使用时，外部中断经IOAPIC送到LAPIC，中断号和原来PIC的分配保持一致，
+ * EOI直接写LAPIC的寄存器，不再需要端口I/O。没有找到时继续使用PIC。
+ */
+#include "cpu/apic.h"
+#include "cpu/mp.h"
+#include "cpu/irq.h"
+#include "comm/cpu_instr.h"
+#include "core/memory.h"
+#include "dev/time.h"
+#include "tools/log.h"
+
+static int apic_on;                         // 是否启用了APIC
+static volatile uint32_t * lapic_base;      // 映射后的LAPIC寄存器
+static volatile uint32_t * ioapic_base;     // 映射后的IOAPIC寄存器
+static int ioapic_pin_count;                // IOAPIC的中断引脚数量
+static uint32_t lapic_timer_count;          // 定时器的初始计数值，AP使用同样的配置
+static int lapic_timer_irq;
+
+static inline uint32_t lapic_read (uint32_t reg) {
+    return lapic_base[reg >> 2];
+}
+
+static inline void lapic_write (uint32_t reg, uint32_t v) {
+    lapic_base[reg >> 2] = v;
+    (void)lapic_base[LAPIC_ID >> 2];        // 读一次，等待写完成
+}
+
+static inline uint32_t ioapic_read (uint32_t reg) {
+    ioapic_base[IOAPIC_REGSEL >> 2] = reg;
+    return ioapic_base[IOAPIC_WIN >> 2];
+}
+
+static inline void ioapic_write (uint32_t reg, uint32_t v) {
+    ioapic_base[IOAPIC_REGSEL >> 2] = reg;
+    ioapic_base[IOAPIC_WIN >> 2] = v;
+}
+
+/**
+ * @brief 是否使用APIC处理中断
+ */
+int apic_enabled (void) {
+    return apic_on;
+}
+
+/**
+ * @brief 获取当前CPU的LAPIC ID
+ */
+uint32_t lapic_id (void) {
+    return apic_on ? (lapic_read(LAPIC_ID) >> 24) : 0;
+}
+
+/**
+ * @brief 中断结束，写任意值即可
+ */
+void lapic_eoi (void) {
+    lapic_base[LAPIC_EOI >> 2] = 0;
+}
+
+/**
+ * @brief 伪中断，不需要发送EOI
+ */
+void do_handler_spurious (exception_frame_t * frame) {
+}
+
+/**
+ * @brief 将中断号转换为IOAPIC的引脚，ISA中断要考虑固件表中的重定向
+ */
+static int irq_to_pin (int irq_num, uint32_t * flags) {
+    mp_info_t * info = mp_info();
+
+    int irq = irq_num - IRQ_PIC_START;
+    uint32_t gsi = irq;
+    *flags = 0;
+    if (irq < MP_ISA_IRQ_NR) {
+        gsi = info->isa_irq[irq].gsi;
+        if ((info->isa_irq[irq].flags & MP_IRQ_POLARITY_MASK) == MP_IRQ_POLARITY_LOW) {
+            *flags |= IOAPIC_RED_ACTIVE_LOW;
+        }
+        if ((info->isa_irq[irq].flags & MP_IRQ_TRIGGER_MASK) == MP_IRQ_TRIGGER_LEVEL) {
+            *flags |= IOAPIC_RED_LEVEL;
+        }
+    }
+
+    int pin = gsi - info->ioapic_gsi_base;
+    return ((pin >= 0) && (pin < ioapic_pin_count)) ? pin : -1;
+}
+
+/**
+ * @brief 设置IOAPIC的重定向表项，发送给当前CPU
+ */
+static void ioapic_set (int irq_num, int masked) {
+    if (irq_num < IRQ_PIC_START) {
+        return;
+    }
+
+    uint32_t flags;
+    int pin = irq_to_pin(irq_num, &flags);
+    if (pin < 0) {
+        return;
+    }
+
+    uint32_t low = irq_num | flags | (masked ? IOAPIC_RED_MASKED : 0);
+    ioapic_write(IOAPIC_REG_REDTBL + pin * 2 + 1, lapic_id() << 24);
+    ioapic_write(IOAPIC_REG_REDTBL + pin * 2, low);
+}
+
+void ioapic_enable (int irq_num) {
+    ioapic_set(irq_num, 0);
+}
+
+void ioapic_disable (int irq_num) {
+    ioapic_set(irq_num, 1);
+}
+
+/**
+ * @brief 以周期模式启动LAPIC定时器，作为系统的tick
+ */
+int lapic_timer_start (int irq_num, uint32_t ms) {
+    if (!apic_on) {
+        return -1;
+    }
+
+    // 先以单次模式从最大值倒数，用PIT测出每ms的计数值
+    lapic_write(LAPIC_TIMER_DIV, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_TIMER_INIT, 0xFFFFFFFF);
+    time_pit_delay(LAPIC_TIMER_CALIBRATE_MS);
+    uint32_t count = (0xFFFFFFFF - lapic_read(LAPIC_TIMER_CURR)) / LAPIC_TIMER_CALIBRATE_MS;
+    lapic_write(LAPIC_TIMER_INIT, 0);
+    if (count == 0) {
+        return -1;
+    }
+
+    lapic_timer_irq = irq_num;
+    lapic_timer_count = count * ms;
+    lapic_write(LAPIC_LVT_TIMER, irq_num | LAPIC_TIMER_PERIODIC);
+    lapic_write(LAPIC_TIMER_INIT, lapic_timer_count);
+
+    log_printf("lapic timer: %d counts/ms", count);
+    return 0;
+}
+
+/**
+ * @brief 初始化当前CPU的LAPIC
+ */
+static void lapic_init (void) {
+    wrmsr(IA32_APIC_BASE_MSR, rdmsr(IA32_APIC_BASE_MSR) | IA32_APIC_BASE_ENABLE);
+
+    // 外部中断由IOAPIC送入，不再经过LINT0的PIC虚拟线
+    lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_ERROR, LAPIC_LVT_MASKED);
+
+    // 清除错误状态，需连续写两次
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_ESR, 0);
+
+    // 接收所有优先级的中断，软件使能LAPIC，并设置伪中断号
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | IRQ_SPURIOUS);
+    lapic_eoi();
+}
+
+/**
+ * @brief 向指定CPU发送处理器间中断
+ */
+void lapic_send_ipi (uint32_t apic_id, uint32_t cmd) {
+    irq_state_t state = irq_enter_protection();
+
+    lapic_write(LAPIC_ICR_HI, apic_id << 24);
+    lapic_write(LAPIC_ICR_LO, cmd);
+    while (lapic_read(LAPIC_ICR_LO) & LAPIC_ICR_PENDING) {}
+
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief AP上的LAPIC初始化，定时器直接使用BSP校准的结果
+ */
+void lapic_ap_init (void) {
+    lapic_init();
+
+    if (lapic_timer_count) {
+        lapic_write(LAPIC_TIMER_DIV, LAPIC_TIMER_DIV_16);
+        lapic_write(LAPIC_LVT_TIMER, lapic_timer_irq | LAPIC_TIMER_PERIODIC);
+        lapic_write(LAPIC_TIMER_INIT, lapic_timer_count);
+    }
+}
+
+/**
+ * @brief 初始化IOAPIC，所有中断先屏蔽，由irq_enable打开
+ */
+static void ioapic_init (void) {
+    ioapic_pin_count = ((ioapic_read(IOAPIC_REG_VER) >> 16) & 0xFF) + 1;
+
+    for (int i = 0; i < ioapic_pin_count; i++) {
+        ioapic_write(IOAPIC_REG_REDTBL + i * 2, IOAPIC_RED_MASKED | (IRQ_PIC_START + i));
+        ioapic_write(IOAPIC_REG_REDTBL + i * 2 + 1, 0);
+    }
+}
+
+/**
+ * @brief APIC初始化，需在内存管理初始化之后、开启任何中断之前调用
+ */
+void apic_init (void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_FEAT_EDX_APIC)) {
+        log_printf("no apic found, use pic.");
+        return;
+    }
+
+    mp_init();
+    mp_info_t * info = mp_info();
+    if (!info->found || !info->lapic_addr || !info->ioapic_addr) {
+        log_printf("no ioapic found, use pic.");
+        return;
+    }
+
+    lapic_base = (volatile uint32_t *)memory_map_mmio(info->lapic_addr, MEM_PAGE_SIZE);
+    ioapic_base = (volatile uint32_t *)memory_map_mmio(info->ioapic_addr, MEM_PAGE_SIZE);
+    if (!lapic_base || !ioapic_base) {
+        log_printf("map apic failed, use pic.");
+        return;
+    }
+
+    // 屏蔽PIC的所有中断，之后由APIC接管
+    outb(PIC0_IMR, 0xFF);
+    outb(PIC1_IMR, 0xFF);
+
+    irq_install(IRQ_SPURIOUS, (irq_handler_t)exception_handler_spurious);
+    lapic_init();
+    ioapic_init();
+    apic_on = 1;
+
+    log_printf("apic enabled: lapic id %d, ioapic pins %d", lapic_id(), ioapic_pin_count);
+}
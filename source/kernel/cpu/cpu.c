@@ -10,6 +10,7 @@
 
 static segment_desc_t gdt_table[GDT_TABLE_SIZE];
 static mutex_t mutex;
+static int gdt_free_head;           // 空闲表项链表，下一项的序号放在limit15_0中，0表示链表结束
 
 /**
  * 设置段描述符
@@ -41,31 +42,32 @@ void gate_desc_set(gate_desc_t * desc, uint16_t selector, uint32_t offset, uint1
 	desc->offset31_16 = (offset >> 16) & 0xffff;
 }
 
+/**
+ * 释放GDT表项，放回空闲链表头部
+ */
 void gdt_free_sel (int sel) {
     mutex_lock(&mutex);
-    gdt_table[sel / sizeof(segment_desc_t)].attr = 0;
+    segment_desc_t * desc = gdt_table + (sel / sizeof(segment_desc_t));
+    desc->attr = 0;
+    desc->limit15_0 = gdt_free_head;
+    gdt_free_head = sel / sizeof(segment_desc_t);
     mutex_unlock(&mutex);
 }
 
 /**
- * 分配一个GDT推荐表符
+ * 分配一个GDT表项，从空闲链表头部取出
  */
 int gdt_alloc_desc (void) {
-    int i;
-
     mutex_lock(&mutex);
-    
-    // 跳过第0项
-    for (i = 1; i < GDT_TABLE_SIZE; i++) {
+    int i = gdt_free_head;
+    if (i) {
         segment_desc_t * desc = gdt_table + i;
-        if (desc->attr == 0) {
-            desc->attr = SEG_P_PRESENT;     // 标记为占用状态
-            break;
-        }
+        gdt_free_head = desc->limit15_0;
+        desc->attr = SEG_P_PRESENT;     // 标记为占用状态
     }
     mutex_unlock(&mutex);
 
-    return i >= GDT_TABLE_SIZE ? -1 : i * sizeof(segment_desc_t);;
+    return i ? i * sizeof(segment_desc_t) : -1;
 }
 
 /**
@@ -85,13 +87,31 @@ void init_gdt(void) {
     segment_desc_set(KERNEL_SELECTOR_DS, 0x00000000, 0xFFFFFFFF,
                      SEG_P_PRESENT | SEG_DPL0 | SEG_S_NORMAL | SEG_TYPE_DATA
                      | SEG_TYPE_RW | SEG_D | SEG_G);
-    
+
+    // 应用的代码段和数据段，所有应用共用。sysexit按IA32_SYSENTER_CS+16和+24加载，位置不能变
+    segment_desc_set(APP_SELECTOR_CS, 0x00000000, 0xFFFFFFFF,
+                     SEG_P_PRESENT | SEG_DPL3 | SEG_S_NORMAL | SEG_TYPE_CODE
+                     | SEG_TYPE_RW | SEG_D | SEG_G);
+    segment_desc_set(APP_SELECTOR_DS, 0x00000000, 0xFFFFFFFF,
+                     SEG_P_PRESENT | SEG_DPL3 | SEG_S_NORMAL | SEG_TYPE_DATA
+                     | SEG_TYPE_RW | SEG_D | SEG_G);
+
     // 调用门
     gate_desc_set((gate_desc_t *)(gdt_table + (SELECTOR_SYSCALL >> 3)),
             KERNEL_SELECTOR_CS,
             (uint32_t)exception_handler_syscall,
             GATE_P_PRESENT | GATE_DPL3 | GATE_TYPE_SYSCALL | SYSCALL_PARAM_COUNT);
 
+    // 未使用的表项串成空闲链表，序号小的在前，第0项不使用
+    gdt_free_head = 0;
+    for (int i = GDT_TABLE_SIZE - 1; i > 0; i--) {
+        segment_desc_t * desc = gdt_table + i;
+        if (desc->attr == 0) {
+            desc->limit15_0 = gdt_free_head;
+            gdt_free_head = i;
+        }
+    }
+
     // 加载gdt
     lgdt((uint32_t)gdt_table, sizeof(gdt_table));
 }
@@ -109,6 +129,7 @@ void switch_to_tss (uint32_t tss_selector) {
  */
 void cpu_init (void) {
     mutex_init(&mutex);
+    mutex_set_name(&mutex, "gdt");
 
     init_gdt();
 }
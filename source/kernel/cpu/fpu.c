@@ -0,0 +1,187 @@
+/**
+ * FPU/SSE状态管理
+ * 采用延迟保存/恢复的方式：硬件任务切换时CPU会自动置位CR0.TS，
+ * 此后任务第一次执行FPU/SSE指令时产生#NM异常，在异常中才真正保存上一使用者的状态，
+ * 并恢复当前任务的状态。从不使用FPU的任务，切换时没有任何额外开销。
+ * 多处理器时，任务可能换到其它CPU上运行，所以切出时若寄存器中是该任务的状态，立即保存，
+ * 恢复仍然是延迟进行的。
+ */
+#include "comm/cpu_instr.h"
+#include "cpu/cpu.h"
+#include "cpu/irq.h"
+#include "cpu/fpu.h"
+#include "cpu/smp.h"
+#include "core/task.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+static int fpu_has_fxsr;                    // 是否支持FXSAVE/FXRSTOR
+static fpu_state_t fpu_init_state;          // 初始状态，任务首次使用FPU时加载
+
+static inline void fpu_save (fpu_state_t * state) {
+    if (fpu_has_fxsr) {
+        fxsave(state->data);
+    } else {
+        fnsave(state->data);
+    }
+}
+
+static inline void fpu_restore (fpu_state_t * state) {
+    if (fpu_has_fxsr) {
+        fxrstor(state->data);
+    } else {
+        frstor(state->data);
+    }
+}
+
+/**
+ * @brief 置位TS，下次使用FPU时将产生#NM异常
+ */
+static inline void fpu_set_ts (void) {
+    write_cr0(read_cr0() | CR0_TS);
+}
+
+/**
+ * @brief 设置当前CPU的控制寄存器
+ */
+static void fpu_cpu_init (uint32_t edx) {
+    // 使用硬件FPU，错误通过#MF报告，WAIT指令也受TS控制
+    uint32_t cr0 = read_cr0();
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    write_cr0(cr0);
+
+    // 支持FXSR时才能开启SSE
+    fpu_has_fxsr = (edx & CPUID_FEAT_EDX_FXSR) ? 1 : 0;
+    if (fpu_has_fxsr) {
+        uint32_t cr4 = read_cr4() | CR4_OSFXSR;
+        if (edx & CPUID_FEAT_EDX_SSE) {
+            cr4 |= CR4_OSXMMEXCPT;
+        }
+        write_cr4(cr4);
+    }
+}
+
+/**
+ * @brief FPU/SSE初始化
+ */
+void fpu_init (void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+
+    if (!(edx & CPUID_FEAT_EDX_FPU)) {
+        log_printf("no fpu found, floating point disabled.");
+        return;
+    }
+
+    fpu_cpu_init(edx);
+
+    // 生成一份干净的初始状态，含缺省的FCW和MXCSR
+    fninit();
+    fpu_save(&fpu_init_state);
+    fpu_set_ts();
+
+    log_printf("fpu init: fxsr=%d, sse=%d", fpu_has_fxsr, (edx & CPUID_FEAT_EDX_SSE) ? 1 : 0);
+}
+
+/**
+ * @brief AP上的FPU初始化，初始状态已由BSP生成
+ */
+void fpu_ap_init (void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_FEAT_EDX_FPU)) {
+        return;
+    }
+
+    fpu_cpu_init(edx);
+    fpu_set_ts();
+}
+
+/**
+ * @brief 任务即将从当前CPU切出，寄存器中是它的状态时立即保存，以便在其它CPU上恢复
+ * 调用时已关中断
+ */
+void fpu_task_switch_out (task_t * task) {
+    cpu_t * cpu = cpu_current();
+    if (cpu->fpu_owner != task) {
+        return;
+    }
+
+    clts();
+    fpu_save(&task->fpu_state);
+    cpu->fpu_owner = (task_t *)0;
+    fpu_set_ts();
+}
+
+/**
+ * @brief #NM异常处理，在此处完成FPU状态的延迟切换
+ */
+void do_handler_device_unavailable (exception_frame_t * frame) {
+    task_t * curr = task_current();
+    cpu_t * cpu = cpu_current();
+
+    curr->usage.faults++;
+    clts();
+    if (cpu->fpu_owner == curr) {
+        // 寄存器中就是自己的状态，仅因任务切换置位了TS
+        return;
+    }
+
+    // 先将上一使用者的状态保存起来
+    if (cpu->fpu_owner) {
+        fpu_save(&cpu->fpu_owner->fpu_state);
+    }
+
+    // 再加载当前任务的，首次使用时加载初始状态
+    if (!curr->fpu_used) {
+        kernel_memcpy(&curr->fpu_state, &fpu_init_state, sizeof(fpu_state_t));
+        curr->fpu_used = 1;
+    }
+    fpu_restore(&curr->fpu_state);
+    cpu->fpu_owner = curr;
+}
+
+/**
+ * @brief 创建子进程时，复制父进程的FPU状态
+ */
+void fpu_task_fork (task_t * parent, task_t * child) {
+    child->fpu_used = parent->fpu_used;
+    if (!parent->fpu_used) {
+        return;
+    }
+
+    irq_state_t state = irq_enter_protection();
+    cpu_t * cpu = cpu_current();
+    if (cpu->fpu_owner == parent) {
+        // 最新的状态还在寄存器中，先写回到父进程的保存区
+        clts();
+        fpu_save(&parent->fpu_state);
+        cpu->fpu_owner = (task_t *)0;
+        fpu_set_ts();
+    }
+    irq_leave_protection(state);
+
+    kernel_memcpy(&child->fpu_state, &parent->fpu_state, sizeof(fpu_state_t));
+}
+
+/**
+ * @brief 加载新程序时，丢弃原有的FPU状态
+ */
+void fpu_task_reset (task_t * task) {
+    irq_state_t state = irq_enter_protection();
+    cpu_t * cpu = cpu_current();
+    task->fpu_used = 0;
+    if (cpu->fpu_owner == task) {
+        cpu->fpu_owner = (task_t *)0;
+        fpu_set_ts();
+    }
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 任务退出，寄存器中的状态不再需要保存
+ */
+void fpu_task_exit (task_t * task) {
+    fpu_task_reset(task);
+}
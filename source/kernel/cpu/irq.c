@@ -3,6 +3,8 @@
  */
 #include "cpu/irq.h"
 #include "cpu/cpu.h"
+#include "cpu/apic.h"
+#include "cpu/irqlat.h"
 #include "comm/cpu_instr.h"
 #include "tools/log.h"
 #include "os_cfg.h"
@@ -82,10 +84,6 @@ void do_handler_invalid_opcode(exception_frame_t * frame) {
 	do_default_handler(frame, "Invalid Opcode.");
 }
 
-void do_handler_device_unavailable(exception_frame_t * frame) {
-	do_default_handler(frame, "Device Not Available.");
-}
-
 void do_handler_double_fault(exception_frame_t * frame) {
 	do_default_handler(frame, "Double Fault.");
 }
@@ -204,6 +202,17 @@ static void init_pic(void) {
     outb(PIC1_IMR, 0xFF);
 }
 
+/**
+ * @brief 中断处理结束，通知中断控制器
+ */
+void irq_send_eoi (int irq_num) {
+    if (apic_enabled()) {
+        lapic_eoi();
+    } else {
+        pic_send_eoi(irq_num);
+    }
+}
+
 void pic_send_eoi(int irq_num) {
     irq_num -= IRQ_PIC_START;
 
@@ -251,6 +260,13 @@ void irq_init(void) {
 	init_pic();
 }
 
+/**
+ * @brief AP使用和BSP相同的中断表
+ */
+void irq_ap_init (void) {
+	lidt((uint32_t)idt_table, sizeof(idt_table));
+}
+
 /**
  * @brief 安装中断或异常处理程序
  */
@@ -269,6 +285,11 @@ void irq_enable(int irq_num) {
         return;
     }
 
+    if (apic_enabled()) {
+        ioapic_enable(irq_num);
+        return;
+    }
+
     irq_num -= IRQ_PIC_START;
     if (irq_num < 8) {
         uint8_t mask = inb(PIC0_IMR) & ~(1 << irq_num);
@@ -285,6 +306,11 @@ void irq_disable(int irq_num) {
         return;
     }
 
+    if (apic_enabled()) {
+        ioapic_disable(irq_num);
+        return;
+    }
+
     irq_num -= IRQ_PIC_START;
     if (irq_num < 8) {
         uint8_t mask = inb(PIC0_IMR) | (1 << irq_num);
@@ -310,6 +336,9 @@ void irq_enable_global(void) {
 irq_state_t irq_enter_protection (void) {
     irq_state_t state = read_eflags();
     irq_disable_global();
+    if (irqlat_enabled) {
+        irqlat_enter(state);
+    }
     return state;
 }
 
@@ -317,5 +346,8 @@ irq_state_t irq_enter_protection (void) {
  * @brief 退出中断保护
  */
 void irq_leave_protection (irq_state_t state) {
+    if (irqlat_enabled) {
+        irqlat_leave(state);
+    }
     write_eflags(state);
 }
\ No newline at end of file
@@ -0,0 +1,216 @@
+/**
+ * 关中断时长的统计
+ * 开始时间和调用位置记在当前CPU上，任务在关中断期间切换时，由换入的任务结束该区间，
+ * 所以统计的是CPU实际关中断的时间。调用位置表占一页，用返回地址散列。
+ * 超过阈值的区间先记下，经tasklet转到工作队列中打印，日志输出会进入互斥锁。
+ */
+#include "cpu/irqlat.h"
+#include "cpu/irq.h"
+#include "cpu/cpu.h"
+#include "cpu/smp.h"
+#include "cpu/softirq.h"
+#include "core/memory.h"
+#include "core/workqueue.h"
+#include "dev/time.h"
+#include "ipc/spinlock.h"
+#include "comm/cpu_instr.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+#define IRQLAT_SITE_NR          (MEM_PAGE_SIZE / sizeof(irqlat_site_t))
+
+volatile int irqlat_enabled;                // 是否统计，需要TSC
+static irqlat_site_t * irqlat_sites;
+static uint64_t irqlat_threshold;           // 告警阈值，TSC周期数，0表示不告警
+static spinlock_t irqlat_lock;              // 保护调用位置表及待告警的记录
+
+// 待告警的区间，只保留最近的一个
+static irqlat_site_t irqlat_warn;
+static int irqlat_warn_cpu;
+static tasklet_t irqlat_tasklet;
+static work_t irqlat_work;
+
+/**
+ * @brief 开始关中断，只记录最外层，即进入前是开中断的
+ */
+void irqlat_enter (uint32_t state) {
+    if (!(state & EFLAGS_IF)) {
+        return;
+    }
+
+    cpu_t * cpu = cpu_current();
+    for (int i = 0; i < IRQLAT_DEPTH; i++) {
+        cpu->irqoff_chain[i] = 0;
+    }
+
+    // 跳过irq_enter_protection自己的一帧，只在当前栈所在页内回溯
+    uint32_t ebp = (uint32_t)__builtin_frame_address(0);
+    uint32_t bottom = ebp & ~(MEM_PAGE_SIZE - 1);
+    uint32_t top = bottom + MEM_PAGE_SIZE;
+    ebp = *(uint32_t *)ebp;
+    for (int i = 0; (i < IRQLAT_DEPTH) && (ebp >= bottom) && (ebp + 8 <= top) && !(ebp & 3); i++) {
+        uint32_t * frame = (uint32_t *)ebp;
+        cpu->irqoff_chain[i] = frame[1];
+        if (frame[0] <= ebp) {
+            break;
+        }
+        ebp = frame[0];
+    }
+
+    cpu->irqoff_start = rdtsc();
+}
+
+/**
+ * @brief 在调用位置表中查找，没有时新建，表满时返回0，即不再记录新的位置
+ */
+static irqlat_site_t * irqlat_find (uint32_t * chain) {
+    uint32_t hash = (chain[0] ^ (chain[1] * 31) ^ (chain[2] * 131)) >> 2;
+    for (int i = 0; i < IRQLAT_SITE_NR; i++) {
+        irqlat_site_t * site = irqlat_sites + ((hash + i) % IRQLAT_SITE_NR);
+        if (site->count == 0) {
+            kernel_memcpy(site->chain, chain, sizeof(site->chain));
+            return site;
+        } else if (!kernel_memcmp(site->chain, chain, sizeof(site->chain))) {
+            return site;
+        }
+    }
+    return (irqlat_site_t *)0;
+}
+
+/**
+ * @brief 结束关中断，state中开中断时为最外层，计入统计，此时中断仍关闭
+ */
+void irqlat_leave (uint32_t state) {
+    if (!(state & EFLAGS_IF)) {
+        return;
+    }
+
+    cpu_t * cpu = cpu_current();
+    if (!cpu->irqoff_start) {
+        // 开始时还未启用统计
+        return;
+    }
+    uint64_t cycles = rdtsc() - cpu->irqoff_start;
+    cpu->irqoff_start = 0;
+
+    int warn = 0;
+    spin_lock(&irqlat_lock);
+    irqlat_site_t * site = irqlat_find(cpu->irqoff_chain);
+    if (site) {
+        site->count++;
+        site->total += cycles;
+        if (cycles > site->max) {
+            site->max = cycles;
+        }
+    }
+
+    if (irqlat_threshold && (cycles >= irqlat_threshold)) {
+        kernel_memcpy(irqlat_warn.chain, cpu->irqoff_chain, sizeof(irqlat_warn.chain));
+        irqlat_warn.max = cycles;
+        irqlat_warn_cpu = cpu->id;
+        warn = 1;
+    }
+    spin_unlock(&irqlat_lock);
+
+    // 仍在关中断中，tasklet_schedule内的保护区间不会再被统计
+    if (warn) {
+        tasklet_schedule(&irqlat_tasklet);
+    }
+}
+
+/**
+ * @brief 任务切换完成后，结束换出的任务开始的关中断区间
+ * 换入的是新任务，或是在中断中被换出的任务时，将经iret直接开中断，
+ * 不会有对应的irq_leave_protection，区间须在这里结束，否则会被计入之后不相关的位置
+ */
+void irqlat_switch_done (void) {
+    if (irqlat_enabled) {
+        irqlat_leave(EFLAGS_IF);
+    }
+}
+
+/**
+ * @brief 在工作队列中打印告警
+ */
+static void irqlat_warn_work (work_t * work) {
+    irq_state_t state = spin_lock_irqsave(&irqlat_lock);
+    irqlat_site_t site = irqlat_warn;
+    int cpu = irqlat_warn_cpu;
+    spin_unlock_irqrestore(&irqlat_lock, state);
+
+    uint32_t khz = time_get_tsc_khz();
+    uint32_t us = khz ? (uint32_t)kernel_div64(site.max * 1000, khz, (uint32_t *)0) : 0;
+    log_printf("irqlat: cpu%d irq off %d us at 0x%x <- 0x%x <- 0x%x",
+            cpu, us, site.chain[0], site.chain[1], site.chain[2]);
+}
+
+/**
+ * @brief 在软中断中转交给工作队列
+ */
+static void irqlat_warn_tasklet (void * data) {
+    schedule_work(&irqlat_work);
+}
+
+/**
+ * @brief 读取所有调用位置的统计，返回读取的字节数
+ */
+int irqlat_read (char * buf, int size) {
+    if (!irqlat_sites) {
+        return 0;
+    }
+
+    int len = 0;
+    for (int i = 0; (i < IRQLAT_SITE_NR) && (len + (int)sizeof(irqlat_site_t) <= size); i++) {
+        irqlat_site_t site;
+
+        irq_state_t state = spin_lock_irqsave(&irqlat_lock);
+        site = irqlat_sites[i];
+        spin_unlock_irqrestore(&irqlat_lock, state);
+
+        // 在锁外复制到应用的缓冲区
+        if (site.count) {
+            kernel_memcpy(buf + len, &site, sizeof(irqlat_site_t));
+            len += sizeof(irqlat_site_t);
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief 设置告警阈值，同时清零统计
+ */
+void irqlat_set_threshold (uint32_t us) {
+    if (!irqlat_sites) {
+        return;
+    }
+
+    irq_state_t state = spin_lock_irqsave(&irqlat_lock);
+    kernel_memset(irqlat_sites, 0, MEM_PAGE_SIZE);
+    irqlat_threshold = (uint64_t)us * (time_get_tsc_khz() / 1000);
+    spin_unlock_irqrestore(&irqlat_lock, state);
+}
+
+/**
+ * @brief 关中断统计初始化，需在工作队列及时钟初始化之后
+ */
+void irqlat_init (void) {
+    spinlock_init(&irqlat_lock);
+    tasklet_init(&irqlat_tasklet, irqlat_warn_tasklet, (void *)0);
+    work_init(&irqlat_work, irqlat_warn_work);
+
+    // 没有TSC时无法计时
+    if (!time_get_tsc_khz()) {
+        log_printf("irqlat: no TSC, disabled");
+        return;
+    }
+
+    irqlat_sites = (irqlat_site_t *)memory_alloc_page();
+    if (!irqlat_sites) {
+        log_printf("irqlat: alloc page failed");
+        return;
+    }
+    kernel_memset(irqlat_sites, 0, MEM_PAGE_SIZE);
+
+    irqlat_set_threshold(IRQLAT_WARN_US);
+    irqlat_enabled = 1;
+}
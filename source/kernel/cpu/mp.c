@@ -0,0 +1,271 @@
+/**
+ * 多处理器及中断控制器配置信息的获取
+ * 优先从ACPI的MADT表中获取，没有时再查找MP配置表
+ */
+#include "cpu/mp.h"
+#include "core/memory.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+#define BIOS_EBDA_SEG_ADDR      0x40E           // 保存EBDA段地址的位置
+#define BIOS_BASE_MEM_END       0x9FC00         // 基本内存的最后1KB
+#define BIOS_ROM_START          0xE0000         // BIOS只读区域
+#define BIOS_ROM_SIZE           (128 * 1024)
+
+static mp_info_t mp;
+
+// 查找表时要搜索的区域
+static struct {
+    uint8_t * start;
+    uint32_t size;
+}bios_area[3];
+
+/**
+ * @brief 计算校验和，正确的表各字节之和为0
+ */
+static uint8_t checksum (void * start, int size) {
+    uint8_t sum = 0;
+    for (uint8_t * p = (uint8_t *)start; size > 0; size--) {
+        sum += *p++;
+    }
+    return sum;
+}
+
+static int rsdp_valid (uint8_t * p) {
+    return checksum(p, sizeof(acpi_rsdp_t)) == 0;
+}
+
+static int mp_float_valid (uint8_t * p) {
+    mp_float_t * mpf = (mp_float_t *)p;
+    return (mpf->length > 0) && (checksum(p, mpf->length * 16) == 0);
+}
+
+/**
+ * @brief 在BIOS的各区域中以16字节为间隔查找指定签名的结构
+ */
+static void * bios_scan (const char * sig, int sig_len, int (*valid)(uint8_t *)) {
+    for (int i = 0; i < sizeof(bios_area) / sizeof(bios_area[0]); i++) {
+        uint8_t * start = bios_area[i].start;
+        if (start == (uint8_t *)0) {
+            continue;
+        }
+
+        for (uint8_t * p = start; p + 16 <= start + bios_area[i].size; p += 16) {
+            if ((kernel_memcmp(p, (void *)sig, sig_len) == 0) && valid(p)) {
+                return p;
+            }
+        }
+    }
+
+    return (void *)0;
+}
+
+/**
+ * @brief 映射ACPI表，先映射表头得到长度，再映射整张表
+ */
+static acpi_header_t * acpi_map_table (uint32_t paddr) {
+    acpi_header_t * header = (acpi_header_t *)memory_map_mmio(paddr, sizeof(acpi_header_t));
+    if (header == (acpi_header_t *)0) {
+        return (acpi_header_t *)0;
+    }
+
+    header = (acpi_header_t *)memory_map_mmio(paddr, header->length);
+    if ((header == (acpi_header_t *)0) || checksum(header, header->length)) {
+        return (acpi_header_t *)0;
+    }
+    return header;
+}
+
+/**
+ * @brief 解析MADT表
+ */
+static void madt_parse (acpi_madt_t * madt) {
+    mp.lapic_addr = madt->lapic_addr;
+
+    uint8_t * p = (uint8_t *)(madt + 1);
+    uint8_t * end = (uint8_t *)madt + madt->header.length;
+    while (p + sizeof(madt_entry_t) <= end) {
+        madt_entry_t * entry = (madt_entry_t *)p;
+        if (entry->length == 0) {
+            break;
+        }
+
+        switch (entry->type) {
+        case MADT_TYPE_LAPIC: {
+            madt_lapic_t * lapic = (madt_lapic_t *)entry;
+            if ((lapic->flags & MADT_LAPIC_ENABLED) && (mp.cpu_count < MP_CPU_MAX)) {
+                mp.cpu_apic_id[mp.cpu_count++] = lapic->apic_id;
+            }
+            break;
+        }
+        case MADT_TYPE_IOAPIC: {
+            // 只使用第一个IOAPIC
+            madt_ioapic_t * ioapic = (madt_ioapic_t *)entry;
+            if (mp.ioapic_addr == 0) {
+                mp.ioapic_addr = ioapic->addr;
+                mp.ioapic_gsi_base = ioapic->gsi_base;
+                mp.ioapic_id = ioapic->ioapic_id;
+            }
+            break;
+        }
+        case MADT_TYPE_OVERRIDE: {
+            madt_override_t * override = (madt_override_t *)entry;
+            if (override->source < MP_ISA_IRQ_NR) {
+                mp.isa_irq[override->source].gsi = override->gsi;
+                mp.isa_irq[override->source].flags = override->flags;
+            }
+            break;
+        }
+        case MADT_TYPE_LAPIC_ADDR: {
+            madt_lapic_addr_t * addr = (madt_lapic_addr_t *)entry;
+            if (addr->addr_hi == 0) {
+                mp.lapic_addr = addr->addr_lo;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        p += entry->length;
+    }
+}
+
+/**
+ * @brief 从ACPI表中获取配置
+ */
+static int acpi_parse (void) {
+    acpi_rsdp_t * rsdp = (acpi_rsdp_t *)bios_scan("RSD PTR ", 8, rsdp_valid);
+    if (rsdp == (acpi_rsdp_t *)0) {
+        return -1;
+    }
+
+    acpi_header_t * rsdt = acpi_map_table(rsdp->rsdt_addr);
+    if ((rsdt == (acpi_header_t *)0) || kernel_memcmp(rsdt->signature, "RSDT", 4)) {
+        return -1;
+    }
+
+    int count = (rsdt->length - sizeof(acpi_header_t)) / sizeof(uint32_t);
+    uint32_t * entry = (uint32_t *)(rsdt + 1);
+    for (int i = 0; i < count; i++) {
+        acpi_header_t * header = acpi_map_table(entry[i]);
+        if (header && (kernel_memcmp(header->signature, "APIC", 4) == 0)) {
+            madt_parse((acpi_madt_t *)header);
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief 从MP配置表中获取配置
+ */
+static int mp_table_parse (void) {
+    mp_float_t * mpf = (mp_float_t *)bios_scan("_MP_", 4, mp_float_valid);
+    if ((mpf == (mp_float_t *)0) || (mpf->config_addr == 0)) {
+        // 不支持无配置表的缺省配置
+        return -1;
+    }
+
+    mp_config_t * config = (mp_config_t *)memory_map_mmio(mpf->config_addr, sizeof(mp_config_t));
+    if (config == (mp_config_t *)0) {
+        return -1;
+    }
+    config = (mp_config_t *)memory_map_mmio(mpf->config_addr, config->length);
+    if ((config == (mp_config_t *)0) || kernel_memcmp(config->signature, "PCMP", 4)
+            || checksum(config, config->length)) {
+        return -1;
+    }
+
+    mp.lapic_addr = config->lapic_addr;
+
+    uint32_t isa_bus_mask = 0;
+    uint8_t * p = (uint8_t *)(config + 1);
+    uint8_t * end = (uint8_t *)config + config->length;
+    for (int i = 0; (i < config->entry_count) && (p < end); i++) {
+        switch (*p) {
+        case MP_ENTRY_CPU: {
+            mp_cpu_t * cpu = (mp_cpu_t *)p;
+            if ((cpu->flags & MP_CPU_ENABLED) && (mp.cpu_count < MP_CPU_MAX)) {
+                mp.cpu_apic_id[mp.cpu_count++] = cpu->apic_id;
+            }
+            p += sizeof(mp_cpu_t);
+            break;
+        }
+        case MP_ENTRY_BUS: {
+            mp_bus_t * bus = (mp_bus_t *)p;
+            if ((kernel_memcmp(bus->bus_type, "ISA", 3) == 0) && (bus->bus_id < 32)) {
+                isa_bus_mask |= 1 << bus->bus_id;
+            }
+            p += sizeof(mp_bus_t);
+            break;
+        }
+        case MP_ENTRY_IOAPIC: {
+            mp_ioapic_t * ioapic = (mp_ioapic_t *)p;
+            if ((ioapic->flags & MP_IOAPIC_ENABLED) && (mp.ioapic_addr == 0)) {
+                mp.ioapic_addr = ioapic->addr;
+                mp.ioapic_gsi_base = 0;
+                mp.ioapic_id = ioapic->ioapic_id;
+            }
+            p += sizeof(mp_ioapic_t);
+            break;
+        }
+        case MP_ENTRY_IOINT: {
+            // 只关心ISA总线上的普通中断
+            mp_ioint_t * ioint = (mp_ioint_t *)p;
+            if ((ioint->int_type == 0) && (ioint->src_bus < 32) && (isa_bus_mask & (1 << ioint->src_bus))
+                    && (ioint->src_irq < MP_ISA_IRQ_NR)) {
+                mp.isa_irq[ioint->src_irq].gsi = ioint->dst_pin;
+                mp.isa_irq[ioint->src_irq].flags = ioint->flags;
+            }
+            p += sizeof(mp_ioint_t);
+            break;
+        }
+        default:
+            p += 8;
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 获取系统配置信息
+ */
+mp_info_t * mp_info (void) {
+    return &mp;
+}
+
+/**
+ * @brief 查找并解析固件中的配置表，需在内存管理初始化之后调用
+ */
+void mp_init (void) {
+    kernel_memset(&mp, 0, sizeof(mp));
+    for (int i = 0; i < MP_ISA_IRQ_NR; i++) {
+        mp.isa_irq[i].gsi = i;
+    }
+
+    // EBDA的前1KB、基本内存的最后1KB，以及BIOS ROM区
+    uint32_t ebda = (uint32_t)(*(uint16_t *)BIOS_EBDA_SEG_ADDR) << 4;
+    if (ebda) {
+        bios_area[0].start = (uint8_t *)memory_map_mmio(ebda, 1024);
+        bios_area[0].size = 1024;
+    }
+    bios_area[1].start = (uint8_t *)memory_map_mmio(BIOS_BASE_MEM_END, 1024);
+    bios_area[1].size = 1024;
+    bios_area[2].start = (uint8_t *)memory_map_mmio(BIOS_ROM_START, BIOS_ROM_SIZE);
+    bios_area[2].size = BIOS_ROM_SIZE;
+
+    if (acpi_parse() == 0) {
+        log_printf("acpi: %d cpu(s), lapic 0x%x, ioapic 0x%x", mp.cpu_count, mp.lapic_addr, mp.ioapic_addr);
+    } else if (mp_table_parse() == 0) {
+        log_printf("mp table: %d cpu(s), lapic 0x%x, ioapic 0x%x", mp.cpu_count, mp.lapic_addr, mp.ioapic_addr);
+    } else {
+        log_printf("no acpi or mp table found.");
+        return;
+    }
+
+    mp.found = 1;
+}
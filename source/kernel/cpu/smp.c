@@ -0,0 +1,175 @@
+/**
+ * 多处理器支持
+ * BSP通过INIT-SIPI-SIPI序列依次启动各个AP。AP从AP_START_ADDR处的实模式代码开始运行，
+ * 进入保护模式并开启分页后，以各自空闲任务的身份进入ap_main，之后由调度器分配任务。
+ * 只有在使用APIC时才会启动AP，否则只使用BSP。
+ */
+#include "cpu/smp.h"
+#include "cpu/apic.h"
+#include "cpu/irq.h"
+#include "cpu/fpu.h"
+#include "comm/cpu_instr.h"
+#include "core/task.h"
+#include "core/syscall.h"
+#include "dev/time.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+#include "os_cfg.h"
+
+static cpu_t cpu_table[SMP_CPU_MAX];        // 各CPU的数据，0为BSP
+static int cpu_count;
+
+// 供AP启动代码使用，每次只启动一个AP
+uint32_t ap_boot_cr3;                       // 使用的页表
+uint32_t ap_boot_esp;                       // 使用的栈
+static cpu_t * volatile ap_boot_cpu;        // 正在启动的CPU
+
+/**
+ * @brief CPU的数量
+ */
+int smp_cpu_count (void) {
+    return cpu_count;
+}
+
+/**
+ * @brief 获取指定的CPU
+ */
+cpu_t * smp_cpu (int id) {
+    return cpu_table + id;
+}
+
+/**
+ * @brief 获取当前CPU，通过当前任务查找；还没有任务时只有BSP在运行
+ */
+cpu_t * cpu_current (void) {
+    task_t * task = task_current();
+    return task ? task->cpu : cpu_table;
+}
+
+/**
+ * @brief 要求指定的CPU重新调度
+ */
+void smp_send_resched (cpu_t * cpu) {
+    if (cpu->started) {
+        lapic_send_ipi(cpu->apic_id, IRQ_RESCHED);
+    }
+}
+
+/**
+ * @brief 重新调度的IPI，其它CPU放入了任务或有任务可以取
+ */
+void do_handler_resched (exception_frame_t * frame) {
+    lapic_eoi();
+
+    irq_state_t state = task_lock();
+    task_dispatch();
+    irqlat_switch_done();
+    task_unlock(state);
+}
+
+/**
+ * @brief AP的C入口，运行在自己空闲任务的内核栈上
+ */
+void ap_main (void) {
+    cpu_t * cpu = ap_boot_cpu;
+
+    irq_ap_init();
+    fpu_ap_init();
+    syscall_ap_init();
+    lapic_ap_init();
+
+    // 以空闲任务的身份运行，第一次切换时保存的就是这里的状态
+    write_tr(cpu->idle_task->tss_sel);
+    cpu->curr_task = cpu->idle_task;
+    cpu->started = 1;
+
+    sti();
+    for (;;) {
+        hlt();
+    }
+}
+
+/**
+ * @brief 启动一个AP，成功返回0
+ */
+static int smp_start_ap (cpu_t * cpu) {
+    ap_boot_cpu = cpu;
+    ap_boot_cr3 = cpu->idle_task->tss.cr3;
+    ap_boot_esp = cpu->idle_task->tss.esp0;
+
+    // INIT后等待10ms，再发送两次SIPI，向量为启动代码所在的页号
+    lapic_send_ipi(cpu->apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL_ASSERT);
+    time_pit_delay(10);
+    for (int i = 0; i < 2; i++) {
+        lapic_send_ipi(cpu->apic_id, LAPIC_ICR_STARTUP | (AP_START_ADDR >> 12));
+        time_udelay(200);
+    }
+
+    for (int i = 0; (i < AP_START_TIMEOUT_MS) && !cpu->started; i++) {
+        time_pit_delay(1);
+    }
+    return cpu->started ? 0 : -1;
+}
+
+/**
+ * @brief 启动所有AP，需在空闲任务创建之后、进入第一个任务之前调用
+ */
+void smp_start_aps (void) {
+    if (cpu_count <= 1) {
+        return;
+    }
+
+    // 复制启动代码，并填入当前的GDT，AP和BSP共用同一个GDT
+    extern uint8_t ap_start_begin[], ap_start_end[], ap_gdt_desc[];
+    kernel_memcpy((void *)AP_START_ADDR, ap_start_begin, ap_start_end - ap_start_begin);
+    sgdt((void *)(AP_START_ADDR + (ap_gdt_desc - ap_start_begin)));
+
+    int started = 1;
+    for (int i = 1; i < cpu_count; i++) {
+        cpu_t * cpu = cpu_table + i;
+        if (smp_start_ap(cpu) < 0) {
+            log_printf("cpu %d (apic id %d) start failed.", i, cpu->apic_id);
+            continue;
+        }
+        started++;
+    }
+
+    log_printf("smp: %d of %d cpu(s) running", started, cpu_count);
+}
+
+/**
+ * @brief 多处理器初始化，建立各CPU的数据，需在APIC初始化之后调用
+ */
+void smp_init (void) {
+    kernel_memset(cpu_table, 0, sizeof(cpu_table));
+
+    // BSP总是0号
+    cpu_t * bsp = cpu_table;
+    bsp->apic_id = lapic_id();
+    bsp->started = 1;
+    list_init(&bsp->ready_list);
+    list_init(&bsp->rt_list);
+    list_init(&bsp->tasklet_list);
+    cpu_count = 1;
+
+    // 没有APIC时无法启动AP
+    if (!apic_enabled()) {
+        return;
+    }
+
+    mp_info_t * info = mp_info();
+    for (int i = 0; (i < info->cpu_count) && (cpu_count < SMP_CPU_MAX); i++) {
+        if (info->cpu_apic_id[i] == bsp->apic_id) {
+            continue;
+        }
+
+        cpu_t * cpu = cpu_table + cpu_count;
+        cpu->id = cpu_count++;
+        cpu->apic_id = info->cpu_apic_id[i];
+        list_init(&cpu->ready_list);
+        list_init(&cpu->rt_list);
+        list_init(&cpu->tasklet_list);
+    }
+
+    irq_install(IRQ_RESCHED, (irq_handler_t)exception_handler_resched);
+}
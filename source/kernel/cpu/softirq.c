@@ -0,0 +1,142 @@
+/**
+ * 软中断与tasklet
+ * 每个CPU有自己的待处理标志和tasklet队列。中断处理程序在发送EOI后调用irq_exit，
+ * 若有待处理的软中断，则开中断逐个处理。处理期间发生的中断只记录标志，由外层继续处理。
+ * 软中断中唤醒任务不会立即切换，而是在全部处理完后统一进行一次调度。
+ */
+#include "cpu/softirq.h"
+#include "cpu/smp.h"
+#include "cpu/irq.h"
+#include "comm/cpu_instr.h"
+#include "core/task.h"
+
+static softirq_handler_t softirq_table[SOFTIRQ_NR];
+
+/**
+ * @brief 注册软中断的处理函数
+ */
+void softirq_install (int nr, softirq_handler_t handler) {
+    if ((nr >= 0) && (nr < SOFTIRQ_NR)) {
+        softirq_table[nr] = handler;
+    }
+}
+
+/**
+ * @brief 在当前CPU上标记软中断待处理，在下次中断返回前执行
+ */
+void raise_softirq (int nr) {
+    irq_state_t state = irq_enter_protection();
+    cpu_current()->softirq_pending |= 1 << nr;
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 处理当前CPU上所有待处理的软中断，调用时已关中断
+ */
+static void softirq_run (cpu_t * cpu) {
+    cpu->softirq_active = 1;
+
+    for (int restart = 0; cpu->softirq_pending && (restart < SOFTIRQ_MAX_RESTART); restart++) {
+        uint32_t pending = cpu->softirq_pending;
+        cpu->softirq_pending = 0;
+
+        sti();
+        for (int nr = 0; nr < SOFTIRQ_NR; nr++) {
+            if ((pending & (1 << nr)) && softirq_table[nr]) {
+                softirq_table[nr]();
+            }
+        }
+        cli();
+    }
+
+    // 处理不完的留到下次中断，避免一直停留在软中断中
+    cpu->softirq_active = 0;
+}
+
+/**
+ * @brief 中断处理的出口，运行下半部，并进行期间推迟的调度
+ * 在各中断处理函数的最后、关中断的情况下调用
+ */
+void irq_exit (void) {
+    cpu_t * cpu = cpu_current();
+    if (cpu->softirq_active) {
+        // 打断了软中断的处理，由外层处理
+        return;
+    }
+
+    if (cpu->softirq_pending) {
+        softirq_run(cpu);
+    }
+
+    if (cpu->need_resched) {
+        irq_state_t state = task_lock();
+        task_dispatch();
+        irqlat_switch_done();
+        task_unlock(state);
+    }
+}
+
+/**
+ * @brief 初始化tasklet
+ */
+void tasklet_init (tasklet_t * tasklet, void (*func)(void * data), void * data) {
+    list_node_init(&tasklet->node);
+    tasklet->func = func;
+    tasklet->data = data;
+    tasklet->scheduled = 0;
+    tasklet->running = 0;
+}
+
+/**
+ * @brief 调度tasklet在当前CPU上运行，已在队列中的不重复加入
+ */
+void tasklet_schedule (tasklet_t * tasklet) {
+    if (xchg(&tasklet->scheduled, 1)) {
+        return;
+    }
+
+    irq_state_t state = irq_enter_protection();
+    cpu_t * cpu = cpu_current();
+    list_insert_last(&cpu->tasklet_list, &tasklet->node);
+    cpu->softirq_pending |= 1 << SOFTIRQ_TASKLET;
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief tasklet软中断，运行当前CPU队列中的所有tasklet
+ */
+static void tasklet_action (void) {
+    cpu_t * cpu = cpu_current();
+
+    // 先整体取下，处理过程中新加入的留到下一轮
+    irq_state_t state = irq_enter_protection();
+    list_t list = cpu->tasklet_list;
+    list_init(&cpu->tasklet_list);
+    irq_leave_protection(state);
+
+    list_node_t * node;
+    while ((node = list_remove_first(&list)) != (list_node_t *)0) {
+        tasklet_t * tasklet = list_node_parent(node, tasklet_t, node);
+
+        // 正在其它CPU上运行，放回队列下次再处理
+        if (xchg(&tasklet->running, 1)) {
+            state = irq_enter_protection();
+            list_insert_last(&cpu->tasklet_list, node);
+            cpu->softirq_pending |= 1 << SOFTIRQ_TASKLET;
+            irq_leave_protection(state);
+            continue;
+        }
+
+        // 先清除标记，运行期间可以再次调度
+        tasklet->scheduled = 0;
+        tasklet->func(tasklet->data);
+        tasklet->running = 0;
+    }
+}
+
+/**
+ * @brief 软中断初始化
+ */
+void softirq_init (void) {
+    softirq_install(SOFTIRQ_TASKLET, tasklet_action);
+}
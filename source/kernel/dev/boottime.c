@@ -0,0 +1,37 @@
+/**
+ * 启动时间设备
+ * 读出各阶段的TSC时间戳，写入任意内容记录shell显示提示符的时刻，只有第一次有效。
+ */
+#include "dev/dev.h"
+#include "core/boottime.h"
+
+static int boottime_dev_open (device_t * dev) {
+	return 0;
+}
+
+static int boottime_dev_read (device_t * dev, int addr, char * buf, int size) {
+	return boottime_read(addr, buf, size);
+}
+
+static int boottime_dev_write (device_t * dev, int addr, char * buf, int size) {
+	boottime_stamp(BOOT_STAGE_SHELL);
+	return size;
+}
+
+static int boottime_dev_control (device_t * dev, int cmd, int arg0, int arg1) {
+	return -1;
+}
+
+static void boottime_dev_close (device_t * dev) {
+}
+
+// 设备描述表
+dev_desc_t dev_boottime_desc = {
+	.name = "boottime",
+	.major = DEV_BOOTTIME,
+	.open = boottime_dev_open,
+	.read = boottime_dev_read,
+	.write = boottime_dev_write,
+	.control = boottime_dev_control,
+	.close = boottime_dev_close,
+};
@@ -6,10 +6,12 @@
 #include "comm/cpu_instr.h"
 #include "dev/tty.h"
 #include "cpu/irq.h"
+#include "ipc/spinlock.h"
 
 #define CONSOLE_NR          8           // 控制台的数量
 
 static console_t console_buf[CONSOLE_NR];
+static spinlock_t cursor_lock;          // VGA端口的索引和数据需成对访问
 
 
 
@@ -19,7 +21,7 @@ static console_t console_buf[CONSOLE_NR];
 static int read_cursor_pos (void) {
     int pos;
 
-    irq_state_t state = irq_enter_protection();
+    irq_state_t state = spin_lock_irqsave(&cursor_lock);
 
     // 从VGA端口读
  	outb(0x3D4, 0x0F);		// 写光标低地址
@@ -27,7 +29,7 @@ static int read_cursor_pos (void) {
 	outb(0x3D4, 0x0E);		// 写光标高地址
 	pos |= inb(0x3D5) << 8;   
 
-    irq_leave_protection(state);
+    spin_unlock_irqrestore(&cursor_lock, state);
     return pos;
 }
 
@@ -38,14 +40,14 @@ static void update_cursor_pos (console_t * console) {
 	uint16_t pos = (console - console_buf) * (console->display_cols * console->display_rows);
     pos += console->cursor_row *  console->display_cols + console->cursor_col;
 
-    irq_state_t state = irq_enter_protection();
+    irq_state_t state = spin_lock_irqsave(&cursor_lock);
 
 	outb(0x3D4, 0x0F);		// 写低地址
 	outb(0x3D5, (uint8_t) (pos & 0xFF));
 	outb(0x3D4, 0x0E);		// 写高地址
 	outb(0x3D5, (uint8_t) ((pos >> 8) & 0xFF));
 
-    irq_leave_protection(state);
+    spin_unlock_irqrestore(&cursor_lock, state);
 }
 
 void console_select(int idx) {
@@ -236,6 +238,7 @@ int console_init (int idx) {
     console->old_cursor_col = console->cursor_col;
 
     mutex_init(&console->mutex);
+    mutex_set_name(&console->mutex, "console");
 	return 0;
 }
 
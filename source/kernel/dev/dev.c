@@ -2,18 +2,36 @@
 #include "dev/dev.h"
 #include "dev/tty.h"
 #include "tools/klib.h"
+#include "ipc/spinlock.h"
 
 #define DEV_TABLE_SIZE          128     // 支持的设备数量
 
 extern dev_desc_t dev_tty_desc;
+extern dev_desc_t dev_sysstat_desc;
+extern dev_desc_t dev_prof_desc;
+extern dev_desc_t dev_trace_desc;
+extern dev_desc_t dev_lockstat_desc;
+extern dev_desc_t dev_irqlat_desc;
+extern dev_desc_t dev_boottime_desc;
+extern dev_desc_t dev_schedstat_desc;
+extern dev_desc_t dev_serial_desc;
 
 // 设备描述表
 static dev_desc_t * dev_desc_tbl[] = {
     &dev_tty_desc,
+    &dev_sysstat_desc,
+    &dev_prof_desc,
+    &dev_trace_desc,
+    &dev_lockstat_desc,
+    &dev_irqlat_desc,
+    &dev_boottime_desc,
+    &dev_schedstat_desc,
+    &dev_serial_desc,
 };
 
 // 设备表
 static device_t dev_tbl[DEV_TABLE_SIZE];
+static spinlock_t dev_lock;              // 保护设备表
 
 static int is_devid_bad (int dev_id) {
     if ((dev_id < 0) || (dev_id >=  sizeof(dev_tbl) / sizeof(dev_tbl[0]))) {
@@ -31,7 +49,7 @@ static int is_devid_bad (int dev_id) {
  * @brief 打开指定的设备
  */
 int dev_open (int major, int minor, void * data) {
-    irq_state_t state = irq_enter_protection();
+    irq_state_t state = spin_lock_irqsave(&dev_lock);
 
     // 遍历：遇到已经打开的直接返回；否则找一个空闲项
     device_t * free_dev = (device_t *)0;
@@ -43,7 +61,7 @@ int dev_open (int major, int minor, void * data) {
         } else if ((dev->desc->major == major) && (dev->minor == minor)) {
             // 找到了已经打开的？直接返回就好
             dev->open_count++;
-            irq_leave_protection(state);
+            spin_unlock_irqrestore(&dev_lock, state);
             return i;
         }
     }
@@ -67,12 +85,12 @@ int dev_open (int major, int minor, void * data) {
         int err = desc->open(free_dev); // 调取设备对应的打开描述符，如tyy调用ttyopen
         if (err == 0) {
             free_dev->open_count = 1;
-            irq_leave_protection(state);
+            spin_unlock_irqrestore(&dev_lock, state);
             return free_dev - dev_tbl; // 返回索引
         }
     }
 
-    irq_leave_protection(state);
+    spin_unlock_irqrestore(&dev_lock, state);
     return -1;
 }
 
@@ -123,10 +141,10 @@ void dev_close (int dev_id) {
 
     device_t * dev = dev_tbl + dev_id;
 
-    irq_state_t state = irq_enter_protection();
+    irq_state_t state = spin_lock_irqsave(&dev_lock);
     if (--dev->open_count == 0) {
         dev->desc->close(dev);
         kernel_memset(dev, 0, sizeof(device_t));
     }
-    irq_leave_protection(state);
+    spin_unlock_irqrestore(&dev_lock, state);
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+/**
+ * 关中断时长统计设备
+ * 从头读取时得到各调用位置的irqlat_site_t，一次读完；写入4字节的告警阈值(us)则清零统计。
+ */
+#include "dev/dev.h"
+#include "cpu/irqlat.h"
+#include "tools/klib.h"
+
+static int irqlat_dev_open (device_t * dev) {
+	return 0;
+}
+
+/**
+ * @brief 表中的位置没有固定顺序，只支持从头一次读取
+ */
+static int irqlat_dev_read (device_t * dev, int addr, char * buf, int size) {
+	return addr ? 0 : irqlat_read(buf, size);
+}
+
+static int irqlat_dev_write (device_t * dev, int addr, char * buf, int size) {
+	if (size != sizeof(uint32_t)) {
+		return -1;
+	}
+
+	uint32_t us;
+	kernel_memcpy(&us, buf, sizeof(us));
+	irqlat_set_threshold(us);
+	return size;
+}
+
+static int irqlat_dev_control (device_t * dev, int cmd, int arg0, int arg1) {
+	return -1;
+}
+
+static void irqlat_dev_close (device_t * dev) {
+}
+
+// 设备描述表
+dev_desc_t dev_irqlat_desc = {
+	.name = "irqlat",
+	.major = DEV_IRQLAT,
+	.open = irqlat_dev_open,
+	.read = irqlat_dev_read,
+	.write = irqlat_dev_write,
+	.control = irqlat_dev_control,
+	.close = irqlat_dev_close,
+};
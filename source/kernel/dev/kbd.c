@@ -7,10 +7,16 @@
 #include "tools/log.h"
 #include "tools/klib.h"
 #include "dev/tty.h"
+#include "cpu/softirq.h"
 
 
 static kbd_state_t kbd_state;	// 键盘状态
 
+// 中断中只读取原始键码放入缓存，由tasklet解码后送入tty
+static uint8_t kbd_raw_buf[KBD_RAW_BUF_SIZE];
+static volatile int kbd_raw_read, kbd_raw_write;
+static tasklet_t kbd_tasklet;
+
 /**
  * 键盘映射表，分3类
  * normal是没有shift键按下，或者没有numlock按下时默认的键值
@@ -125,10 +131,13 @@ uint8_t kbd_read(void) {
 static void update_led_status (void) {
     int data = 0;
 
+    // 关中断，避免应答被中断处理当作键码读走
+    irq_state_t state = irq_enter_protection();
     data = (kbd_state.caps_lock ? 1 : 0) << 0;
     kbd_write(KBD_PORT_DATA, KBD_CMD_RW_LED);
     kbd_write(KBD_PORT_DATA, data);
     kbd_read();
+    irq_leave_protection(state);
 }
 
 static void do_fx_key (int key) {
@@ -230,29 +239,15 @@ static void do_e0_key (uint8_t raw_code) {
 }
 
 /**
- * @brief 按键中断处理程序
+ * @brief 处理一个原始键码
  */
-void do_handler_kbd(exception_frame_t *frame) {
+static void do_raw_code (uint8_t raw_code) {
     static enum {
     	NORMAL,				// 普通，无e0或e1
 		BEGIN_E0,			// 收到e0字符
 		BEGIN_E1,			// 收到e1字符
     }recv_state = NORMAL;
 
-	// 检查是否有数据，无数据则退出
-	uint8_t status = inb(KBD_PORT_STAT);
-	if (!(status & KBD_STAT_RECV_READY)) {
-        pic_send_eoi(IRQ1_KEYBOARD);
-		return;
-	}
-
-	// 读取键值
-    uint8_t raw_code = inb(KBD_PORT_DATA);
-
-	// 读取完成之后，就可以发EOI，方便后续继续响应键盘中断
-	// 否则,键值的处理过程可能略长，将导致中断响应延迟
-    pic_send_eoi(IRQ1_KEYBOARD);
-
     // 实测qemu下收不到E0和E1，估计是没有发出去
     // 方向键、HOME/END等键码和小键盘上发出来的完全一样。不清楚原因
     // 也许是键盘布局的问题？所以，这里就忽略小键盘？
@@ -278,6 +273,51 @@ void do_handler_kbd(exception_frame_t *frame) {
 	}
 }
 
+/**
+ * @brief 键盘的下半部，在开中断下解码缓存中的所有键码
+ */
+static void kbd_tasklet_func (void * data) {
+	for (;;) {
+		irq_state_t state = irq_enter_protection();
+		if (kbd_raw_read == kbd_raw_write) {
+			irq_leave_protection(state);
+			break;
+		}
+		uint8_t raw_code = kbd_raw_buf[kbd_raw_read];
+		kbd_raw_read = (kbd_raw_read + 1) % KBD_RAW_BUF_SIZE;
+		irq_leave_protection(state);
+
+		do_raw_code(raw_code);
+	}
+}
+
+/**
+ * @brief 键盘中断处理，只读取键码，缓存满时丢弃
+ */
+void do_handler_kbd(exception_frame_t *frame) {
+	// 检查是否有数据，无数据则退出
+	uint8_t status = inb(KBD_PORT_STAT);
+	if (!(status & KBD_STAT_RECV_READY)) {
+        irq_send_eoi(IRQ1_KEYBOARD);
+		return;
+	}
+
+	// 读取键值
+    uint8_t raw_code = inb(KBD_PORT_DATA);
+
+	// 读取完成之后，就可以发EOI，方便后续继续响应键盘中断
+    irq_send_eoi(IRQ1_KEYBOARD);
+
+	int next = (kbd_raw_write + 1) % KBD_RAW_BUF_SIZE;
+	if (next != kbd_raw_read) {
+		kbd_raw_buf[kbd_raw_write] = raw_code;
+		kbd_raw_write = next;
+		tasklet_schedule(&kbd_tasklet);
+	}
+
+	irq_exit();
+}
+
 /**
  * 键盘硬件初始化
  */
@@ -285,6 +325,7 @@ void kbd_init(void) {
     static int inited = 0;
 
     if (!inited) {
+        tasklet_init(&kbd_tasklet, kbd_tasklet_func, (void *)0);
         update_led_status();
 
         irq_install(IRQ1_KEYBOARD, (irq_handler_t)exception_handler_kbd);
@@ -0,0 +1,61 @@
+/**
+ * 锁竞争统计设备
+ * 读出的是lock_stat_t数组，每个命名的锁一项；写入任意内容则清零统计。
+ */
+#include "dev/dev.h"
+#include "ipc/lock_stat.h"
+#include "tools/klib.h"
+
+static int lockstat_open (device_t * dev) {
+	return 0;
+}
+
+/**
+ * @brief 从addr处开始读取，每项单独取出
+ */
+static int lockstat_read (device_t * dev, int addr, char * buf, int size) {
+	int len = 0;
+	while (len < size) {
+		int index = (addr + len) / sizeof(lock_stat_t);
+		int offset = (addr + len) % sizeof(lock_stat_t);
+
+		lock_stat_t stat;
+		if (lock_stat_read(index, &stat) < 0) {
+			break;
+		}
+
+		int copy = sizeof(lock_stat_t) - offset;
+		if (copy > size - len) {
+			copy = size - len;
+		}
+		kernel_memcpy(buf + len, (char *)&stat + offset, copy);
+		len += copy;
+	}
+	return len;
+}
+
+/**
+ * @brief 写入任意内容，清零统计
+ */
+static int lockstat_write (device_t * dev, int addr, char * buf, int size) {
+	lock_stat_reset();
+	return size;
+}
+
+static int lockstat_control (device_t * dev, int cmd, int arg0, int arg1) {
+	return -1;
+}
+
+static void lockstat_close (device_t * dev) {
+}
+
+// 设备描述表
+dev_desc_t dev_lockstat_desc = {
+	.name = "lockstat",
+	.major = DEV_LOCKSTAT,
+	.open = lockstat_open,
+	.read = lockstat_read,
+	.write = lockstat_write,
+	.control = lockstat_control,
+	.close = lockstat_close,
+};
@@ -0,0 +1,41 @@
+/**
+ * 采样性能分析设备
+ * 读取时取走已缓存的prof_sample_t样本，写入的第一个字节为PROF_CMD_xxx控制命令。
+ */
+#include "dev/dev.h"
+#include "core/prof.h"
+
+static int prof_dev_open (device_t * dev) {
+	return 0;
+}
+
+static int prof_dev_read (device_t * dev, int addr, char * buf, int size) {
+	return prof_read(buf, size);
+}
+
+static int prof_dev_write (device_t * dev, int addr, char * buf, int size) {
+	return (prof_control(buf[0]) < 0) ? -1 : size;
+}
+
+static int prof_dev_control (device_t * dev, int cmd, int arg0, int arg1) {
+	return prof_control(cmd);
+}
+
+/**
+ * @brief 最后一个使用者关闭时停止采样
+ * 调用时持有设备表的自旋锁，不能打印日志
+ */
+static void prof_dev_close (device_t * dev) {
+	prof_stop();
+}
+
+// 设备描述表
+dev_desc_t dev_prof_desc = {
+	.name = "prof",
+	.major = DEV_PROF,
+	.open = prof_dev_open,
+	.read = prof_dev_read,
+	.write = prof_dev_write,
+	.control = prof_dev_control,
+	.close = prof_dev_close,
+};
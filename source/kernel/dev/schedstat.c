@@ -0,0 +1,51 @@
+/**
+ * 调度统计设备
+ * 次设备号为0时读取全局统计，否则读取pid等于次设备号的任务的统计。
+ * 读出的是一个sched_stat_t，写入任意内容则清零对应的延迟统计。
+ */
+#include "dev/dev.h"
+#include "core/schedstat.h"
+#include "tools/klib.h"
+
+static int schedstat_open (device_t * dev) {
+	return 0;
+}
+
+static int schedstat_dev_read (device_t * dev, int addr, char * buf, int size) {
+	if ((addr < 0) || (addr >= sizeof(sched_stat_t))) {
+		return 0;
+	}
+
+	sched_stat_t stat;
+	if (schedstat_read(dev->minor, &stat) < 0) {
+		return -1;
+	}
+
+	if (size > sizeof(sched_stat_t) - addr) {
+		size = sizeof(sched_stat_t) - addr;
+	}
+	kernel_memcpy(buf, (char *)&stat + addr, size);
+	return size;
+}
+
+static int schedstat_write (device_t * dev, int addr, char * buf, int size) {
+	return (schedstat_reset(dev->minor) < 0) ? -1 : size;
+}
+
+static int schedstat_control (device_t * dev, int cmd, int arg0, int arg1) {
+	return -1;
+}
+
+static void schedstat_close (device_t * dev) {
+}
+
+// 设备描述表
+dev_desc_t dev_schedstat_desc = {
+	.name = "schedstat",
+	.major = DEV_SCHEDSTAT,
+	.open = schedstat_open,
+	.read = schedstat_dev_read,
+	.write = schedstat_write,
+	.control = schedstat_control,
+	.close = schedstat_close,
+};
@@ -0,0 +1,73 @@
+/**
+ * 串口设备
+ * 次设备号为串口编号，只支持轮询发送，供应用把结果送到主机，如QEMU的-serial指定的文件。
+ * 多个任务同时写入时内容可能交错。
+ * 参考资料：https://wiki.osdev.org/Serial_Ports
+ */
+#include "dev/dev.h"
+#include "comm/cpu_instr.h"
+
+#define SERIAL_LSR              5           // 线路状态寄存器
+#define SERIAL_LSR_THRE         (1 << 5)    // 发送保持寄存器空
+
+static const uint16_t serial_ports[] = {0x3F8, 0x2F8};
+
+/**
+ * @brief 初始化为38400波特率，8位数据，无校验，1位停止位，不使用中断
+ */
+static int serial_open (device_t * dev) {
+	if ((dev->minor < 0) || (dev->minor >= sizeof(serial_ports) / sizeof(serial_ports[0]))) {
+		return -1;
+	}
+
+	uint16_t port = serial_ports[dev->minor];
+	outb(port + 1, 0x00);    // 关闭中断
+	outb(port + 3, 0x80);    // 设置DLAB，开始写波特率除数
+	outb(port + 0, 0x03);    // 除数3，即38400
+	outb(port + 1, 0x00);
+	outb(port + 3, 0x03);    // 8位数据，无校验，1位停止位
+	outb(port + 2, 0xC7);    // 开启并清空FIFO
+	outb(port + 4, 0x0B);    // DTR、RTS及OUT2
+	return 0;
+}
+
+static int serial_read (device_t * dev, int addr, char * buf, int size) {
+	return -1;
+}
+
+static void serial_putc (uint16_t port, char c) {
+	while ((inb(port + SERIAL_LSR) & SERIAL_LSR_THRE) == 0) {}
+	outb(port, c);
+}
+
+/**
+ * @brief 逐个字符发送，换行转为回车换行
+ */
+static int serial_write (device_t * dev, int addr, char * buf, int size) {
+	uint16_t port = serial_ports[dev->minor];
+	for (int i = 0; i < size; i++) {
+		if (buf[i] == '\n') {
+			serial_putc(port, '\r');
+		}
+		serial_putc(port, buf[i]);
+	}
+	return size;
+}
+
+static int serial_control (device_t * dev, int cmd, int arg0, int arg1) {
+	return -1;
+}
+
+static void serial_close (device_t * dev) {
+}
+
+// 设备描述表
+dev_desc_t dev_serial_desc = {
+	.name = "serial",
+	.major = DEV_SERIAL,
+	.open = serial_open,
+	.read = serial_read,
+	.write = serial_write,
+	.control = serial_control,
+	.close = serial_close,
+};
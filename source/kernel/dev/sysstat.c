@@ -0,0 +1,70 @@
+/**
+ * 系统调用统计设备
+ * 次设备号为0时读取全局统计，否则读取pid等于次设备号的任务的统计。
+ * 读出的是syscall_stat_t数组，写入任意内容则清零对应的统计。
+ */
+#include "dev/dev.h"
+#include "core/syscall.h"
+#include "core/syscall_stat.h"
+#include "tools/klib.h"
+
+static int sysstat_open (device_t * dev) {
+	return 0;
+}
+
+/**
+ * @brief 从addr处开始读取，每项单独取出，不需要整表的缓冲区
+ */
+static int sysstat_read (device_t * dev, int addr, char * buf, int size) {
+	int len = 0;
+	while (len < size) {
+		int index = (addr + len) / sizeof(syscall_stat_t);
+		int offset = (addr + len) % sizeof(syscall_stat_t);
+
+		syscall_stat_t stat;
+		if (syscall_stat_read(dev->minor, index, &stat) < 0) {
+			break;
+		}
+
+		int copy = sizeof(syscall_stat_t) - offset;
+		if (copy > size - len) {
+			copy = size - len;
+		}
+		kernel_memcpy(buf + len, (char *)&stat + offset, copy);
+		len += copy;
+	}
+
+	// 读到末尾返回0，任务不存在时报错
+	if ((len == 0) && dev->minor) {
+		syscall_stat_t stat;
+		if (syscall_stat_read(dev->minor, 0, &stat) < 0) {
+			return -1;
+		}
+	}
+	return len;
+}
+
+/**
+ * @brief 写入任意内容，清零统计
+ */
+static int sysstat_write (device_t * dev, int addr, char * buf, int size) {
+	return (syscall_stat_reset(dev->minor) < 0) ? -1 : size;
+}
+
+static int sysstat_control (device_t * dev, int cmd, int arg0, int arg1) {
+	return -1;
+}
+
+static void sysstat_close (device_t * dev) {
+}
+
+// 设备描述表
+dev_desc_t dev_sysstat_desc = {
+	.name = "sysstat",
+	.major = DEV_SYSSTAT,
+	.open = sysstat_open,
+	.read = sysstat_read,
+	.write = sysstat_write,
+	.control = sysstat_control,
+	.close = sysstat_close,
+};
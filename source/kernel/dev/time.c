@@ -1,26 +1,261 @@
 //
 // https://wiki.osdev.org/Programmable_Interval_Timer
+// https://wiki.osdev.org/CMOS
 //
 
 #include "dev/time.h"
 #include "cpu/irq.h"
+#include "cpu/cpu.h"
+#include "cpu/apic.h"
+#include "cpu/smp.h"
+#include "cpu/softirq.h"
 #include "comm/cpu_instr.h"
 #include "os_cfg.h"
 #include "core/task.h"
+#include "core/memory.h"
+#include "core/prof.h"
+#include "tools/klib.h"
+#include "tools/log.h"
 
 static uint32_t sys_tick;						// 系统启动后的tick数量
 
+// 共享时间页，单独占一页，以便只读映射给应用
+time_page_t time_page __attribute__((aligned(MEM_PAGE_SIZE)));
+
+/**
+ * @brief 获取启动以来的tick数
+ */
+uint32_t time_get_ticks (void) {
+    return sys_tick;
+}
+
+/**
+ * @brief 获取TSC的频率，单位kHz，没有可用的TSC时为0
+ */
+uint32_t time_get_tsc_khz (void) {
+    return time_page.tsc_khz;
+}
+
+/**
+ * @brief 获取启动以来的时长，单位ns
+ */
+uint64_t time_get_ns (void) {
+    if (time_page.tsc_mult) {
+        return time_tsc_to_ns(rdtsc() - time_page.boot_tsc, time_page.tsc_mult, time_page.tsc_shift);
+    }
+
+    return (uint64_t)sys_tick * TIME_NSEC_PER_TICK;
+}
+
+/**
+ * @brief 获取指定时钟的时间
+ */
+void time_get (int clock, time_spec_t * ts) {
+    time_page_read(&time_page, ts);
+    if (clock == TIME_CLOCK_REALTIME) {
+        ts->sec += time_page.real_sec;
+    }
+}
+
+/**
+ * @brief 每个tick刷新一次时间页
+ * 每次都从启动时的TSC算起，避免误差累积
+ * 各CPU的TSC可能略有差异，读取时只保证不早于最近一次更新的时间，见time_page_read
+ */
+static void time_page_update (void) {
+    uint64_t ns = time_get_ns();
+
+    uint32_t nsec;
+    uint64_t sec = kernel_div64(ns, TIME_NSEC_PER_SEC, &nsec);
+
+    time_page.seq++;
+    __asm__ __volatile__("" ::: "memory");
+
+    time_page.tick = sys_tick;
+    time_page.base_ns = ns;
+    time_page.base_sec = sec;
+    time_page.base_nsec = nsec;
+
+    __asm__ __volatile__("" ::: "memory");
+    time_page.seq++;
+}
+
 /**
- * 定时器中断处理函数
+ * @brief 定时器软中断，开中断下进行时间片和延时队列的处理
+ */
+static void timer_softirq (void) {
+    task_time_tick();
+}
+
+/**
+ * 定时器中断处理函数，只更新时间，调度处理放到软中断中
  */
 void do_handler_timer (exception_frame_t *frame) {
-    sys_tick++;
+    cpu_t * cpu = cpu_current();
+
+    // 记下被中断时是在用户态还是内核态，由软中断计入当前任务
+    if (frame->cs & SEG_RPL3) {
+        cpu->pending_utime++;
+    } else {
+        cpu->pending_stime++;
+    }
+    prof_tick(frame);
+
+    // 每个CPU都有自己的定时器，系统时间只由BSP更新
+    if (cpu->id == 0) {
+        sys_tick++;
+        time_page_update();
+    }
 
     // 先发EOI，而不是放在最后
     // 放最后将从任务中切换出去之后，除非任务再切换回来才能继续噢应
-    pic_send_eoi(IRQ0_TIMER);
+    irq_send_eoi(IRQ0_TIMER);
 
-    task_time_tick();
+    raise_softirq(SOFTIRQ_TIMER);
+    irq_exit();
+}
+
+/**
+ * @brief 用PIT通道2忙等待指定的ms数，最多约55ms
+ * 通道2不产生中断，通过0x61端口查询其输出状态，因此可在开中断之前用于校准其它时钟
+ */
+void time_pit_delay (uint32_t ms) {
+    uint32_t count = PIT_OSC_FREQ * ms / 1000;
+
+    // 打开通道2的门控，关闭扬声器
+    uint8_t gate = inb(PIT_CH2_GATE_PORT);
+    outb(PIT_CH2_GATE_PORT, (gate & ~PIT_CH2_SPEAKER) | PIT_CH2_GATE);
+
+    // 模式0：计数到0后输出变为高电平
+    outb(PIT_COMMAND_MODE_PORT, PIT_CHANNLE2 | PIT_LOAD_LOHI | PIT_MODE0);
+    outb(PIT_CHANNEL2_DATA_PORT, count & 0xFF);
+    outb(PIT_CHANNEL2_DATA_PORT, (count >> 8) & 0xFF);
+
+    for (uint32_t i = 0; i < 0x10000000; i++) {
+        if (inb(PIT_CH2_GATE_PORT) & PIT_CH2_OUT) {
+            break;
+        }
+    }
+
+    outb(PIT_CH2_GATE_PORT, gate);
+}
+
+/**
+ * @brief 忙等待指定的us数，有TSC时用TSC计时，否则用PIT，至少等待1ms
+ */
+void time_udelay (uint32_t us) {
+    if (!time_page.tsc_mult) {
+        time_pit_delay((us + 999) / 1000);
+        return;
+    }
+
+    uint64_t end = time_get_ns() + (uint64_t)us * 1000;
+    while (time_get_ns() < end) {
+        pause();
+    }
+}
+
+/**
+ * @brief 测量TSC的频率，单位KHz
+ */
+static uint32_t tsc_calibrate (void) {
+    uint64_t start = rdtsc();
+    time_pit_delay(TIME_CALIBRATE_MS);
+    uint64_t end = rdtsc();
+
+    // 校准时间很短，差值不会超出32位
+    return (uint32_t)(end - start) / TIME_CALIBRATE_MS;
+}
+
+/**
+ * @brief 初始化TSC时钟源
+ */
+static void init_tsc (void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+
+    if (!(edx & CPUID_FEAT_EDX_TSC)) {
+        log_printf("no tsc found, time resolution: %dms", OS_TICK_MS);
+        return;
+    }
+
+    uint32_t khz = tsc_calibrate();
+    if (khz == 0) {
+        log_printf("tsc calibrate failed, time resolution: %dms", OS_TICK_MS);
+        return;
+    }
+
+    // mult = (10^6 << shift) / khz，即每个周期的ns数，定点表示
+    time_page.tsc_khz = khz;
+    time_page.tsc_shift = TIME_TSC_SHIFT;
+    time_page.tsc_mult = (uint32_t)kernel_div64((uint64_t)1000000 << TIME_TSC_SHIFT, khz, (uint32_t *)0);
+    time_page.boot_tsc = rdtsc();
+
+    log_printf("tsc: %d KHz", khz);
+}
+
+static uint8_t cmos_read (uint8_t reg) {
+    outb(CMOS_ADDR_PORT, reg);
+    return inb(CMOS_DATA_PORT);
+}
+
+static uint32_t bcd_to_bin (uint32_t v) {
+    return (v & 0xF) + (v >> 4) * 10;
+}
+
+/**
+ * @brief 计算从1970-01-01起的天数
+ * 参考：http://howardhinnant.github.io/date_algorithms.html
+ */
+static uint32_t days_from_civil (int year, int mon, int day) {
+    year -= mon <= 2;
+    int era = year / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (mon + (mon > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * @brief 从RTC读取当前的UTC时间
+ */
+static uint32_t rtc_read_time (void) {
+    // 等待RTC更新完成，避免读到一半更新的值
+    while (cmos_read(CMOS_RTC_STATUS_A) & CMOS_STATUS_A_UIP) {}
+
+    uint32_t sec = cmos_read(CMOS_RTC_SEC);
+    uint32_t min = cmos_read(CMOS_RTC_MIN);
+    uint32_t hour = cmos_read(CMOS_RTC_HOUR);
+    uint32_t day = cmos_read(CMOS_RTC_DAY);
+    uint32_t mon = cmos_read(CMOS_RTC_MON);
+    uint32_t year = cmos_read(CMOS_RTC_YEAR);
+    uint8_t status = cmos_read(CMOS_RTC_STATUS_B);
+
+    // 12小时制时，最高位表示下午
+    int pm = hour & 0x80;
+    hour &= 0x7F;
+
+    if (!(status & CMOS_STATUS_B_BIN)) {
+        sec = bcd_to_bin(sec);
+        min = bcd_to_bin(min);
+        hour = bcd_to_bin(hour);
+        day = bcd_to_bin(day);
+        mon = bcd_to_bin(mon);
+        year = bcd_to_bin(year);
+    }
+
+    if (!(status & CMOS_STATUS_B_24H)) {
+        hour %= 12;
+        if (pm) {
+            hour += 12;
+        }
+    }
+
+    // 不读取世纪寄存器，简单认为是2000年之后
+    year += 2000;
+
+    uint32_t days = days_from_civil(year, mon, day);
+    return days * 86400 + hour * 3600 + min * 60 + sec;
 }
 
 /**
@@ -51,7 +286,49 @@ static void init_pit (void) {
 void time_init (void) {
     sys_tick = 0;
 
-    init_pit();
+    kernel_memset(&time_page, 0, sizeof(time_page));
+    init_tsc();
+    time_page.real_sec = rtc_read_time();
+    time_page_update();
+    softirq_install(SOFTIRQ_TIMER, timer_softirq);
+
+    // 有LAPIC时用其定时器产生tick，否则使用PIT
+    if (lapic_timer_start(IRQ0_TIMER, OS_TICK_MS) == 0) {
+        irq_install(IRQ0_TIMER, (irq_handler_t)exception_handler_timer);
+    } else {
+        init_pit();
+    }
+}
+
+/**
+ * @brief 获取时间
+ */
+int sys_clock_gettime (int clock, time_spec_t * ts) {
+    if (!ts) {
+        return -1;
+    }
+
+    switch (clock) {
+    case TIME_CLOCK_REALTIME:
+    case TIME_CLOCK_MONOTONIC:
+    case TIME_CLOCK_MONOTONIC_RAW:
+        time_get(clock, ts);
+        return 0;
+    default:
+        return -1;
+    }
 }
 
+/**
+ * @brief 获取当前的UTC时间，时区不支持
+ */
+int sys_gettimeofday (time_val_t * tv, void * tz) {
+    if (tv) {
+        time_spec_t ts;
+        time_get(TIME_CLOCK_REALTIME, &ts);
 
+        tv->sec = ts.sec;
+        tv->usec = ts.nsec / 1000;
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * 内核事件跟踪设备
+ * 读取时取走已缓存的trace_event_t记录，写入4字节的事件类掩码开始或停止跟踪。
+ */
+#include "dev/dev.h"
+#include "core/trace.h"
+#include "tools/klib.h"
+
+static int trace_dev_open (device_t * dev) {
+	return 0;
+}
+
+static int trace_dev_read (device_t * dev, int addr, char * buf, int size) {
+	return trace_read(buf, size);
+}
+
+static int trace_dev_write (device_t * dev, int addr, char * buf, int size) {
+	if (size != sizeof(uint32_t)) {
+		return -1;
+	}
+
+	uint32_t mask;
+	kernel_memcpy(&mask, buf, sizeof(mask));
+	return (trace_set_mask(mask & TRACE_CLASS_ALL) < 0) ? -1 : size;
+}
+
+static int trace_dev_control (device_t * dev, int cmd, int arg0, int arg1) {
+	return -1;
+}
+
+/**
+ * @brief 最后一个使用者关闭时停止跟踪
+ * 调用时持有设备表的自旋锁，不能进入互斥锁，直接清除掩码即可
+ */
+static void trace_dev_close (device_t * dev) {
+	// 在设备表的自旋锁中调用，不能进入trace_mutex
+	trace_stop();
+}
+
+// 设备描述表
+dev_desc_t dev_trace_desc = {
+	.name = "trace",
+	.major = DEV_TRACE,
+	.open = trace_dev_open,
+	.read = trace_dev_read,
+	.write = trace_dev_write,
+	.control = trace_dev_control,
+	.close = trace_dev_close,
+};
@@ -12,53 +12,6 @@
 static tty_t tty_devs[TTY_NR];
 static int curr_tty = 0;
 
-/**
- * @brief FIFO初始化
- */
-void tty_fifo_init (tty_fifo_t * fifo, char * buf, int size) {
-	fifo->buf = buf;
-	fifo->count = 0;
-	fifo->size = size;
-	fifo->read = fifo->write = 0;
-}
-
-/**
- * @brief 取一字节数据
- */
-int tty_fifo_get (tty_fifo_t * fifo, char * c) {
-	if (fifo->count <= 0) {
-		return -1;
-	}
-
-	irq_state_t state = irq_enter_protection();
-	*c = fifo->buf[fifo->read++];
-	if (fifo->read >= fifo->size) {
-		fifo->read = 0;
-	}
-	fifo->count--;
-	irq_leave_protection(state);
-	return 0;
-}
-
-/**
- * @brief 写一字节数据
- */
-int tty_fifo_put (tty_fifo_t * fifo, char c) {
-	if (fifo->count >= fifo->size) {
-		return -1;
-	}
-
-	irq_state_t state = irq_enter_protection();
-	fifo->buf[fifo->write++] = c;
-	if (fifo->write >= fifo->size) {
-		fifo->write = 0;
-	}
-	fifo->count++;
-	irq_leave_protection(state);
-
-	return 0;
-}
-
 /**
  * @brief 判断tty是否有效
  */
@@ -85,8 +38,10 @@ int tty_open (device_t * dev)  {
 	tty_t * tty = tty_devs + idx;
 	tty_fifo_init(&tty->ofifo, tty->obuf, TTY_OBUF_SIZE);
 	sem_init(&tty->osem, TTY_OBUF_SIZE);
+	sem_set_name(&tty->osem, "tty_out");
 	tty_fifo_init(&tty->ififo, tty->ibuf, TTY_IBUF_SIZE);
 	sem_init(&tty->isem, 0);
+	sem_set_name(&tty->isem, "tty_in");
 
 	tty->iflags = TTY_INLCR | TTY_IECHO;
 	tty->oflags = TTY_OCRLF;
@@ -0,0 +1,55 @@
+/**
+ * tty的收发缓冲区
+ * 不依赖具体硬件，主机上的测试也直接编译该文件，见test/host
+ */
+#include "dev/tty.h"
+
+/**
+ * @brief FIFO初始化
+ */
+void tty_fifo_init (tty_fifo_t * fifo, char * buf, int size) {
+	fifo->buf = buf;
+	fifo->count = 0;
+	fifo->size = size;
+	fifo->read = fifo->write = 0;
+	spinlock_init(&fifo->lock);
+}
+
+/**
+ * @brief 取一字节数据
+ */
+int tty_fifo_get (tty_fifo_t * fifo, char * c) {
+	irq_state_t state = spin_lock_irqsave(&fifo->lock);
+	if (fifo->count <= 0) {
+		spin_unlock_irqrestore(&fifo->lock, state);
+		return -1;
+	}
+
+	*c = fifo->buf[fifo->read++];
+	if (fifo->read >= fifo->size) {
+		fifo->read = 0;
+	}
+	fifo->count--;
+	spin_unlock_irqrestore(&fifo->lock, state);
+	return 0;
+}
+
+/**
+ * @brief 写一字节数据
+ */
+int tty_fifo_put (tty_fifo_t * fifo, char c) {
+	irq_state_t state = spin_lock_irqsave(&fifo->lock);
+	if (fifo->count >= fifo->size) {
+		spin_unlock_irqrestore(&fifo->lock, state);
+		return -1;
+	}
+
+	fifo->buf[fifo->write++] = c;
+	if (fifo->write >= fifo->size) {
+		fifo->write = 0;
+	}
+	fifo->count++;
+	spin_unlock_irqrestore(&fifo->lock, state);
+
+	return 0;
+}
@@ -14,7 +14,47 @@ static devfs_type_t devfs_type_list[] = {
         .name = "tty",
         .dev_type = DEV_TTY,
         .file_type = FILE_TTY,
-    }
+    },
+    {
+        .name = "sysstat",
+        .dev_type = DEV_SYSSTAT,
+        .file_type = FILE_DEV,
+    },
+    {
+        .name = "prof",
+        .dev_type = DEV_PROF,
+        .file_type = FILE_DEV,
+    },
+    {
+        .name = "trace",
+        .dev_type = DEV_TRACE,
+        .file_type = FILE_DEV,
+    },
+    {
+        .name = "lockstat",
+        .dev_type = DEV_LOCKSTAT,
+        .file_type = FILE_DEV,
+    },
+    {
+        .name = "irqlat",
+        .dev_type = DEV_IRQLAT,
+        .file_type = FILE_DEV,
+    },
+    {
+        .name = "boottime",
+        .dev_type = DEV_BOOTTIME,
+        .file_type = FILE_DEV,
+    },
+    {
+        .name = "schedstat",
+        .dev_type = DEV_SCHEDSTAT,
+        .file_type = FILE_DEV,
+    },
+    {
+        .name = "serial",
+        .dev_type = DEV_SERIAL,
+        .file_type = FILE_DEV,
+    },
 };
 /**
  * @brief 挂载指定设备
@@ -45,7 +85,7 @@ int devfs_open (struct _fs_t * fs, const char * path, file_t * file) {
 
         // 如果存在挂载点路径，则跳过该路径，取下级子目录
         if (kernel_strncmp(path, type->name, type_name_len) == 0) {
-            int minor;
+            int minor = 0;
 
             // 转换得到设备子序号
             if ((kernel_strlen(path) > type_name_len) && (path_to_num(path + type_name_len, &minor)) < 0) {
@@ -77,7 +117,11 @@ int devfs_open (struct _fs_t * fs, const char * path, file_t * file) {
  * @brief 读写指定的文件系统
  */
 int devfs_read (char * buf, int size, file_t * file) {
-    return dev_read(file->dev_id, file->pos, buf, size);
+    int len = dev_read(file->dev_id, file->pos, buf, size);
+    if (len > 0) {
+        file->pos += len;       // 按位置读取的设备需要，tty忽略位置
+    }
+    return len;
 }
 
 /**
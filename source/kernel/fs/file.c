@@ -48,6 +48,20 @@ void file_inc_ref (file_t * file) {
     mutex_unlock(&file_alloc_mutex);
 }
 
+/**
+ * @brief 减少file的引用计数，返回是否为最后一个引用
+ * 最后一个引用时计数保持为1，调用者关闭文件后再用file_free释放，以免关闭前被重新分配
+ */
+int file_dec_ref (file_t * file) {
+    mutex_lock(&file_alloc_mutex);
+    int last = (file->ref == 1);
+    if (file->ref > 1) {
+        file->ref--;
+    }
+    mutex_unlock(&file_alloc_mutex);
+    return last;
+}
+
 /**
  * @brief 文件表初始化
  */
@@ -55,4 +69,5 @@ void file_table_init (void) {
 	// 文件描述符表初始化
 	kernel_memset(&file_table, 0, sizeof(file_table));
 	mutex_init(&file_alloc_mutex);
+	mutex_set_name(&file_alloc_mutex, "file_alloc");
 }
@@ -27,6 +27,16 @@ extern fs_op_t devfs_op;
 
 static uint8_t * temp_pos;       // 当前位置
 
+// 临时使用：应用程序直接写在磁盘的固定扇区上，每个最多读取80KB，见script/img-write-linux.sh
+#define TEMP_FILE_SECTORS	160
+static const struct {
+	const char * name;
+	int sector;						// 起始扇区
+}temp_files[] = {
+	{"/shell.elf", 5000},
+	{"/bench.elf", 5200},
+};
+
 /**
 * 使用LBA48位模式读取磁盘
 */
@@ -214,13 +224,14 @@ static void fs_unprotect (fs_t * fs) {
  * 打开文件
  */
 int sys_open(const char *name, int flags, ...) {
-	// 临时使用，保留shell加载的功能
-	if (kernel_strncmp(name, "/shell.elf", 4) == 0) {
-        // 暂时直接从扇区1000上读取, 读取大概40KB，足够了
-        read_disk(5000, 80, (uint8_t *)TEMP_ADDR);
-        temp_pos = (uint8_t *)TEMP_ADDR;
-        return TEMP_FILE_ID;
-    }
+	// 临时使用，保留shell等应用加载的功能
+	for (int i = 0; i < sizeof(temp_files) / sizeof(temp_files[0]); i++) {
+		if (kernel_strncmp(name, temp_files[i].name, kernel_strlen(temp_files[i].name)) == 0) {
+	        read_disk(temp_files[i].sector, TEMP_FILE_SECTORS, (uint8_t *)TEMP_ADDR);
+	        temp_pos = (uint8_t *)TEMP_ADDR;
+	        return TEMP_FILE_ID;
+		}
+	}
 
 	// 分配文件描述符链接
 	file_t * file = file_alloc();
@@ -292,12 +303,14 @@ int sys_dup (int file) {
 		return -1;
 	}
 
+	// 先增加引用，新fd一旦分配，其它线程就可能将其关闭
+	file_inc_ref(p_file);
 	int fd = task_alloc_fd(p_file);	// 新fd指向同一描述符
 	if (fd >= 0) {
-		file_inc_ref(p_file);
 		return fd;
 	}
 
+	fs_file_close(p_file);
 	log_printf("No task file avaliable");
     return -1;
 }
@@ -390,6 +403,22 @@ int sys_lseek(int file, int ptr, int dir) {
 	return err;
 }
 
+/**
+ * @brief 减少文件的引用，最后一个引用时关闭文件
+ */
+void fs_file_close (file_t * file) {
+	ASSERT(file->ref > 0);
+
+	if (file_dec_ref(file)) {
+		fs_t * fs = file->fs;
+
+		fs_protect(fs);
+		fs->op->close(file);
+		fs_unprotect(fs);
+	    file_free(file);
+	}
+}
+
 /**
  * 关闭文件
  */
@@ -403,24 +432,14 @@ int sys_close(int file) {
 		return -1;
 	}
 
-	file_t * p_file = task_file(file);
+	// 先从文件表中取出，只关闭取到的文件
+	file_t * p_file = task_take_fd(file);
 	if (p_file == (file_t *)0) {
 		log_printf("file not opened. %d", file);
 		return -1;
 	}
 
-	ASSERT(p_file->ref > 0);
-
-	if (p_file->ref-- == 1) {
-		fs_t * fs = p_file->fs;
-
-		fs_protect(fs);
-		fs->op->close(p_file);
-		fs_unprotect(fs);
-	    file_free(p_file);
-	}
-
-	task_remove_fd(file);
+	fs_file_close(p_file);
 	return 0;
 }
 
@@ -0,0 +1,30 @@
+/**
+ * 启动各阶段的时间戳，内核与应用程序共用
+ * 前几个阶段由boot和loader通过boot_info_t传入，其余由内核在初始化过程中记录，
+ * 最后一个阶段由shell在第一次显示提示符前写/dev/boottime记录。
+ * 读/dev/boottime得到uint64_t数组，每个阶段一项，为该阶段结束时的TSC，未记录的为0。
+ */
+#ifndef BOOTTIME_H
+#define BOOTTIME_H
+
+#include "comm/types.h"
+#include "comm/boot_info.h"
+
+#define BOOT_STAGE_KERNEL           6       // 进入kernel_init
+#define BOOT_STAGE_CPU              7       // CPU、中断及日志初始化完成
+#define BOOT_STAGE_MEMORY           8       // 内存管理初始化完成
+#define BOOT_STAGE_SMP              9       // APIC及多处理器检测完成
+#define BOOT_STAGE_FS               10      // 系统调用、跟踪及文件系统初始化完成
+#define BOOT_STAGE_TIME             11      // 时钟初始化完成，包括TSC校准
+#define BOOT_STAGE_TASK             12      // 任务管理初始化完成
+#define BOOT_STAGE_START_AP         13      // 其它CPU已启动
+#define BOOT_STAGE_FIRST_TASK       14      // 第一个任务已创建
+#define BOOT_STAGE_WORKQUEUE        15      // 工作队列初始化完成，即将进入第一个任务
+#define BOOT_STAGE_SHELL            16      // shell第一次显示提示符
+#define BOOT_STAGE_NR               17
+
+void boottime_init (boot_info_t * boot_info);
+void boottime_stamp (int stage);
+int boottime_read (int offset, char * buf, int size);
+
+#endif // BOOTTIME_H
@@ -0,0 +1,30 @@
+/**
+ * 固定大小对象的缓存
+ * 以页为单位从物理页分配器取得内存，切分成大小相同的对象后挂在空闲链表上，
+ * 分配和释放都只需在链表头操作。
+ */
+#ifndef MEM_CACHE_H
+#define MEM_CACHE_H
+
+#include "comm/types.h"
+#include "ipc/spinlock.h"
+
+/**
+ * @brief 对象缓存
+ */
+typedef struct _mem_cache_t {
+    const char * name;
+    int obj_size;               // 对齐后的对象大小
+    int obj_per_page;           // 每页可容纳的对象数
+    int max_count;              // 最多可分配的对象数，0为不限制
+    int count;                  // 已分配出去的对象数
+    int page_count;             // 已占用的页数
+    void * free_obj;            // 空闲对象链表，链接指针放在对象的起始处
+    spinlock_t lock;
+}mem_cache_t;
+
+void mem_cache_init (mem_cache_t * cache, const char * name, int obj_size, int align, int max_count);
+void * mem_cache_alloc (mem_cache_t * cache);
+void mem_cache_free (mem_cache_t * cache, void * obj);
+
+#endif // MEM_CACHE_H
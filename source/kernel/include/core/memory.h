@@ -13,6 +13,9 @@
 #define MEM_EXT_END                 (128*1024*1024 - 1)
 #define MEM_PAGE_SIZE               4096        // 和页表大小一致
 
+#define MEM_MMIO_BASE               (0x70000000)        // 设备寄存器的映射区域
+#define MEM_MMIO_SIZE               (16*1024*1024)
+
 #define MEMORY_TASK_BASE            (0x80000000)        // 进程起始地址空间
 #define MEM_TASK_STACK_TOP          (0xE0000000)        // 初始栈的位置  
 #define MEM_TASK_STACK_SIZE         (MEM_PAGE_SIZE * 500)   // 初始500KB栈
@@ -41,14 +44,18 @@ typedef struct _memory_map_t {
 
 void memory_init (boot_info_t * boot_info);
 uint32_t memory_create_uvm (void);
+uint32_t memory_kernel_page_dir (void);
 uint32_t memory_alloc_for_page_dir (uint32_t page_dir, uint32_t vaddr, uint32_t size, int perm);
 int memory_alloc_page_for (uint32_t addr, uint32_t size, int perm);
 uint32_t memory_alloc_page (void);
+uint32_t memory_alloc_pages (int page_count);
 void memory_free_page (uint32_t addr);
 void memory_destroy_uvm (uint32_t page_dir);
 uint32_t memory_copy_uvm (uint32_t page_dir);
 uint32_t memory_get_paddr (uint32_t page_dir, uint32_t vaddr);
+int memory_user_mapped (uint32_t page_dir, uint32_t vaddr);
 int memory_copy_uvm_data(uint32_t to, uint32_t page_dir, uint32_t from, uint32_t size);
+uint32_t memory_map_mmio (uint32_t paddr, uint32_t size);
 char * sys_sbrk(int incr);
 
 #endif // MEMORY_H
\ No newline at end of file
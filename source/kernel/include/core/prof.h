@@ -0,0 +1,41 @@
+/**
+ * 定时器采样的性能分析，内核与应用程序共用
+ * 每个CPU在时钟中断时记录被中断处的eip、cs和当前任务，可选沿帧指针记录调用栈。
+ * 向/dev/prof写入控制命令开始或停止采样，读取时取走已缓存的样本，每次只返回完整的样本。
+ * 另外，进程可用profil在自己的直方图中统计用户态的采样地址，不需要/dev/prof。
+ */
+#ifndef PROF_H
+#define PROF_H
+
+#include "comm/types.h"
+
+#define PROF_DEPTH              8           // 调用栈最多记录的返回地址数
+#define PROF_RING_SIZE          64          // 每个CPU缓存的样本数，需为2的幂，满后丢弃新样本
+
+// 写入/dev/prof的控制命令，取第一个字节
+#define PROF_CMD_STOP           '0'         // 停止采样
+#define PROF_CMD_START          '1'         // 开始采样，清空已缓存的样本
+#define PROF_CMD_CALLGRAPH      'g'         // 开始采样，并记录调用栈
+
+/**
+ * @brief 一个样本
+ */
+typedef struct _prof_sample_t {
+    uint32_t eip;                           // 被中断的指令地址
+    uint16_t cs;                            // 被中断时的代码段，低2位为特权级
+    uint8_t cpu;                            // 采样的CPU
+    uint8_t depth;                          // callchain中的有效项数
+    int pid;                                // 当前任务，空闲任务为0
+    uint32_t callchain[PROF_DEPTH];         // 返回地址，由近及远
+}prof_sample_t;
+
+struct _exception_frame_t;
+
+void prof_init (void);
+void prof_tick (struct _exception_frame_t * frame);
+int prof_read (char * buf, int size);
+int prof_control (int cmd);
+void prof_stop (void);
+int sys_profil (uint16_t * buf, uint32_t size, uint32_t offset, uint32_t scale);
+
+#endif // PROF_H
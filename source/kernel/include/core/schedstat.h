@@ -0,0 +1,48 @@
+/**
+ * 调度延迟及负载的统计，内核与应用程序共用
+ * 任务被唤醒(由等待、睡眠进入就绪队列)到真正切换运行之间的时间，按全局和任务分别统计；
+ * 负载为所有就绪队列中任务数(含正在运行的)的指数平均，与Linux的load average算法相同。
+ * 读/dev/schedstat得到全局的sched_stat_t，读/dev/schedstatN得到pid为N的任务的，写入任意内容则清零。
+ */
+#ifndef SCHEDSTAT_H
+#define SCHEDSTAT_H
+
+#include "comm/types.h"
+
+#define SCHED_HIST_NR           16          // 延迟直方图的桶数
+#define SCHED_HIST_SHIFT        10          // 第i桶为[2^(i+10), 2^(i+11))个周期，首尾两桶包含更小和更大的值
+
+#define SCHED_LOAD_SHIFT        11          // 负载的定点小数位数
+#define SCHED_LOAD_FREQ_MS      5000        // 负载的采样间隔
+
+/**
+ * @brief 唤醒到运行的延迟，时间为TSC周期数
+ */
+typedef struct _sched_wait_t {
+    uint32_t wakeups;                   // 统计的唤醒次数
+    uint32_t reserved;
+    uint64_t total;                     // 总延迟
+    uint64_t max;                       // 最长的一次
+    uint32_t hist[SCHED_HIST_NR];       // 延迟按log2分布
+}sched_wait_t;
+
+/**
+ * @brief 读取到的调度统计
+ */
+typedef struct _sched_stat_t {
+    int pid;                            // 0表示全局
+    uint32_t nr_running;                // 当前可运行的任务数，只有全局的有效
+    uint32_t loadavg[3];                // 1、5、15分钟的平均负载，定点数，只有全局的有效
+    uint32_t reserved;
+    sched_wait_t wait;
+}sched_stat_t;
+
+struct _task_t;
+
+void schedstat_wakeup (struct _task_t * task);
+void schedstat_run (struct _task_t * task);
+void schedstat_tick (void);
+int schedstat_read (int pid, sched_stat_t * stat);
+int schedstat_reset (int pid);
+
+#endif // SCHEDSTAT_H
@@ -13,6 +13,25 @@
 #define SYS_yield               4
 #define SYS_exit                5
 #define SYS_wait                6
+#define SYS_waitpid             7
+#define SYS_vfork               8
+#define SYS_spawn               9
+#define SYS_futex               10
+#define SYS_clone               11
+#define SYS_set_tls             12
+#define SYS_sched_setattr       13
+#define SYS_sched_getattr       14
+#define SYS_uring_setup         15
+#define SYS_uring_enter         16
+#define SYS_profil              17
+
+#define SYS_clock_gettime       20
+#define SYS_gettimeofday        21
+#define SYS_nanosleep           22
+
+#define SYS_times               30
+#define SYS_getrusage           31
+#define SYS_task_info           32
 
 #define SYS_open                50
 #define SYS_read                51
@@ -26,6 +45,18 @@
 
 #define SYS_printmsg            100
 
+// 以下供C代码使用，汇编文件只需要上面的系统调用号
+#ifndef __ASSEMBLER__
+
+#include "comm/types.h"
+
+// sysenter/sysexit快速系统调用使用的MSR
+#define IA32_SYSENTER_CS        0x174
+#define IA32_SYSENTER_ESP       0x175
+#define IA32_SYSENTER_EIP       0x176
+
+#define CPUID_FEAT_EDX_SEP      (1 << 11)
+
 /**
  * 系统调用的栈信息
  */
@@ -39,5 +70,34 @@ typedef struct _syscall_frame_t {
 }syscall_frame_t;
 
 void exception_handler_syscall (void);		// syscall处理
+void exception_handler_sysenter (void);		// sysenter处理
+
+/**
+ * @brief CPU是否支持sysenter/sysexit，内核和应用使用同样的判断
+ * 早期的Pentium Pro(family 6, model<3, stepping<3)虽然置了SEP位，但实际不支持
+ */
+static inline int syscall_sysenter_supported (void) {
+	// 应用程序也要使用，不引入cpu_instr.h，其中的pause与newlib冲突
+	uint32_t eax, ebx, ecx, edx;
+	__asm__ __volatile__("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1), "c"(0));
+	if (!(edx & CPUID_FEAT_EDX_SEP)) {
+		return 0;
+	}
+
+	uint32_t family = (eax >> 8) & 0xF, model = (eax >> 4) & 0xF, stepping = eax & 0xF;
+	return !((family == 6) && (model < 3) && (stepping < 3));
+}
+
+void syscall_init (void);
+void syscall_ap_init (void);
+void syscall_set_kernel_stack (uint32_t esp0);
+
+struct _task_t;
+struct _syscall_stat_t;
+int syscall_stat_read (int pid, int index, struct _syscall_stat_t * stat);
+int syscall_stat_reset (int pid);
+void syscall_stat_free (struct _task_t * task);
+
+#endif // __ASSEMBLER__
 
 #endif //OS_SYSCALL_H
@@ -0,0 +1,27 @@
+/**
+ * 系统调用的统计信息，内核与应用程序共用
+ * 读/dev/sysstat得到全局统计，读/dev/sysstatN得到pid为N的任务的统计，
+ * 内容为若干syscall_stat_t，每个已实现的系统调用一项；写入任意内容则清零。
+ */
+#ifndef SYSCALL_STAT_H
+#define SYSCALL_STAT_H
+
+#include "comm/types.h"
+
+#define SYSCALL_STAT_NR         40          // 最多统计的系统调用数，需不少于实现的数量
+#define SYSCALL_HIST_NR         16          // 延迟直方图的桶数
+#define SYSCALL_HIST_SHIFT      7           // 第i桶为[2^(i+7), 2^(i+8))个周期，首尾两桶包含更小和更大的值
+
+/**
+ * @brief 一个系统调用的统计
+ */
+typedef struct _syscall_stat_t {
+    int id;                             // 系统调用号
+    uint32_t count;                     // 调用次数
+    uint32_t errors;                    // 返回值小于0的次数
+    uint32_t reserved;
+    uint64_t cycles;                    // 总耗时，TSC周期数，包括阻塞的时间
+    uint32_t hist[SYSCALL_HIST_NR];     // 耗时按log2分布
+}syscall_stat_t;
+
+#endif // SYSCALL_STAT_H
@@ -8,6 +8,14 @@
 #include "cpu/cpu.h"
 #include "tools/list.h"
 #include "fs/file.h"
+#include "cpu/fpu.h"
+#include "dev/time.h"
+#include "cpu/smp.h"
+#include "ipc/spinlock.h"
+#include "core/workqueue.h"
+#include "core/task_info.h"
+#include "core/task_sched.h"
+#include "core/schedstat.h"
 
 #define TASK_NAME_SIZE				32			// 任务名字长度
 #define TASK_TIME_SLICE_DEFAULT		10			// 时间片计数
@@ -15,6 +23,14 @@
 
 
 #define TASK_FLAG_SYSTEM       	(1 << 0)		// 系统任务
+#define TASK_FLAG_KERNEL       	(1 << 1)		// 内核线程，使用内核页表，没有用户空间
+#define TASK_FLAG_VFORK       	(1 << 2)		// vfork创建，exec或退出前共用父进程的地址空间
+#define TASK_FLAG_THREAD       	(1 << 3)		// 线程，与创建者共用地址空间和打开的文件
+
+#define TASK_PID_MAX				32768		// pid的范围，0保留给空闲任务
+#define TASK_PID_HASH_SIZE			256			// pid哈希表的大小
+
+#define TASK_WNOHANG				1			// waitpid不等待，与newlib的WNOHANG一致
 
 typedef struct _task_args_t {
 	uint32_t ret_addr;		// 返回地址，无用
@@ -22,6 +38,42 @@ typedef struct _task_args_t {
 	char **argv;
 }task_args_t;
 
+/**
+ * @brief 任务首次运行时内核栈顶的内容，由task_entry_trampoline通过iret进入任务入口
+ * 系统任务不切换特权级，iret只弹出前三项
+ */
+typedef struct _task_start_frame_t {
+	uint32_t eip, cs, eflags;
+	uint32_t esp, ss;
+}task_start_frame_t;
+
+/**
+ * @brief 地址空间，线程及vfork的子进程共用，最后一个引用释放时销毁
+ */
+typedef struct _task_mm_t {
+	int ref;					// 引用计数，由调度锁保护
+	uint32_t page_dir;			// 页表
+	uint32_t heap_start;		// 堆的顶层地址
+	uint32_t heap_end;			// 堆结束地址
+	uint32_t uring;				// 批量系统调用队列的地址，0表示未建立
+	int uring_busy;				// 是否有线程正在建立或处理队列，由调度锁保护
+
+	// profil直方图，scale为0表示未启用，fork及execve后不保留
+	uint32_t prof_buf;			// 16位计数的数组
+	uint32_t prof_size;			// 字节数
+	uint32_t prof_offset;		// 对应第一个计数的代码地址
+	uint32_t prof_scale;		// 16.16定点，每2字节代码对应的计数个数
+}task_mm_t;
+
+/**
+ * @brief 打开的文件表，同一进程的线程共用
+ */
+typedef struct _task_files_t {
+	int ref;					// 引用计数，由调度锁保护
+	spinlock_t lock;			// 保护fd的分配
+	file_t * file_table[TASK_OFILE_NR];	// 任务最多打开的文件数量
+}task_files_t;
+
 /**
  * @brief 任务控制块结构
  */
@@ -37,20 +89,51 @@ typedef struct _task_t {
 
     char name[TASK_NAME_SIZE];		// 任务名字
 
+    int flags;				// 任务标志，TASK_FLAG_xxx
     int pid;				// 进程的pid
     struct _task_t * parent;		// 父进程
-	uint32_t heap_start;		// 堆的顶层地址
-	uint32_t heap_end;			// 堆结束地址
+    struct _task_t * vfork_parent;	// vfork后等待本进程exec或退出的父进程
+	task_usage_t usage;			// 运行统计
+	task_usage_t child_usage;	// 已回收子进程的累计统计
+	uint64_t ready_tsc;			// 被唤醒的时刻，切换运行时清0
+	sched_wait_t sched_wait;	// 唤醒到运行的延迟统计
+	uint32_t futex_key;			// 在futex上等待时，变量的物理地址
+	list_t child_list;			// 运行中的子进程
+	list_t zombie_list;			// 已退出、等待回收的子进程
+	list_node_t child_node;		// 在父进程child_list或zombie_list中的结点
+	list_node_t pid_node;		// pid哈希表结点
+	task_mm_t * mm;				// 地址空间，内核线程没有
+	task_files_t * files;		// 打开的文件表，内核线程没有
+	uint16_t tls_sel;			// 线程局部存储的段选择子，通过gs访问
+	uint32_t tls_base;			// 线程局部存储的起始地址
+	int * clear_tid;			// 线程退出时清0并唤醒在其上等待的线程
+	struct _syscall_stat_t * sysstat;	// 系统调用统计，首次系统调用时分配
 	
+	// 调度策略，实时任务位于所在CPU的rt_list中
+	int policy;					// TASK_SCHED_xxx
+	int rt_priority;			// FIFO的优先级
+	uint32_t dl_runtime;		// DEADLINE任务每周期的运行时间，tick
+	uint32_t dl_period;			// DEADLINE任务的周期，tick
+	uint32_t dl_deadline;		// 当前周期的截止时间，即系统tick数
+	int dl_left;				// 当前周期剩余的运行时间，用完后推迟到截止时间再运行
+	uint32_t dl_bw;				// 占用的带宽，单位为TASK_DL_BW_SCALE
+
     int sleep_ticks;		// 睡眠时间
     int time_slice;			// 时间片
 	int slice_ticks;		// 递减时间片计数
     int status;				// 进程执行结果
 
-    file_t * file_table[TASK_OFILE_NR];	// 任务最多打开的文件数量
+	fpu_state_t fpu_state;	// FPU/SSE寄存器保存区，延迟保存
+	int fpu_used;			// 是否使用过FPU
 
 	tss_t tss;				// 任务的TSS段#define SYS_printmsg            100
 	uint16_t tss_sel;		// tss选择子
+
+	cpu_t * cpu;			// 所在的CPU，位于该CPU的就绪队列中
+
+	void (*kthread_fn)(void * arg);	// 内核线程的入口及参数
+	void * kthread_arg;
+	work_t exit_work;		// 内核线程退出后回收资源
 	
 	list_node_t run_node;		// 运行相关结点
 	list_node_t wait_node;		// 等待队列
@@ -66,21 +149,24 @@ void task_set_wakeup (task_t *task);
 int sys_yield (void);
 void task_dispatch (void);
 task_t * task_current (void);
+irq_state_t task_lock (void);
+void task_unlock (irq_state_t state);
 void task_time_tick (void);
 void sys_msleep (uint32_t ms);
+int sys_nanosleep (const time_spec_t * req, time_spec_t * rem);
 file_t * task_file (int fd);
 int task_alloc_fd (file_t * file);
+file_t * task_take_fd (int fd);
 void task_remove_fd (int fd);
 
 typedef struct _task_manager_t {
-    task_t * curr_task;         // 当前运行的任务
+	spinlock_t lock;			// 调度锁，保护各CPU的就绪队列、延时队列及任务状态
 
-	list_t ready_list;			// 就绪队列
 	list_t task_list;			// 所有已创建任务的队列
 	list_t sleep_list;          // 延时队列
 
 	task_t first_task;			// 内核任务
-	task_t idle_task;			// 空闲任务
+	task_t idle_task[SMP_CPU_MAX];	// 每个CPU一个空闲任务
 
 	int app_code_sel;			// 任务代码段选择子
 	int app_data_sel;			// 应用任务的数据段选择子
@@ -90,11 +176,25 @@ void task_manager_init (void);
 void task_first_init (void);
 task_t * task_first_task (void);
 
+task_t * kthread_create (const char * name, void (*fn)(void * arg), void * arg);
+void kthread_exit (void);
+
 int sys_getpid (void);
 int sys_fork (void);
+int sys_vfork (void);
 int sys_execve(char *name, char **argv, char **env);
+int sys_spawn (const char * name, char ** argv, char ** env);
+int sys_clone (uint32_t entry, uint32_t stack, uint32_t tls, int * clear_tid);
+int sys_set_tls (uint32_t base);
+int sys_times (task_times_t * times);
+int sys_getrusage (int who, task_usage_t * usage);
+int sys_task_info (task_info_t * info, int count);
+int sys_sched_setattr (int pid, const task_sched_attr_t * attr);
+int sys_sched_getattr (int pid, task_sched_attr_t * attr);
 void sys_exit(int status);
 int sys_wait(int* status);
+int sys_waitpid(int pid, int * status, int options);
+task_t * task_find_pid (int pid);
 
 #endif
 
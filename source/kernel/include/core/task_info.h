@@ -0,0 +1,45 @@
+/**
+ * 任务的运行统计，内核与应用程序共用
+ */
+#ifndef TASK_INFO_H
+#define TASK_INFO_H
+
+#include "comm/types.h"
+
+#define TASK_INFO_NAME_SIZE         32          // 与TASK_NAME_SIZE一致
+
+#define TASK_RUSAGE_SELF            0           // 当前进程
+#define TASK_RUSAGE_CHILDREN        -1          // 已回收的子进程
+
+/**
+ * @brief 任务的资源使用统计，时间以tick为单位
+ */
+typedef struct _task_usage_t {
+    uint32_t utime;                 // 用户态运行的时间
+    uint32_t stime;                 // 内核态运行的时间
+    uint32_t nvcsw;                 // 主动放弃CPU的次数，如睡眠、等待
+    uint32_t nivcsw;                // 时间片用完等被动切换的次数
+    uint32_t faults;                // 处理的异常次数，如FPU的延迟加载
+}task_usage_t;
+
+/**
+ * @brief times的结果，以tick为单位
+ */
+typedef struct _task_times_t {
+    uint32_t utime, stime;          // 本进程
+    uint32_t cutime, cstime;        // 已回收的子进程
+}task_times_t;
+
+/**
+ * @brief 单个任务的信息
+ */
+typedef struct _task_info_t {
+    int pid;
+    int ppid;
+    int state;
+    int cpu;                        // 所在的CPU
+    char name[TASK_INFO_NAME_SIZE];
+    task_usage_t usage;
+}task_info_t;
+
+#endif // TASK_INFO_H
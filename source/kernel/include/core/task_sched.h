@@ -0,0 +1,30 @@
+/**
+ * 任务的调度策略，内核与应用程序共用
+ * 实时类总是优先于普通类运行：DEADLINE按最早截止时间优先，FIFO按优先级，同优先级先到先运行
+ */
+#ifndef TASK_SCHED_H
+#define TASK_SCHED_H
+
+#include "comm/types.h"
+
+#define TASK_SCHED_NORMAL           0           // 普通任务，时间片轮转，与newlib的SCHED_OTHER一致
+#define TASK_SCHED_FIFO             1           // 固定优先级，不轮转，与newlib的SCHED_FIFO一致
+#define TASK_SCHED_DEADLINE         6           // 最早截止时间优先，带带宽限制
+
+#define TASK_RT_PRIO_MIN            1           // FIFO的优先级范围，越大越优先
+#define TASK_RT_PRIO_MAX            99
+
+#define TASK_DL_BW_SCALE            1000000     // 带宽的单位，即百万分之一
+#define TASK_DL_BW_MAX              950000      // 每个CPU上DEADLINE任务的带宽上限，留给普通任务5%
+
+/**
+ * @brief 调度参数，DEADLINE任务每period毫秒最多运行runtime毫秒，截止时间为周期结束
+ */
+typedef struct _task_sched_attr_t {
+    int policy;                     // TASK_SCHED_xxx
+    int priority;                   // FIFO的优先级
+    uint32_t runtime;               // DEADLINE任务每周期的运行时间，ms
+    uint32_t period;                // DEADLINE任务的周期，ms
+}task_sched_attr_t;
+
+#endif // TASK_SCHED_H
@@ -0,0 +1,68 @@
+/**
+ * 内核事件跟踪，内核与应用程序共用
+ * 各跟踪点将事件写入当前CPU的环形缓冲区，读/dev/trace取走trace_event_t记录，
+ * 各CPU的记录分别有序，需按tsc合并。向/dev/trace写入4字节的uint32_t设置启用的事件类，
+ * 为0时停止；从0变为非0时清空缓冲区。未启用的跟踪点只有一次读取和比较。
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+// 事件类，汇编中也要使用
+#define TRACE_CLASS_SCHED       (1 << 0)        // 任务切换
+#define TRACE_CLASS_WAKEUP      (1 << 1)        // 信号量、互斥锁唤醒任务
+#define TRACE_CLASS_SYSCALL     (1 << 2)        // 系统调用进入和返回
+#define TRACE_CLASS_IRQ         (1 << 3)        // 中断和异常
+#define TRACE_CLASS_MEM         (1 << 4)        // 物理页的分配和释放
+#define TRACE_CLASS_ALL         0x1F
+
+// 事件类型及参数
+#define TRACE_SCHED_SWITCH      1               // arg0=切换到的pid, arg1=切出任务的状态
+#define TRACE_SCHED_WAKEUP      2               // arg0=被唤醒的pid, arg1=信号量或锁的地址
+#define TRACE_SYSCALL_ENTER     3               // arg0=系统调用号, arg1=第一个参数
+#define TRACE_SYSCALL_EXIT      4               // arg0=系统调用号, arg1=返回值
+#define TRACE_IRQ               5               // arg0=中断号, arg1=被中断的eip
+#define TRACE_PAGE_ALLOC        6               // arg0=物理地址, arg1=页数，失败时地址为0
+#define TRACE_PAGE_FREE         7               // arg0=物理地址, arg1=页数
+
+#define TRACE_RING_SIZE         1024            // 每个CPU缓存的事件数，需为2的幂，满后丢弃新事件
+
+#ifndef __ASSEMBLER__
+
+#include "comm/types.h"
+
+/**
+ * @brief 一条事件记录
+ */
+typedef struct _trace_event_t {
+    uint64_t tsc;                   // 时间戳，TSC周期数
+    uint16_t type;                  // TRACE_xxx事件类型
+    uint8_t cpu;                    // 产生事件的CPU
+    uint8_t reserved;
+    int pid;                        // 产生事件时的当前任务，系统任务为0
+    uint32_t arg0;
+    uint32_t arg1;
+}trace_event_t;
+
+extern volatile uint32_t trace_mask;
+
+struct _exception_frame_t;
+
+void trace_init (void);
+void trace_write (int type, uint32_t arg0, uint32_t arg1);
+void trace_irq (struct _exception_frame_t * frame);
+int trace_read (char * buf, int size);
+int trace_set_mask (uint32_t mask);
+void trace_stop (void);
+
+/**
+ * @brief 跟踪点，事件类未启用时只有一次比较
+ */
+#define trace_event(cls, type, arg0, arg1)  do { \
+        if (trace_mask & (cls)) { \
+            trace_write((type), (uint32_t)(arg0), (uint32_t)(arg1)); \
+        } \
+    } while (0)
+
+#endif // __ASSEMBLER__
+
+#endif // TRACE_H
@@ -0,0 +1,91 @@
+/**
+ * 批量系统调用的提交/完成队列，内核与应用程序共用
+ * 应用在提交队列中放入多个请求，一次uring_enter由内核依次执行，结果放入完成队列，
+ * 这样N个小操作只需要一次特权级切换。两个队列位于同一页中，映射在进程的固定地址。
+ * head/tail为一直递增的计数，取余后得到下标；提交队列由应用写tail、内核写head，完成队列相反
+ */
+#ifndef URING_H
+#define URING_H
+
+#include "comm/types.h"
+
+#define URING_ADDR              0xF0000000      // 队列在进程中的地址，在栈之上
+#define URING_SQ_ENTRIES        64              // 提交队列大小，需为2的幂
+#define URING_CQ_ENTRIES        128             // 完成队列大小，需为2的幂
+
+#define URING_OP_NOP            0               // 空操作，结果为0
+#define URING_OP_READ           1               // read(fd, addr, len)
+#define URING_OP_WRITE          2               // write(fd, addr, len)
+#define URING_OP_OPEN           3               // open(addr, len)，len为打开标志
+#define URING_OP_CLOSE          4               // close(fd)
+#define URING_OP_MSLEEP         5               // msleep(len)
+
+/**
+ * @brief 提交的请求
+ */
+typedef struct _uring_sqe_t {
+    int opcode;                     // URING_OP_xxx
+    int fd;                         // 文件描述符
+    uint32_t addr;                  // 缓冲区或文件名
+    uint32_t len;                   // 长度，含义随操作不同
+    uint32_t user_data;             // 原样放入完成项，供应用区分请求
+}uring_sqe_t;
+
+/**
+ * @brief 完成项
+ */
+typedef struct _uring_cqe_t {
+    uint32_t user_data;             // 对应请求的user_data
+    int res;                        // 和对应系统调用的返回值相同
+}uring_cqe_t;
+
+/**
+ * @brief 共享的队列页
+ */
+typedef struct _uring_t {
+    volatile uint32_t sq_head;      // 内核已取走的请求数
+    volatile uint32_t sq_tail;      // 应用已放入的请求数
+    volatile uint32_t cq_head;      // 应用已取走的完成项数
+    volatile uint32_t cq_tail;      // 内核已放入的完成项数
+    uring_sqe_t sqes[URING_SQ_ENTRIES];
+    uring_cqe_t cqes[URING_CQ_ENTRIES];
+}uring_t;
+
+/**
+ * @brief 取一个空闲的提交项，队列满时返回0。填好后调用uring_sq_push
+ */
+static inline uring_sqe_t * uring_get_sqe (uring_t * ring) {
+    if (ring->sq_tail - ring->sq_head >= URING_SQ_ENTRIES) {
+        return (uring_sqe_t *)0;
+    }
+    return ring->sqes + (ring->sq_tail & (URING_SQ_ENTRIES - 1));
+}
+
+/**
+ * @brief 提交uring_get_sqe取得的项，返回尚未被内核取走的请求数
+ */
+static inline int uring_sq_push (uring_t * ring) {
+    __asm__ __volatile__("" ::: "memory");      // 先写完请求内容，再更新tail
+    ring->sq_tail++;
+    return ring->sq_tail - ring->sq_head;
+}
+
+/**
+ * @brief 取下一个完成项，没有时返回0。处理完后调用uring_cq_pop
+ */
+static inline uring_cqe_t * uring_peek_cqe (uring_t * ring) {
+    if (ring->cq_head == ring->cq_tail) {
+        return (uring_cqe_t *)0;
+    }
+    return ring->cqes + (ring->cq_head & (URING_CQ_ENTRIES - 1));
+}
+
+static inline void uring_cq_pop (uring_t * ring) {
+    __asm__ __volatile__("" ::: "memory");
+    ring->cq_head++;
+}
+
+int sys_uring_setup (void);
+int sys_uring_enter (int to_submit);
+
+#endif // URING_H
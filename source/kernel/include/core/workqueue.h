@@ -0,0 +1,46 @@
+/**
+ * 工作队列
+ * 将不便在系统调用或中断中完成的工作，推迟到内核线程中执行
+ */
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include "comm/types.h"
+#include "tools/list.h"
+#include "ipc/sem.h"
+#include "ipc/spinlock.h"
+
+struct _work_t;
+struct _task_t;
+
+typedef void (*work_func_t)(struct _work_t * work);
+
+/**
+ * @brief 一项工作，一般嵌入在使用者的结构中，通过list_node_parent取回
+ */
+typedef struct _work_t {
+    list_node_t node;
+    work_func_t func;
+    int pending;                // 是否已在队列中
+}work_t;
+
+/**
+ * @brief 工作队列，由一个内核线程依次执行其中的工作
+ */
+typedef struct _workqueue_t {
+    list_t work_list;
+    spinlock_t lock;            // 可在中断中加入工作
+    sem_t sem;                  // 队列中工作的数量
+    struct _task_t * thread;    // 执行工作的线程
+}workqueue_t;
+
+void work_init (work_t * work, work_func_t func);
+int workqueue_create (workqueue_t * wq, const char * name);
+int queue_work (workqueue_t * wq, work_t * work);
+void flush_workqueue (workqueue_t * wq);
+
+void workqueue_init (void);
+int schedule_work (work_t * work);
+void flush_scheduled_work (void);
+
+#endif // WORKQUEUE_H
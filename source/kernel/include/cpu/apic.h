@@ -0,0 +1,71 @@
+/**
+ * Local APIC与IOAPIC
+ * https://wiki.osdev.org/APIC
+ * https://wiki.osdev.org/IOAPIC
+ */
+#ifndef APIC_H
+#define APIC_H
+
+#include "comm/types.h"
+
+#define IA32_APIC_BASE_MSR          0x1B
+#define IA32_APIC_BASE_ENABLE       (1 << 11)   // 全局使能LAPIC
+
+#define CPUID_FEAT_EDX_APIC         (1 << 9)
+
+// LAPIC寄存器偏移
+#define LAPIC_ID                    0x020
+#define LAPIC_VERSION               0x030
+#define LAPIC_TPR                   0x080
+#define LAPIC_EOI                   0x0B0
+#define LAPIC_SVR                   0x0F0
+#define LAPIC_ESR                   0x280
+#define LAPIC_ICR_LO                0x300
+#define LAPIC_ICR_HI                0x310
+#define LAPIC_LVT_TIMER             0x320
+#define LAPIC_LVT_LINT0             0x350
+#define LAPIC_LVT_LINT1             0x360
+#define LAPIC_LVT_ERROR             0x370
+#define LAPIC_TIMER_INIT            0x380
+#define LAPIC_TIMER_CURR            0x390
+#define LAPIC_TIMER_DIV             0x3E0
+
+#define LAPIC_SVR_ENABLE            (1 << 8)
+#define LAPIC_LVT_MASKED            (1 << 16)
+#define LAPIC_TIMER_PERIODIC        (1 << 17)
+#define LAPIC_TIMER_DIV_16          0x3
+
+// ICR命令
+#define LAPIC_ICR_INIT              (5 << 8)
+#define LAPIC_ICR_STARTUP           (6 << 8)
+#define LAPIC_ICR_PENDING           (1 << 12)   // 发送中
+#define LAPIC_ICR_LEVEL_ASSERT      (1 << 14)
+
+#define LAPIC_TIMER_CALIBRATE_MS    10          // 定时器校准时长
+
+// IOAPIC寄存器
+#define IOAPIC_REGSEL               0x00
+#define IOAPIC_WIN                  0x10
+#define IOAPIC_REG_ID               0x00
+#define IOAPIC_REG_VER              0x01
+#define IOAPIC_REG_REDTBL           0x10        // 每个中断占两个寄存器
+
+#define IOAPIC_RED_ACTIVE_LOW       (1 << 13)
+#define IOAPIC_RED_LEVEL            (1 << 15)
+#define IOAPIC_RED_MASKED           (1 << 16)
+
+#define IRQ_SPURIOUS                0x7F        // 伪中断，不需要发EOI
+
+void apic_init (void);
+int apic_enabled (void);
+uint32_t lapic_id (void);
+void lapic_eoi (void);
+int lapic_timer_start (int irq_num, uint32_t ms);
+void lapic_send_ipi (uint32_t apic_id, uint32_t cmd);
+void lapic_ap_init (void);
+void ioapic_enable (int irq_num);
+void ioapic_disable (int irq_num);
+
+void exception_handler_spurious (void);
+
+#endif // APIC_H
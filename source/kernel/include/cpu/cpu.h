@@ -36,6 +36,19 @@
 #define EFLAGS_IF           (1 << 9)
 #define EFLAGS_DEFAULT      (1 << 1)
 
+#define CR0_MP              (1 << 1)        // 配合TS位，WAIT/FWAIT也产生#NM
+#define CR0_EM              (1 << 2)        // 置1时表示无FPU，需软件模拟
+#define CR0_TS              (1 << 3)        // 任务切换标志，硬件任务切换时自动置1
+#define CR0_NE              (1 << 5)        // 使用内部的#MF异常报告FPU错误
+
+#define CR4_OSFXSR          (1 << 9)        // 支持FXSAVE/FXRSTOR及SSE指令
+#define CR4_OSXMMEXCPT      (1 << 10)       // 支持SIMD浮点异常#XM
+
+#define CPUID_FEAT_EDX_FPU      (1 << 0)
+#define CPUID_FEAT_EDX_TSC      (1 << 4)
+#define CPUID_FEAT_EDX_FXSR     (1 << 24)
+#define CPUID_FEAT_EDX_SSE      (1 << 25)
+
 #pragma pack(1)
 
 /**
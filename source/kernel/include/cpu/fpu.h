@@ -0,0 +1,27 @@
+/**
+ * FPU/SSE状态管理
+ */
+#ifndef FPU_H
+#define FPU_H
+
+#include "comm/types.h"
+
+#define FPU_STATE_SIZE          512         // FXSAVE保存区的大小
+
+/**
+ * @brief FPU/SSE寄存器保存区，FXSAVE要求16字节对齐
+ */
+typedef struct _fpu_state_t {
+    uint8_t data[FPU_STATE_SIZE];
+}__attribute__((aligned(16))) fpu_state_t;
+
+struct _task_t;
+
+void fpu_init (void);
+void fpu_ap_init (void);
+void fpu_task_switch_out (struct _task_t * task);
+void fpu_task_fork (struct _task_t * parent, struct _task_t * child);
+void fpu_task_reset (struct _task_t * task);
+void fpu_task_exit (struct _task_t * task);
+
+#endif // FPU_H
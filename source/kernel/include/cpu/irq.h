@@ -99,6 +99,7 @@ void exception_handler_virtual_exception (void);
 
 #define IRQ_PIC_START		0x20			// PIC中断起始号
 
+void irq_ap_init (void);
 void irq_enable(int irq_num);
 void irq_disable(int irq_num);
 void irq_disable_global(void);
@@ -108,6 +109,7 @@ irq_state_t irq_enter_protection (void);
 void irq_leave_protection (irq_state_t state);
 
 void pic_send_eoi(int irq);
+void irq_send_eoi (int irq);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,34 @@
+/**
+ * 关中断时长的统计，内核与应用程序共用
+ * 统计每一段由irq_enter_protection开始、恢复开中断的irq_leave_protection结束的区间，
+ * 按调用位置汇总。读/dev/irqlat得到irqlat_site_t数组；写入4字节的阈值(us)则清零统计，
+ * 之后超过阈值的区间会在日志中告警，阈值为0时不告警。
+ */
+#ifndef IRQLAT_H
+#define IRQLAT_H
+
+#include "comm/types.h"
+
+#define IRQLAT_DEPTH            3           // 记录的调用层数，第一层为irq_enter_protection的调用者
+#define IRQLAT_WARN_US          1000        // 缺省的告警阈值
+
+/**
+ * @brief 一个调用位置的关中断统计，时间为TSC周期数
+ */
+typedef struct _irqlat_site_t {
+    uint32_t chain[IRQLAT_DEPTH];       // 返回地址，由内向外
+    uint32_t count;                     // 次数
+    uint64_t total;                     // 总关中断时间
+    uint64_t max;                       // 最长的一次
+}irqlat_site_t;
+
+extern volatile int irqlat_enabled;
+
+void irqlat_enter (uint32_t state);
+void irqlat_leave (uint32_t state);
+void irqlat_switch_done (void);
+int irqlat_read (char * buf, int size);
+void irqlat_set_threshold (uint32_t us);
+void irqlat_init (void);
+
+#endif // IRQLAT_H
@@ -13,6 +13,8 @@
 #define PTE_W              (1 << 1)
 #define PDE_P              (1 << 0)
 #define PTE_U              (1 << 2)
+#define PTE_PWT            (1 << 3)
+#define PTE_PCD            (1 << 4)
 #define PDE_U              (1 << 2)
 
 #pragma pack(1)
@@ -0,0 +1,199 @@
+/**
+ * 多处理器及中断控制器配置信息的获取
+ * 优先从ACPI的MADT表中获取，没有时再查找MP配置表
+ * https://wiki.osdev.org/MADT
+ * https://wiki.osdev.org/Symmetric_Multiprocessing
+ */
+#ifndef MP_H
+#define MP_H
+
+#include "comm/types.h"
+
+#define MP_CPU_MAX              8           // 最多支持的CPU数量
+#define MP_ISA_IRQ_NR           16          // ISA中断数量
+
+// 中断触发方式，ACPI和MP表中的编码相同
+#define MP_IRQ_POLARITY_MASK    (3 << 0)
+#define MP_IRQ_POLARITY_LOW     (3 << 0)    // 低电平有效
+#define MP_IRQ_TRIGGER_MASK     (3 << 2)
+#define MP_IRQ_TRIGGER_LEVEL    (3 << 2)    // 电平触发
+
+#pragma pack(1)
+
+/**
+ * @brief ACPI RSDP结构
+ */
+typedef struct _acpi_rsdp_t {
+    char signature[8];              // "RSD PTR "
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_addr;
+}acpi_rsdp_t;
+
+/**
+ * @brief ACPI各个表的公共头
+ */
+typedef struct _acpi_header_t {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+}acpi_header_t;
+
+/**
+ * @brief MADT表，后面紧跟着各个表项
+ */
+typedef struct _acpi_madt_t {
+    acpi_header_t header;           // signature为"APIC"
+    uint32_t lapic_addr;
+    uint32_t flags;
+}acpi_madt_t;
+
+#define MADT_TYPE_LAPIC         0
+#define MADT_TYPE_IOAPIC        1
+#define MADT_TYPE_OVERRIDE      2
+#define MADT_TYPE_LAPIC_ADDR    5
+
+#define MADT_LAPIC_ENABLED      (1 << 0)
+
+typedef struct _madt_entry_t {
+    uint8_t type;
+    uint8_t length;
+}madt_entry_t;
+
+typedef struct _madt_lapic_t {
+    madt_entry_t entry;
+    uint8_t acpi_id;
+    uint8_t apic_id;
+    uint32_t flags;
+}madt_lapic_t;
+
+typedef struct _madt_ioapic_t {
+    madt_entry_t entry;
+    uint8_t ioapic_id;
+    uint8_t reserved;
+    uint32_t addr;
+    uint32_t gsi_base;
+}madt_ioapic_t;
+
+typedef struct _madt_override_t {
+    madt_entry_t entry;
+    uint8_t bus;
+    uint8_t source;                 // ISA中断号
+    uint32_t gsi;                   // 对应的全局中断号
+    uint16_t flags;
+}madt_override_t;
+
+typedef struct _madt_lapic_addr_t {
+    madt_entry_t entry;
+    uint16_t reserved;
+    uint32_t addr_lo;
+    uint32_t addr_hi;
+}madt_lapic_addr_t;
+
+/**
+ * @brief MP浮点结构
+ */
+typedef struct _mp_float_t {
+    char signature[4];              // "_MP_"
+    uint32_t config_addr;           // 配置表的物理地址
+    uint8_t length;                 // 以16字节为单位
+    uint8_t revision;
+    uint8_t checksum;
+    uint8_t features[5];
+}mp_float_t;
+
+/**
+ * @brief MP配置表头，后面紧跟着各个表项
+ */
+typedef struct _mp_config_t {
+    char signature[4];              // "PCMP"
+    uint16_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[8];
+    char product_id[12];
+    uint32_t oem_table;
+    uint16_t oem_table_size;
+    uint16_t entry_count;
+    uint32_t lapic_addr;
+    uint16_t ext_length;
+    uint8_t ext_checksum;
+    uint8_t reserved;
+}mp_config_t;
+
+#define MP_ENTRY_CPU            0
+#define MP_ENTRY_BUS            1
+#define MP_ENTRY_IOAPIC         2
+#define MP_ENTRY_IOINT          3
+#define MP_ENTRY_LINT           4
+
+#define MP_CPU_ENABLED          (1 << 0)
+#define MP_IOAPIC_ENABLED       (1 << 0)
+
+typedef struct _mp_cpu_t {
+    uint8_t type;
+    uint8_t apic_id;
+    uint8_t apic_version;
+    uint8_t flags;
+    uint32_t signature;
+    uint32_t features;
+    uint32_t reserved[2];
+}mp_cpu_t;
+
+typedef struct _mp_bus_t {
+    uint8_t type;
+    uint8_t bus_id;
+    char bus_type[6];
+}mp_bus_t;
+
+typedef struct _mp_ioapic_t {
+    uint8_t type;
+    uint8_t ioapic_id;
+    uint8_t version;
+    uint8_t flags;
+    uint32_t addr;
+}mp_ioapic_t;
+
+typedef struct _mp_ioint_t {
+    uint8_t type;
+    uint8_t int_type;
+    uint16_t flags;
+    uint8_t src_bus;
+    uint8_t src_irq;
+    uint8_t dst_ioapic;
+    uint8_t dst_pin;
+}mp_ioint_t;
+
+#pragma pack()
+
+/**
+ * @brief 从固件表中得到的系统配置
+ */
+typedef struct _mp_info_t {
+    int found;                          // 是否找到了配置表
+    uint32_t lapic_addr;                // LAPIC寄存器的物理地址
+    uint32_t ioapic_addr;               // IOAPIC寄存器的物理地址，0表示没有
+    uint32_t ioapic_gsi_base;           // IOAPIC的起始全局中断号
+    int ioapic_id;
+
+    int cpu_count;
+    uint8_t cpu_apic_id[MP_CPU_MAX];    // 各CPU的LAPIC ID
+
+    // ISA中断到全局中断号的映射
+    struct {
+        uint32_t gsi;
+        uint16_t flags;
+    }isa_irq[MP_ISA_IRQ_NR];
+}mp_info_t;
+
+void mp_init (void);
+mp_info_t * mp_info (void);
+
+#endif // MP_H
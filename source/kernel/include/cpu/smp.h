@@ -0,0 +1,62 @@
+/**
+ * 多处理器支持
+ * https://wiki.osdev.org/Symmetric_Multiprocessing
+ */
+#ifndef SMP_H
+#define SMP_H
+
+#include "comm/types.h"
+#include "cpu/mp.h"
+#include "tools/list.h"
+#include "cpu/irqlat.h"
+
+#define SMP_CPU_MAX             MP_CPU_MAX
+#define AP_START_TIMEOUT_MS     200             // 等待AP启动的时间
+
+#define IRQ_RESCHED             0x7E            // 要求其它CPU重新调度的IPI
+
+struct _task_t;
+struct _syscall_stat_t;
+
+/**
+ * @brief 每个CPU的私有数据
+ */
+typedef struct _cpu_t {
+    int id;                             // 逻辑编号，0为BSP
+    uint32_t apic_id;                   // LAPIC ID
+    volatile int started;               // 是否已经运行
+
+    struct _task_t * curr_task;         // 当前运行的任务
+    struct _task_t * idle_task;         // 空闲任务
+    struct _task_t * fpu_owner;         // FPU寄存器中保存的是哪个任务的状态
+
+    list_t ready_list;                  // 就绪队列，包含正在运行的任务
+    list_t rt_list;                     // 实时任务的就绪队列，按运行的先后排序，总是优先于ready_list
+    uint32_t dl_bw;                     // 已分配给DEADLINE任务的带宽
+
+    struct _syscall_stat_t * sysstat;   // 在该CPU上执行的系统调用的统计，读取时汇总
+
+    // 定时器中断按被中断时的特权级记下，在软中断中计入当前任务
+    uint32_t pending_utime;
+    uint32_t pending_stime;
+
+    volatile uint32_t softirq_pending;  // 待处理的软中断
+    int softirq_active;                 // 是否正在处理软中断
+    int need_resched;                   // 软中断期间推迟的调度请求
+    list_t tasklet_list;                // 待运行的tasklet
+
+    // 最外层关中断区间的开始时间及调用位置，见irqlat.c
+    uint64_t irqoff_start;
+    uint32_t irqoff_chain[IRQLAT_DEPTH];
+}cpu_t;
+
+void smp_init (void);
+void smp_start_aps (void);
+int smp_cpu_count (void);
+cpu_t * smp_cpu (int id);
+cpu_t * cpu_current (void);
+void smp_send_resched (cpu_t * cpu);
+
+void exception_handler_resched (void);
+
+#endif // SMP_H
@@ -0,0 +1,39 @@
+/**
+ * 软中断与tasklet
+ * 中断处理分为两部分：上半部在关中断下只做必要的硬件操作，并记录需要后续处理的事件；
+ * 下半部在中断返回前、开中断的情况下运行，完成耗时较长的处理
+ */
+#ifndef SOFTIRQ_H
+#define SOFTIRQ_H
+
+#include "comm/types.h"
+#include "tools/list.h"
+
+#define SOFTIRQ_TIMER           0           // 定时器的调度处理
+#define SOFTIRQ_TASKLET         1           // tasklet
+#define SOFTIRQ_NR              2
+
+#define SOFTIRQ_MAX_RESTART     10          // 一次中断返回中最多重复处理的轮数
+
+typedef void (*softirq_handler_t)(void);
+
+/**
+ * @brief 可动态注册的下半部处理，在调度它的CPU上运行，同一时刻只在一个CPU上运行
+ */
+typedef struct _tasklet_t {
+    list_node_t node;
+    void (*func)(void * data);
+    void * data;
+    volatile uint32_t scheduled;    // 是否已在队列中
+    volatile uint32_t running;      // 是否正在运行
+}tasklet_t;
+
+void softirq_init (void);
+void softirq_install (int nr, softirq_handler_t handler);
+void raise_softirq (int nr);
+void irq_exit (void);
+
+void tasklet_init (tasklet_t * tasklet, void (*func)(void * data), void * data);
+void tasklet_schedule (tasklet_t * tasklet);
+
+#endif // SOFTIRQ_H
@@ -11,6 +11,14 @@
 enum {
     DEV_UNKNOWN = 0,            // 未知类型
     DEV_TTY,                // TTY设备
+    DEV_SYSSTAT,            // 系统调用统计
+    DEV_PROF,               // 采样性能分析
+    DEV_TRACE,              // 内核事件跟踪
+    DEV_LOCKSTAT,           // 锁竞争统计
+    DEV_IRQLAT,             // 关中断时长统计
+    DEV_BOOTTIME,           // 启动各阶段的时间
+    DEV_SCHEDSTAT,          // 调度延迟及负载统计
+    DEV_SERIAL,             // 串口
 };
 
 struct _dev_desc_t;
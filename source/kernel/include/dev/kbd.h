@@ -17,6 +17,8 @@
 // https://wiki.osdev.org/PS/2_Keyboard
 #define KBD_CMD_RW_LED			0xED   // 写按键
 
+#define KBD_RAW_BUF_SIZE		64		// 中断中缓存的原始键码数量
+
 #define KEY_RSHIFT		0x36
 #define KEY_LSHIFT 		0x2A
 
@@ -5,18 +5,146 @@
 #define TIMER_H
 
 #include "comm/types.h"
+#include "comm/cpu_instr.h"
+#include "os_cfg.h"
 
 #define PIT_OSC_FREQ                1193182				// 定时器时钟
 
 // 定时器的寄存器和各项位配置
 #define PIT_CHANNEL0_DATA_PORT       0x40
+#define PIT_CHANNEL2_DATA_PORT       0x42
 #define PIT_COMMAND_MODE_PORT        0x43
+#define PIT_CH2_GATE_PORT            0x61           // 通道2的门控及输出状态
 
 #define PIT_CHANNLE0                (0 << 6)
+#define PIT_CHANNLE2                (2 << 6)
 #define PIT_LOAD_LOHI               (3 << 4)
+#define PIT_MODE0                   (0 << 1)
 #define PIT_MODE3                   (3 << 1)
 
+#define PIT_CH2_GATE                (1 << 0)        // 通道2计数使能
+#define PIT_CH2_SPEAKER             (1 << 1)        // 扬声器输出
+#define PIT_CH2_OUT                 (1 << 5)        // 通道2输出状态
+
+// CMOS中的RTC时钟
+#define CMOS_ADDR_PORT              0x70
+#define CMOS_DATA_PORT              0x71
+#define CMOS_RTC_SEC                0x00
+#define CMOS_RTC_MIN                0x02
+#define CMOS_RTC_HOUR               0x04
+#define CMOS_RTC_DAY                0x07
+#define CMOS_RTC_MON                0x08
+#define CMOS_RTC_YEAR               0x09
+#define CMOS_RTC_STATUS_A           0x0A
+#define CMOS_RTC_STATUS_B           0x0B
+#define CMOS_STATUS_A_UIP           (1 << 7)        // 正在更新时间
+#define CMOS_STATUS_B_24H           (1 << 1)        // 24小时制
+#define CMOS_STATUS_B_BIN           (1 << 2)        // 二进制格式，否则为BCD
+
+#define TIME_CALIBRATE_MS           50              // TSC校准时长，不能超过PIT 16位计数范围(约55ms)
+#define TIME_TSC_SHIFT              24              // tsc转换为ns时的定点位数
+#define TIME_NSEC_PER_SEC           1000000000
+#define TIME_NSEC_PER_TICK          (OS_TICK_MS * 1000000)
+
+// 时间页在内核页表中的地址，以只读方式映射给所有进程
+#define TIME_PAGE_ADDR              0x7FFFF000
+
+// 时钟类型，取值和newlib中的定义一致
+#define TIME_CLOCK_REALTIME         1
+#define TIME_CLOCK_MONOTONIC        4
+#define TIME_CLOCK_MONOTONIC_RAW    5
+
+/**
+ * @brief 时间值，内存布局和newlib的struct timespec一致
+ */
+typedef struct _time_spec_t {
+    uint64_t sec;
+    uint32_t nsec;
+}time_spec_t;
+
+/**
+ * @brief 时间值，内存布局和newlib的struct timeval一致
+ */
+typedef struct _time_val_t {
+    uint64_t sec;
+    uint32_t usec;
+}time_val_t;
+
+/**
+ * @brief 共享时间页，内核每个tick更新一次，应用直接读取，无需系统调用
+ * 读取时采用顺序锁：seq为奇数表示正在更新，读取前后seq不一致则重读
+ */
+typedef struct _time_page_t {
+    volatile uint32_t seq;          // 顺序锁计数
+    uint32_t tsc_mult;              // ns = (tsc * mult) >> shift，为0表示无可用的TSC
+    uint32_t tsc_shift;
+    uint32_t tsc_khz;               // TSC频率
+    uint32_t tick;                  // 系统启动后的tick数量
+    uint64_t boot_tsc;              // 启动时的TSC
+    uint64_t base_ns;               // 最近一次更新时的启动时长，单位ns
+    uint64_t base_sec;              // 与base_ns相同，拆分为秒和纳秒
+    uint32_t base_nsec;
+    uint64_t real_sec;              // 启动时刻对应的UTC时间
+}time_page_t;
+
+/**
+ * @brief 将TSC计数转换为ns，不使用64位除法
+ */
+static inline uint64_t time_tsc_to_ns (uint64_t cycles, uint32_t mult, uint32_t shift) {
+    uint32_t lo = (uint32_t)cycles, hi = (uint32_t)(cycles >> 32);
+
+    uint64_t ns = ((uint64_t)lo * mult) >> shift;
+    if (hi) {
+        ns += ((uint64_t)hi * mult) << (32 - shift);
+    }
+    return ns;
+}
+
+/**
+ * @brief 读取时间页，得到启动以来的单调时间，内核和应用共用
+ */
+static inline void time_page_read (const volatile time_page_t * page, time_spec_t * ts) {
+    uint32_t seq;
+    uint64_t sec, nsec;
+
+    do {
+        seq = page->seq;
+        __asm__ __volatile__("" ::: "memory");
+
+        sec = page->base_sec;
+        nsec = page->base_nsec;
+        if (page->tsc_mult) {
+            uint64_t ns = time_tsc_to_ns(rdtsc() - page->boot_tsc, page->tsc_mult, page->tsc_shift);
+            // 其它CPU的TSC可能略小于更新时间页的CPU，此时不加，不早于最近一次更新的时间
+            if (ns > page->base_ns) {
+                // 通常不足一个tick，时钟中断长时间未处理时也限制在1秒以内
+                uint64_t delta = ns - page->base_ns;
+                nsec += (delta < TIME_NSEC_PER_SEC) ? delta : TIME_NSEC_PER_SEC - 1;
+            }
+        }
+
+        __asm__ __volatile__("" ::: "memory");
+    } while ((seq & 1) || (seq != page->seq));
+
+    // base_nsec和增量都小于1秒，最多进位一次
+    if (nsec >= TIME_NSEC_PER_SEC) {
+        nsec -= TIME_NSEC_PER_SEC;
+        sec++;
+    }
+    ts->sec = sec;
+    ts->nsec = (uint32_t)nsec;
+}
+
 void time_init (void);
+void time_pit_delay (uint32_t ms);
+void time_udelay (uint32_t us);
 void exception_handler_timer (void);
+uint32_t time_get_ticks (void);
+uint32_t time_get_tsc_khz (void);
+uint64_t time_get_ns (void);
+void time_get (int clock, time_spec_t * ts);
+
+int sys_clock_gettime (int clock, time_spec_t * ts);
+int sys_gettimeofday (time_val_t * tv, void * tz);
 
 #endif //OS_TIMER_H
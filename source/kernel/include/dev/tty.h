@@ -5,6 +5,7 @@
 #define TTY_H
 
 #include "ipc/sem.h"
+#include "ipc/spinlock.h"
 
 #define TTY_NR						8		// 最大支持的tty设备数量
 #define TTY_IBUF_SIZE				512		// tty输入缓存大小
@@ -15,8 +16,10 @@ typedef struct _tty_fifo_t {
 	int size;				// 最大字节数
 	int read, write;		// 当前读写位置
 	int count;				// 当前已有的数据量
+	spinlock_t lock;		// 中断和其它CPU可能同时访问
 }tty_fifo_t;
 
+void tty_fifo_init (tty_fifo_t * fifo, char * buf, int size);
 int tty_fifo_get (tty_fifo_t * fifo, char * c);
 int tty_fifo_put (tty_fifo_t * fifo, char c);
 
@@ -15,6 +15,7 @@
 typedef enum _file_type_t {
     FILE_UNKNOWN = 0,
     FILE_TTY = 1,
+    FILE_DEV = 2,               // 其它设备
 } file_type_t;
 
 struct _fs_t;
@@ -40,5 +41,6 @@ file_t * file_alloc (void) ;
 void file_free (file_t * file);
 void file_table_init (void);
 void file_inc_ref (file_t * file);
+int file_dec_ref (file_t * file);
 
 #endif // PFILE_H
@@ -53,6 +53,7 @@ int sys_read(int file, char *ptr, int len);
 int sys_write(int file, char *ptr, int len);
 int sys_lseek(int file, int ptr, int dir);
 int sys_close(int file);
+void fs_file_close (file_t * file);
 
 int sys_isatty(int file);
 int sys_fstat(int file, struct stat *st);
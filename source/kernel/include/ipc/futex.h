@@ -0,0 +1,18 @@
+/**
+ * 用户态同步用的futex
+ * 加解锁在用户空间用原子操作完成，只有发生竞争时才进入内核等待或唤醒
+ */
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "comm/types.h"
+
+#define FUTEX_WAIT              0       // 值仍等于val时睡眠等待
+#define FUTEX_WAKE              1       // 唤醒最多val个等待者
+
+#define FUTEX_HASH_SIZE         64      // 等待队列的哈希表大小
+
+void futex_init (void);
+int sys_futex (uint32_t * uaddr, int op, int val);
+
+#endif // FUTEX_H
@@ -0,0 +1,40 @@
+/**
+ * 互斥锁和信号量的竞争统计，内核与应用程序共用
+ * 只统计用mutex_set_name/sem_set_name命名过的锁，同名的锁共用一项统计，
+ * 如各个tty的信号量。读/dev/lockstat得到lock_stat_t数组，写入任意内容则清零。
+ */
+#ifndef LOCK_STAT_H
+#define LOCK_STAT_H
+
+#include "comm/types.h"
+
+#define LOCK_STAT_NR            32          // 最多统计的锁的数量
+#define LOCK_NAME_SIZE          16          // 锁名称长度
+
+#define LOCK_TYPE_MUTEX         1           // 互斥锁
+#define LOCK_TYPE_SEM           2           // 信号量，没有持有时间
+
+/**
+ * @brief 一个(或一类同名)锁的统计，时间为TSC周期数
+ */
+typedef struct _lock_stat_t {
+    char name[LOCK_NAME_SIZE];
+    int type;                           // LOCK_TYPE_xxx
+    uint32_t acquire;                   // 获取次数
+    uint32_t contend;                   // 需要等待的次数
+    uint32_t reserved;
+    uint64_t wait_total;                // 总等待时间
+    uint64_t wait_max;                  // 最长的一次等待
+    uint64_t hold_total;                // 总持有时间，只统计互斥锁
+    uint64_t hold_max;                  // 最长的一次持有
+}lock_stat_t;
+
+lock_stat_t * lock_stat_alloc (const char * name, int type);
+uint64_t lock_stat_now (void);
+void lock_stat_wait (lock_stat_t * stat, uint64_t start);
+void lock_stat_hold (lock_stat_t * stat, uint64_t start);
+int lock_stat_read (int index, lock_stat_t * stat);
+void lock_stat_reset (void);
+void lock_stat_init (void);
+
+#endif // LOCK_STAT_H
@@ -6,6 +6,7 @@
 
 #include "core/task.h"
 #include "tools/list.h"
+#include "ipc/lock_stat.h"
 
 /**
  * 进程同步用的计数信号量
@@ -14,10 +15,13 @@ typedef struct _mutex_t {
     task_t * owner;
     int locked_count;
     list_t wait_list;
+    lock_stat_t * stat;         // 竞争统计，未命名时为0
+    uint64_t hold_start;        // 本次获得锁的时间
 }mutex_t;
 
 void mutex_init (mutex_t * mutex);
 void mutex_lock (mutex_t * mutex);
 void mutex_unlock (mutex_t * mutex);
+void mutex_set_name (mutex_t * mutex, const char * name);
  
 #endif //MUTEX_H
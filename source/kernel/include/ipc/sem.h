@@ -5,6 +5,7 @@
 #define OS_SEM_H
 
 #include "tools/list.h"
+#include "ipc/lock_stat.h"
 
 /**
  * 进程同步用的计数信号量
@@ -12,11 +13,13 @@
 typedef struct _sem_t {
     int count;				// 信号量计数
     list_t wait_list;		// 等待的进程列表
+    lock_stat_t * stat;		// 竞争统计，未命名时为0
 }sem_t;
 
 void sem_init (sem_t * sem, int init_count);
 void sem_wait (sem_t * sem);
 void sem_notify (sem_t * sem);
 int sem_count (sem_t * sem);
+void sem_set_name (sem_t * sem, const char * name);
 
 #endif //OS_SEM_H
@@ -0,0 +1,23 @@
+/**
+ * 自旋锁
+ */
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include "comm/types.h"
+#include "cpu/irq.h"
+
+/**
+ * 多处理器间互斥用的自旋锁，持有期间不能睡眠
+ */
+typedef struct _spinlock_t {
+    volatile uint32_t locked;
+}spinlock_t;
+
+void spinlock_init (spinlock_t * lock);
+void spin_lock (spinlock_t * lock);
+void spin_unlock (spinlock_t * lock);
+irq_state_t spin_lock_irqsave (spinlock_t * lock);
+void spin_unlock_irqrestore (spinlock_t * lock, irq_state_t state);
+
+#endif //SPINLOCK_H
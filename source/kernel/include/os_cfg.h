@@ -4,11 +4,13 @@
 #ifndef OS_OS_CFG_H
 #define OS_OS_CFG_H
 
-#define GDT_TABLE_SIZE      	256		// GDT表项数量
+#define GDT_TABLE_SIZE      	8192	// GDT表项数量，硬件允许的最大值，每个任务占用一项
 #define KERNEL_SELECTOR_CS		(1 * 8)		// 内核代码段描述符
 #define KERNEL_SELECTOR_DS		(2 * 8)		// 内核数据段描述符
 #define KERNEL_STACK_SIZE       (8*1024)    // 内核栈
-#define SELECTOR_SYSCALL     	(3 * 8)	// 调用门的选择子
+#define APP_SELECTOR_CS         (3 * 8)     // 应用代码段，sysexit要求紧跟在内核段之后
+#define APP_SELECTOR_DS         (4 * 8)     // 应用数据段
+#define SELECTOR_SYSCALL     	(5 * 8)	// 调用门的选择子
 
 #define OS_TICK_MS              10       	// 每毫秒的时钟数
 
@@ -16,6 +18,8 @@
 
 #define IDLE_STACK_SIZE       1024        // 空闲任务栈
 
-#define TASK_NR             128            // 进程的数量
+#define TASK_NR             4096           // 最多同时存在的任务数，任务结构按需分配
+
+#define AP_START_ADDR       0x7000         // AP启动代码的位置，需4KB对齐且位于1MB以内
 
 #endif //OS_OS_CFG_H
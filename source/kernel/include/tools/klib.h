@@ -15,6 +15,21 @@ static inline uint32_t down2 (uint32_t size, uint32_t bound) {
     return size & ~(bound - 1);
 }
 
+/**
+ * @brief 64位数除以32位数，内核不链接libgcc，不能直接使用64位除法
+ * 分两次用divl完成：先除高32位，余数和低32位再组成被除数
+ */
+static inline uint64_t kernel_div64 (uint64_t n, uint32_t d, uint32_t * rem) {
+    uint32_t hi = (uint32_t)(n >> 32), lo = (uint32_t)n;
+    uint32_t q_hi = hi / d, r = hi % d, q_lo;
+
+    __asm__ __volatile__("divl %[d]" : "=a"(q_lo), "=d"(r) : "a"(lo), "d"(r), [d]"rm"(d));
+    if (rem) {
+        *rem = r;
+    }
+    return ((uint64_t)q_hi << 32) | q_lo;
+}
+
 int strings_count (char ** start);
 char * get_file_name (char * name);
 
@@ -28,6 +43,7 @@ int kernel_memcmp (void * d1, void * d2, int size);
 void kernel_itoa(char * buf, int num, int base);
 void kernel_sprintf(char * buffer, const char * fmt, ...);
 void kernel_vsprintf(char * buffer, const char * fmt, va_list args);
+int log2_bucket (uint64_t value, int shift, int nr);
 
 #ifndef RELEASE
 #define ASSERT(condition)    \
@@ -5,13 +5,25 @@
 #include "comm/cpu_instr.h"
 #include "cpu/cpu.h"
 #include "cpu/irq.h"
+#include "cpu/fpu.h"
+#include "cpu/apic.h"
+#include "cpu/smp.h"
+#include "cpu/softirq.h"
+#include "cpu/irqlat.h"
 #include "dev/time.h"
 #include "core/task.h"
+#include "core/syscall.h"
+#include "core/prof.h"
+#include "core/trace.h"
+#include "core/workqueue.h"
+#include "core/boottime.h"
 #include "os_cfg.h"
 #include "tools/log.h"
 #include "tools/klib.h"
 #include "tools/list.h"
 #include "ipc/sem.h"
+#include "ipc/futex.h"
+#include "ipc/lock_stat.h"
 #include "core/memory.h"
 #include "dev/console.h"
 #include "dev/kbd.h"
@@ -25,19 +37,35 @@ static boot_info_t * init_boot_info;        // 启动信息
  */
 void kernel_init (boot_info_t * boot_info) {
     init_boot_info = boot_info;
+    boottime_init(boot_info);
 
     // 初始化CPU，再重新加载
     cpu_init();
+    lock_stat_init();
     irq_init();
+    softirq_init();
     log_init();
+    fpu_init();
+    boottime_stamp(BOOT_STAGE_CPU);
 
     // 内存初始化要放前面一点，因为后面的代码可能需要内存分配
     memory_init(boot_info);
+    boottime_stamp(BOOT_STAGE_MEMORY);
+    apic_init();
+    smp_init();
+    boottime_stamp(BOOT_STAGE_SMP);
+    syscall_init();
+    prof_init();
+    trace_init();
     fs_init();
+    boottime_stamp(BOOT_STAGE_FS);
 
     time_init();
+    boottime_stamp(BOOT_STAGE_TIME);
 
     task_manager_init();
+    futex_init();
+    boottime_stamp(BOOT_STAGE_TASK);
 }
 
 
@@ -52,7 +80,8 @@ void move_to_first_task(void) {
     task_t * curr = task_current();
     ASSERT(curr != 0);
 
-    tss_t * tss = &(curr->tss);
+    // 入口信息保存在内核栈顶的启动帧中
+    task_start_frame_t * frame = (task_start_frame_t *)(curr->tss.esp0 - sizeof(task_start_frame_t));
 
     // 也可以使用类似boot跳loader中的函数指针跳转
     // 这里用jmp是因为后续需要使用内联汇编添加其它代码
@@ -64,8 +93,8 @@ void move_to_first_task(void) {
         "push %[eflags]\n\t"           // EFLAGS
         "push %[cs]\n\t"			// CS
         "push %[eip]\n\t"		    // ip
-        "iret\n\t"::[ss]"r"(tss->ss),  [esp]"r"(tss->esp), [eflags]"r"(tss->eflags),
-        [cs]"r"(tss->cs), [eip]"r"(tss->eip));
+        "iret\n\t"::[ss]"r"(frame->ss),  [esp]"r"(frame->esp), [eflags]"r"(frame->eflags),
+        [cs]"r"(frame->cs), [eip]"r"(frame->eip));
 }
 
 void init_main(void) {
@@ -73,7 +102,18 @@ void init_main(void) {
     log_printf("Version: %s, name: %s", OS_VERSION, "tiny x86 os");
     log_printf("%d %d %x %c", -123, 123456, 0x12345, 'a');
 
-    // 初始化任务
+    // 启动其它CPU，它们先运行各自的空闲任务
+    smp_start_aps();
+    boottime_stamp(BOOT_STAGE_START_AP);
+
+    // 初始化任务，第一个任务的pid为1
     task_first_init();
+    boottime_stamp(BOOT_STAGE_FIRST_TASK);
+
+    // 内核线程及工作队列
+    workqueue_init();
+    irqlat_init();
+    boottime_stamp(BOOT_STAGE_WORKQUEUE);
+
     move_to_first_task();
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+/**
+ * 用户态同步用的futex
+ * 以变量所在的物理地址区分，共享同一内存的任务使用同一个等待队列。
+ * 等待的任务通过wait_node挂在哈希表中，与其它等待队列一样由调度锁保护。
+ */
+#include "ipc/futex.h"
+#include "core/task.h"
+#include "core/memory.h"
+#include "tools/list.h"
+
+static list_t futex_hash[FUTEX_HASH_SIZE];
+
+/**
+ * @brief 初始化等待队列
+ */
+void futex_init (void) {
+    for (int i = 0; i < FUTEX_HASH_SIZE; i++) {
+        list_init(futex_hash + i);
+    }
+}
+
+/**
+ * @brief 取变量的物理地址作为键，地址无效时返回0
+ */
+static uint32_t futex_key (task_t * task, uint32_t * uaddr) {
+    uint32_t vaddr = (uint32_t)uaddr;
+    if ((vaddr < MEMORY_TASK_BASE) || (vaddr & (sizeof(uint32_t) - 1))) {
+        return 0;
+    }
+
+    return memory_get_paddr(task->tss.cr3, vaddr);
+}
+
+static inline list_t * futex_list (uint32_t key) {
+    return futex_hash + ((key >> 2) % FUTEX_HASH_SIZE);
+}
+
+/**
+ * @brief 在*uaddr仍为val时睡眠，返回0；值已改变时立即返回-1
+ * 比较和进入队列都在调度锁内完成，不会错过此后的唤醒
+ */
+static int futex_wait (task_t * curr, uint32_t * uaddr, int val) {
+    uint32_t key = futex_key(curr, uaddr);
+    if (key == 0) {
+        return -1;
+    }
+
+    irq_state_t state = task_lock();
+    if (*(volatile uint32_t *)uaddr != (uint32_t)val) {
+        task_unlock(state);
+        return -1;
+    }
+
+    curr->futex_key = key;
+    task_set_block(curr);
+    list_insert_last(futex_list(key), &curr->wait_node);
+    task_dispatch();
+    task_unlock(state);
+    return 0;
+}
+
+/**
+ * @brief 唤醒最多count个在uaddr上等待的任务，返回唤醒的数量
+ */
+static int futex_wake (task_t * curr, uint32_t * uaddr, int count) {
+    uint32_t key = futex_key(curr, uaddr);
+    if (key == 0) {
+        return -1;
+    }
+
+    int woken = 0;
+    irq_state_t state = task_lock();
+    list_t * list = futex_list(key);
+    list_node_t * node = list_first(list);
+    while (node && (woken < count)) {
+        list_node_t * next = list_node_next(node);
+
+        task_t * task = list_node_parent(node, task_t, wait_node);
+        if (task->futex_key == key) {
+            list_remove(list, node);
+            task->futex_key = 0;
+            task_set_ready(task);
+            woken++;
+        }
+        node = next;
+    }
+
+    // 唤醒了更优先的实时任务时立即切换
+    if (woken) {
+        task_dispatch();
+    }
+    task_unlock(state);
+    return woken;
+}
+
+/**
+ * @brief futex系统调用
+ */
+int sys_futex (uint32_t * uaddr, int op, int val) {
+    task_t * curr = task_current();
+
+    switch (op) {
+    case FUTEX_WAIT:
+        return futex_wait(curr, uaddr, val);
+    case FUTEX_WAKE:
+        return futex_wake(curr, uaddr, val);
+    default:
+        return -1;
+    }
+}
@@ -0,0 +1,140 @@
+/**
+ * 互斥锁和信号量的竞争统计
+ * 统计项在锁初始化时命名分配，之后只在持有调度锁时更新，读取时同样加调度锁。
+ */
+#include "ipc/lock_stat.h"
+#include "ipc/spinlock.h"
+#include "core/task.h"
+#include "cpu/cpu.h"
+#include "comm/cpu_instr.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+static lock_stat_t lock_stats[LOCK_STAT_NR];
+static int lock_stat_count;
+static spinlock_t lock_stat_lock;           // 保护统计项的分配
+static int lock_stat_tsc;                   // 是否可用TSC
+
+/**
+ * @brief 比较名称是否完全相同
+ */
+static int lock_name_equal (const char * s1, const char * s2) {
+    for (int i = 0; i < LOCK_NAME_SIZE - 1; i++) {
+        if (s1[i] != s2[i]) {
+            return 0;
+        } else if (s1[i] == '\0') {
+            break;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief 取名称对应的统计项，已有同名的则共用，表满时返回0，即不统计
+ */
+lock_stat_t * lock_stat_alloc (const char * name, int type) {
+    lock_stat_t * stat = (lock_stat_t *)0;
+
+    irq_state_t state = spin_lock_irqsave(&lock_stat_lock);
+    for (int i = 0; i < lock_stat_count; i++) {
+        if ((lock_stats[i].type == type) && lock_name_equal(lock_stats[i].name, name)) {
+            stat = lock_stats + i;
+            break;
+        }
+    }
+
+    if (!stat && (lock_stat_count < LOCK_STAT_NR)) {
+        stat = lock_stats + lock_stat_count;
+        kernel_memset(stat, 0, sizeof(lock_stat_t));
+        kernel_strncpy(stat->name, name, LOCK_NAME_SIZE);
+        stat->type = type;
+
+        // 名称写好后才计入，读取者不需要加这把锁
+        __asm__ __volatile__("" ::: "memory");
+        lock_stat_count++;
+    }
+    spin_unlock_irqrestore(&lock_stat_lock, state);
+
+    if (!stat) {
+        log_printf("lockstat: table full, %s not counted", name);
+    }
+    return stat;
+}
+
+/**
+ * @brief 当前时间，没有TSC时为0，此时只统计次数
+ */
+uint64_t lock_stat_now (void) {
+    return lock_stat_tsc ? rdtsc() : 0;
+}
+
+/**
+ * @brief 记录一次需要等待的获取，start为开始等待的时间，需持有调度锁
+ */
+void lock_stat_wait (lock_stat_t * stat, uint64_t start) {
+    stat->acquire++;
+    stat->contend++;
+
+    // 开始时还未启用计时
+    if (!start) {
+        return;
+    }
+
+    uint64_t cycles = lock_stat_now() - start;
+    stat->wait_total += cycles;
+    if (cycles > stat->wait_max) {
+        stat->wait_max = cycles;
+    }
+}
+
+/**
+ * @brief 记录一次持有，start为获得锁的时间，需持有调度锁
+ */
+void lock_stat_hold (lock_stat_t * stat, uint64_t start) {
+    if (!start) {
+        return;
+    }
+
+    uint64_t cycles = lock_stat_now() - start;
+    stat->hold_total += cycles;
+    if (cycles > stat->hold_max) {
+        stat->hold_max = cycles;
+    }
+}
+
+/**
+ * @brief 读取第index项统计，超出范围时返回-1
+ */
+int lock_stat_read (int index, lock_stat_t * stat) {
+    if ((index < 0) || (index >= lock_stat_count)) {
+        return -1;
+    }
+
+    irq_state_t state = task_lock();
+    kernel_memcpy(stat, lock_stats + index, sizeof(lock_stat_t));
+    task_unlock(state);
+    return 0;
+}
+
+/**
+ * @brief 清零所有统计，保留名称
+ */
+void lock_stat_reset (void) {
+    irq_state_t state = task_lock();
+    for (int i = 0; i < lock_stat_count; i++) {
+        lock_stat_t * stat = lock_stats + i;
+        stat->acquire = stat->contend = 0;
+        stat->wait_total = stat->wait_max = 0;
+        stat->hold_total = stat->hold_max = 0;
+    }
+    task_unlock(state);
+}
+
+/**
+ * @brief 锁统计初始化，在此之前命名的锁同样统计，只是还不计时
+ */
+void lock_stat_init (void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    lock_stat_tsc = (edx & CPUID_FEAT_EDX_TSC) != 0;
+}
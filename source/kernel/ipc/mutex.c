@@ -3,6 +3,7 @@
  */
 #include "cpu/irq.h"
 #include "ipc/mutex.h"
+#include "core/trace.h"
 
 /**
  * 锁初始化
@@ -10,20 +11,32 @@
 void mutex_init (mutex_t * mutex) {
     mutex->locked_count = 0;
     mutex->owner = (task_t *)0;
+    mutex->stat = (lock_stat_t *)0;
     list_init(&mutex->wait_list);
 }
 
+/**
+ * 命名锁，开始统计竞争情况
+ */
+void mutex_set_name (mutex_t * mutex, const char * name) {
+    mutex->stat = lock_stat_alloc(name, LOCK_TYPE_MUTEX);
+}
+
 /**
  * 申请锁
  */
 void mutex_lock (mutex_t * mutex) {
-    irq_state_t  irq_state = irq_enter_protection();
+    irq_state_t  irq_state = task_lock();
 
     task_t * curr = task_current();
     if (mutex->locked_count == 0) {
         // 没有任务占用，占用之
         mutex->locked_count = 1;
         mutex->owner = curr;
+        if (mutex->stat) {
+            mutex->stat->acquire++;
+            mutex->hold_start = lock_stat_now();
+        }
     } else if (mutex->owner == curr) {
         // 已经为当前任务所有，只增加计数
         mutex->locked_count++;
@@ -32,17 +45,24 @@ void mutex_lock (mutex_t * mutex) {
         task_t * curr = task_current();
         task_set_block(curr);
         list_insert_last(&mutex->wait_list, &curr->wait_node);
+
+        uint64_t start = mutex->stat ? lock_stat_now() : 0;
         task_dispatch();
+
+        // 醒来时释放者已将锁转交过来
+        if (mutex->stat) {
+            lock_stat_wait(mutex->stat, start);
+        }
     }
 
-    irq_leave_protection(irq_state);
+    task_unlock(irq_state);
 }
 
 /**
  * 释放锁
  */
 void mutex_unlock (mutex_t * mutex) {
-    irq_state_t  irq_state = irq_enter_protection();
+    irq_state_t  irq_state = task_lock();
 
     // 只有锁的拥有者才能释放锁
     task_t * curr = task_current();
@@ -50,22 +70,29 @@ void mutex_unlock (mutex_t * mutex) {
         if (--mutex->locked_count == 0) {
             // 减到0，释放锁
             mutex->owner = (task_t *)0;
+            if (mutex->stat) {
+                lock_stat_hold(mutex->stat, mutex->hold_start);
+            }
 
             // 如果队列中有任务等待，则立即唤醒并占用锁
             if (list_count(&mutex->wait_list)) {
                 list_node_t * task_node = list_remove_first(&mutex->wait_list);
                 task_t * task = list_node_parent(task_node, task_t, wait_node);
                 task_set_ready(task);
+                trace_event(TRACE_CLASS_WAKEUP, TRACE_SCHED_WAKEUP, task->pid, mutex);
 
                 // 在这里占用，而不是在任务醒后占用，因为可能抢不到
                 mutex->locked_count = 1;
                 mutex->owner = task;
+                if (mutex->stat) {
+                    mutex->hold_start = lock_stat_now();
+                }
 
                 task_dispatch();
             }
         }
     }
 
-    irq_leave_protection(irq_state);
+    task_unlock(irq_state);
 }
 
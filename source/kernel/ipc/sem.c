@@ -4,61 +4,79 @@
 #include "cpu/irq.h"
 #include "core/task.h"
 #include "ipc/sem.h"
+#include "core/trace.h"
 
 /**
  * 信号量初始化
  */
 void sem_init (sem_t * sem, int init_count) {
     sem->count = init_count;
+    sem->stat = (lock_stat_t *)0;
     list_init(&sem->wait_list);
 }
 
+/**
+ * 命名信号量，开始统计竞争情况
+ */
+void sem_set_name (sem_t * sem, const char * name) {
+    sem->stat = lock_stat_alloc(name, LOCK_TYPE_SEM);
+}
+
 /**
  * 申请信号量
  */
 void sem_wait (sem_t * sem) {
-    irq_state_t  irq_state = irq_enter_protection();
+    irq_state_t  irq_state = task_lock();
 
     if (sem->count > 0) {
         sem->count--;
+        if (sem->stat) {
+            sem->stat->acquire++;
+        }
     } else {
         // 从就绪队列中移除，然后加入信号量的等待队列
         task_t * curr = task_current();
         task_set_block(curr);
         list_insert_last(&sem->wait_list, &curr->wait_node);
+
+        uint64_t start = sem->stat ? lock_stat_now() : 0;
         task_dispatch();
+        if (sem->stat) {
+            lock_stat_wait(sem->stat, start);
+        }
     }
 
-    irq_leave_protection(irq_state);
+    task_unlock(irq_state);
 }
 
 /**
  * 释放信号量
  */
 void sem_notify (sem_t * sem) {
-    irq_state_t  irq_state = irq_enter_protection();
+    irq_state_t  irq_state = task_lock();
 
     if (list_count(&sem->wait_list)) {
         // 有进程等待，则唤醒加入就绪队列
         list_node_t * node = list_remove_first(&sem->wait_list);
         task_t * task = list_node_parent(node, task_t, wait_node);
         task_set_ready(task);
+        trace_event(TRACE_CLASS_WAKEUP, TRACE_SCHED_WAKEUP, task->pid, sem);
 
         task_dispatch();
     } else {
         sem->count++;
     }
 
-    irq_leave_protection(irq_state);
+    task_unlock(irq_state);
 }
 
 /**
  * 获取信号量的当前值
  */
 int sem_count (sem_t * sem) {
-    irq_state_t  irq_state = irq_enter_protection();
+    irq_state_t  irq_state = task_lock();
     int count = sem->count;
-    irq_leave_protection(irq_state);
+    task_unlock(irq_state);
     return count;
 }
 
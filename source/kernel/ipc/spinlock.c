@@ -0,0 +1,48 @@
+/**
+ * 自旋锁
+ */
+#include "comm/cpu_instr.h"
+#include "ipc/spinlock.h"
+
+/**
+ * 锁初始化
+ */
+void spinlock_init (spinlock_t * lock) {
+    lock->locked = 0;
+}
+
+/**
+ * 申请锁，xchg自带lock语义，失败后只读等待，减少总线争用
+ */
+void spin_lock (spinlock_t * lock) {
+    while (xchg(&lock->locked, 1) != 0) {
+        while (lock->locked) {
+            pause();
+        }
+    }
+}
+
+/**
+ * 释放锁
+ */
+void spin_unlock (spinlock_t * lock) {
+    __asm__ __volatile__("" ::: "memory");
+    lock->locked = 0;
+}
+
+/**
+ * 关中断后申请锁，防止中断处理中再次申请同一把锁导致死锁
+ */
+irq_state_t spin_lock_irqsave (spinlock_t * lock) {
+    irq_state_t state = irq_enter_protection();
+    spin_lock(lock);
+    return state;
+}
+
+/**
+ * 释放锁，并恢复中断状态
+ */
+void spin_unlock_irqrestore (spinlock_t * lock, irq_state_t state) {
+    spin_unlock(lock);
+    irq_leave_protection(state);
+}
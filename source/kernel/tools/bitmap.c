@@ -71,10 +71,10 @@ int bitmap_alloc_nbits (bitmap_t * bitmap, int bit, int count) {
         // 记录起始索引
         ok_idx = search_idx;
 
-        // 继续计算下一部分
+        // 继续检查后面的count-1位
         int i;
-        for (i = 1; (i < count) && (search_idx < bitmap->bit_count); i++) {
-            if (bitmap_get_bit(bitmap, search_idx++) != bit) {
+        for (i = 1, search_idx++; (i < count) && (search_idx < bitmap->bit_count); i++, search_idx++) {
+            if (bitmap_get_bit(bitmap, search_idx) != bit) {
                 // 不足count个，退出，重新进行最外层的比较
                 ok_idx = -1;
                 break;
@@ -83,7 +83,7 @@ int bitmap_alloc_nbits (bitmap_t * bitmap, int bit, int count) {
 
         // 找到，设置各位，然后退出
         if (i >= count) {
-            bitmap_set_bit(bitmap, ok_idx, count, ~bit);
+            bitmap_set_bit(bitmap, ok_idx, count, !bit);
             return ok_idx;
         }
     }
@@ -58,14 +58,11 @@ void kernel_strncpy(char * dest, const char * src, int size) {
     char * d = dest;
     const char * s = src;
 
-    while ((size-- > 0) && (*s)) {
+    // 最多复制size-1个字符，留出结束符的位置
+    while ((size-- > 1) && (*s)) {
         *d++ = *s++;
     }
-    if (size == 0) {
-        *(d - 1) = '\0';
-    } else {
-        *d = '\0';
-    }
+    *d = '\0';
 }
 
 int kernel_strlen(const char * str) {
@@ -98,7 +95,8 @@ int kernel_strncmp (const char * s1, const char * s2, int size) {
     	size--;
     }
 
-    return !((*s1 == '\0') || (*s2 == '\0') || (*s1 == *s2));
+    // 比较完size个字符也算相同
+    return size && !((*s1 == '\0') || (*s2 == '\0') || (*s1 == *s2));
 }
 
 void kernel_memcpy (void * dest, void * src, int size) {
@@ -237,6 +235,21 @@ void kernel_vsprintf(char * buffer, const char * fmt, va_list args) {
                 break;
         }
     }
+    *curr = '\0';
+}
+
+/**
+ * @brief 按log2计算直方图的桶号，第i桶为[2^(i+shift), 2^(i+shift+1))
+ * 首尾两桶包含更小和更大的值，超出32位的直接放入最后一桶
+ */
+int log2_bucket (uint64_t value, int shift, int nr) {
+    if (value >> 32) {
+        return nr - 1;
+    }
+
+    uint32_t low = (uint32_t)value;
+    int bucket = (low ? (31 - __builtin_clz(low)) : 0) - shift;
+    return (bucket < 0) ? 0 : ((bucket >= nr) ? nr - 1 : bucket);
 }
 
 void panic (const char * file, int line, const char * func, const char * cond) {
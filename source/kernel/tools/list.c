@@ -58,6 +58,29 @@ void list_insert_last(list_t *list, list_node_t *node) {
     list->count++;
 }
 
+/**
+ * 将指定表项插入到链表中某个结点之前
+ * @param list 操作的链表
+ * @param before 插入位置之后的结点，为空时插入到尾部
+ * @param node 待插入的结点
+ */
+void list_insert_before(list_t *list, list_node_t *before, list_node_t *node) {
+    if (before == (list_node_t *)0) {
+        list_insert_last(list, node);
+        return;
+    } else if (before == list->first) {
+        list_insert_first(list, node);
+        return;
+    }
+
+    node->pre = before->pre;
+    node->next = before;
+    before->pre->next = node;
+    before->pre = node;
+
+    list->count++;
+}
+
 /**
  * 移除指定链表的头部
  * @param list 操作的链表
@@ -23,6 +23,7 @@ static int log_dev_id;
  */
 void log_init (void) {
     mutex_init(&mutex);
+    mutex_set_name(&mutex, "log");
 
     log_dev_id = dev_open(DEV_TTY, 0, 0);
 
@@ -100,8 +100,12 @@ static void  enter_protect_mode() {
 
 
 void loader_entry(void) {
+	boot_info.stage_tsc[BOOT_STAGE_BOOT] = *(uint64_t *)BOOT_TSC_ADDR;
+	boot_info.stage_tsc[BOOT_STAGE_LOADER] = rdtsc();
+
     show_msg("....loading.....\r\n");
 	detect_memory();    
+	boot_info.stage_tsc[BOOT_STAGE_DETECT_MEM] = rdtsc();
 	enter_protect_mode();
     for(;;) {}
 }
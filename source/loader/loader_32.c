@@ -124,9 +124,12 @@ void enable_page_mode (void) {
  * 从磁盘上加载内核
  */
 void load_kernel(void) {
+    boot_info.stage_tsc[BOOT_STAGE_PROTECT] = rdtsc();
+
     // 读取的扇区数一定要大一些，保不准kernel.elf大小会变得很大
     // 100为内核文件在磁盘的起始扇区位置，500为要读的扇区数量
     read_disk(100, 500, (uint8_t *)SYS_KERNEL_LOAD_ADDR);
+    boot_info.stage_tsc[BOOT_STAGE_READ_DISK] = rdtsc();
 
      // 解析ELF文件，并通过调用的方式，进入到内核中去执行，同时传递boot参数
 	 // 临时将elf文件先读到SYS_KERNEL_LOAD_ADDR处，再进行解析
@@ -134,6 +137,7 @@ void load_kernel(void) {
 	if (kernel_entry == 0) {
 		die(-1);
 	}
+    boot_info.stage_tsc[BOOT_STAGE_RELOAD_ELF] = rdtsc();
 
 	// 开启分页机制
 	enable_page_mode();
@@ -8,6 +8,7 @@
 #include <getopt.h>
 #include <stdlib.h>
 #include <sys/file.h>
+#include <pthread.h>
 
 static cli_t cli;
 static const char * promot = "sh >>";       // 命令行提示符
@@ -97,6 +98,973 @@ static int do_echo (int argc, char ** argv) {
     return 0;
 }
 
+static const cli_cmd_t * find_builtin (const char * name);
+static void run_builtin (const cli_cmd_t * cmd, int argc, char ** argv);
+static int run_exec_file (const char * path, int argc, char ** argv);
+
+/**
+ * 统计命令的运行时间
+ */
+static int do_time (int argc, char ** argv) {
+    if (argc < 2) {
+        puts("Usage: time cmd [args]");
+        return -1;
+    }
+
+    struct tms start, end;
+    clock_t start_clock = times(&start);
+
+    // 后面的参数作为要运行的命令
+    const cli_cmd_t * cmd = find_builtin(argv[1]);
+    if (cmd) {
+        run_builtin(cmd, argc - 1, argv + 1);
+    } else if (run_exec_file(argv[1], argc - 1, argv + 1) < 0) {
+        fprintf(stderr, "Unknown command: %s\n", argv[1]);
+        return -1;
+    }
+
+    clock_t end_clock = times(&end);
+
+    // 外部命令的时间在子进程被回收后计入cutime/cstime
+    clock_t user = (end.tms_utime - start.tms_utime) + (end.tms_cutime - start.tms_cutime);
+    clock_t sys = (end.tms_stime - start.tms_stime) + (end.tms_cstime - start.tms_cstime);
+    printf("real %d ms\n", (int)((end_clock - start_clock) * 1000 / CLOCKS_PER_SEC));
+    printf("user %d ms\n", (int)(user * 1000 / CLOCKS_PER_SEC));
+    printf("sys  %d ms\n", (int)(sys * 1000 / CLOCKS_PER_SEC));
+    return 0;
+}
+
+/**
+ * 在上次的快照中查找同一任务，空闲任务的pid都为0，用所在的CPU区分
+ */
+static task_info_t * top_find (task_info_t * list, int count, task_info_t * task) {
+    for (int i = 0; i < count; i++) {
+        task_info_t * curr = list + i;
+        if ((curr->pid == task->pid) && (task->pid || (curr->cpu == task->cpu))) {
+            return curr;
+        }
+    }
+    return (task_info_t *)0;
+}
+
+/**
+ * 显示各任务的CPU占用
+ */
+static int do_top (int argc, char ** argv) {
+    static task_info_t snapshot[2][TOP_TASK_MAX];
+    static const char state_name[] = "CRSRWZ";      // 与task_t中的state对应
+
+    int count = 1;    // 缺省只显示一次
+    int ch;
+    while ((ch = getopt(argc, argv, "n:h")) != -1) {
+        switch (ch) {
+            case 'h':
+                puts("top show cpu usage of tasks");
+                puts("Usage: top [-n count]");
+                optind = 1;
+                return 0;
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+        }
+    }
+    optind = 1;
+
+    // 每次和上一次的快照比较，得到这段时间内的占用
+    int prev_count = task_info(snapshot[0], TOP_TASK_MAX);
+    clock_t prev_clock = times((struct tms *)0);
+    for (int n = 0; n < count; n++) {
+        msleep(TOP_INTERVAL_MS);
+
+        task_info_t * prev = snapshot[n % 2];
+        task_info_t * curr = snapshot[(n + 1) % 2];
+        int curr_count = task_info(curr, TOP_TASK_MAX);
+        clock_t curr_clock = times((struct tms *)0);
+        int elapsed_ms = (int)((curr_clock - prev_clock) * 1000 / CLOCKS_PER_SEC);
+
+        printf("%5s %5s %s %3s %4s %8s %8s %6s %6s %5s %s\n",
+                "PID", "PPID", "S", "CPU", "%CPU", "UTIME", "STIME", "VCSW", "IVCSW", "FLT", "NAME");
+        for (int i = 0; i < curr_count; i++) {
+            task_info_t * task = curr + i;
+            task_info_t * old = top_find(prev, prev_count, task);
+
+            uint32_t ticks = task->usage.utime + task->usage.stime;
+            if (old) {
+                ticks -= old->usage.utime + old->usage.stime;
+            }
+            int percent = elapsed_ms ? (int)(ticks * OS_TICK_MS * 100 / elapsed_ms) : 0;
+
+            printf("%5d %5d %c %3d %4d %8d %8d %6d %6d %5d %s\n",
+                task->pid, task->ppid, state_name[task->state], task->cpu, percent,
+                (int)(task->usage.utime * OS_TICK_MS), (int)(task->usage.stime * OS_TICK_MS),
+                (int)task->usage.nvcsw, (int)task->usage.nivcsw, (int)task->usage.faults,
+                task->name);
+        }
+
+        prev_count = curr_count;
+        prev_clock = curr_clock;
+    }
+    return 0;
+}
+
+static volatile int rtlat_stop;     // 通知负载线程退出
+
+/**
+ * 负载线程，一直占用CPU
+ */
+static void * rtlat_load (void * arg) {
+    while (!rtlat_stop) {}
+    return (void *)0;
+}
+
+/**
+ * 两个时间之差，单位us
+ */
+static int rtlat_diff_us (struct timespec * a, struct timespec * b) {
+    return (int)(a->tv_sec - b->tv_sec) * 1000000 + (int)(a->tv_nsec - b->tv_nsec) / 1000;
+}
+
+/**
+ * 按固定周期睡眠，测量实际唤醒时间与期望时间之差，单位us
+ */
+static void rtlat_measure (const char * name, int count, int period_ms) {
+    int min = 0x7FFFFFFF, max = 0, total = 0;
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (int i = 0; i < count; i++) {
+        // 按绝对时间推进，避免误差累积
+        next.tv_nsec += period_ms * 1000000;
+        while (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int wait_us = rtlat_diff_us(&next, &now);
+        if (wait_us > 0) {
+            struct timespec req = {wait_us / 1000000, (wait_us % 1000000) * 1000};
+            nanosleep(&req, (struct timespec *)0);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int lat = rtlat_diff_us(&now, &next);
+        if (lat < 0) {
+            lat = 0;
+        }
+
+        total += lat;
+        min = (lat < min) ? lat : min;
+        max = (lat > max) ? lat : max;
+    }
+
+    printf("%-8s min %6d us  avg %6d us  max %6d us\n", name, min, total / count, max);
+}
+
+/**
+ * 测量普通任务与实时任务在负载下的唤醒延迟
+ */
+static int do_rtlat (int argc, char ** argv) {
+    int count = RTLAT_COUNT;
+    int period_ms = RTLAT_PERIOD_MS;
+    int load = RTLAT_LOAD;
+    int deadline = 0;
+
+    int ch;
+    while ((ch = getopt(argc, argv, "n:p:l:dh")) != -1) {
+        switch (ch) {
+            case 'h':
+                puts("rtlat measure wakeup latency under load");
+                puts("Usage: rtlat [-n count] [-p period_ms] [-l load] [-d]");
+                optind = 1;
+                return 0;
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case 'p':
+                period_ms = atoi(optarg);
+                break;
+            case 'l':
+                load = atoi(optarg);
+                break;
+            case 'd':
+                deadline = 1;
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+        }
+    }
+    optind = 1;
+
+    if ((count <= 0) || (period_ms < OS_TICK_MS) || (load < 0) || (load > RTLAT_LOAD_MAX)) {
+        fprintf(stderr, "rtlat: bad argument\n");
+        return -1;
+    }
+
+    // 启动负载线程
+    pthread_t threads[RTLAT_LOAD_MAX];
+    rtlat_stop = 0;
+    int started = 0;
+    while (started < load) {
+        if (pthread_create(threads + started, (pthread_attr_t *)0, rtlat_load, (void *)0) != 0) {
+            break;
+        }
+        started++;
+    }
+    printf("rtlat: %d wakeups, period %d ms, %d load thread(s)\n", count, period_ms, started);
+
+    rtlat_measure("normal", count, period_ms);
+
+    // 切换到实时策略再测一次
+    task_sched_attr_t attr;
+    attr.policy = deadline ? TASK_SCHED_DEADLINE : TASK_SCHED_FIFO;
+    attr.priority = deadline ? 0 : RTLAT_FIFO_PRIO;
+    attr.runtime = OS_TICK_MS;
+    attr.period = period_ms;
+    if (sched_setattr(0, &attr) < 0) {
+        fprintf(stderr, "rtlat: set policy failed\n");
+    } else {
+        rtlat_measure(deadline ? "deadline" : "fifo", count, period_ms);
+
+        attr.policy = TASK_SCHED_NORMAL;
+        sched_setattr(0, &attr);
+    }
+
+    rtlat_stop = 1;
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], (void **)0);
+    }
+    return 0;
+}
+
+/**
+ * 用指定的方式执行count次空系统调用，返回总耗时，单位us
+ */
+static int sysbench_run (int fast, int count) {
+    syscall_set_fast(fast);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++) {
+        getpid();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return rtlat_diff_us(&end, &start);
+}
+
+/**
+ * 通过批量提交队列执行count个空操作，每批一次系统调用，返回总耗时，单位us
+ */
+static int sysbench_ring (uring_t * ring, int count) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int done = 0; done < count; ) {
+        int batch = 0;
+        uring_sqe_t * sqe;
+        while ((done + batch < count) && (sqe = uring_get_sqe(ring))) {
+            sqe->opcode = URING_OP_NOP;
+            sqe->user_data = done + batch;
+            uring_sq_push(ring);
+            batch++;
+        }
+
+        uring_enter(batch);
+        while (uring_peek_cqe(ring)) {
+            uring_cq_pop(ring);
+            done++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return rtlat_diff_us(&end, &start);
+}
+
+/**
+ * 比较调用门、sysenter和批量提交几种方式下空系统调用的开销
+ */
+static int do_sysbench (int argc, char ** argv) {
+    int count = SYSBENCH_COUNT;
+
+    int ch;
+    while ((ch = getopt(argc, argv, "n:h")) != -1) {
+        switch (ch) {
+            case 'h':
+                puts("sysbench measure null syscall cost: call gate, sysenter and batched ring");
+                puts("Usage: sysbench [-n count]");
+                optind = 1;
+                return 0;
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+        }
+    }
+    optind = 1;
+
+    if (count <= 0) {
+        fprintf(stderr, "sysbench: bad argument\n");
+        return -1;
+    }
+
+    int fast = syscall_set_fast(-1);
+    printf("sysbench: %d getpid calls\n", count);
+
+    const char * name[] = {"gate", "sysenter", "ring"};
+    uring_t * ring = uring_setup();
+    for (int i = 0; i < 3; i++) {
+        if ((i == 1) && !fast) {
+            puts("sysenter not supported");
+            continue;
+        }
+
+        unsigned us;
+        if (i < 2) {
+            us = sysbench_run(i, count);
+        } else if (ring) {
+            syscall_set_fast(fast);
+            us = sysbench_ring(ring, count);
+        } else {
+            puts("uring setup failed");
+            break;
+        }
+
+        // 分开计算，避免总耗时乘1000后溢出
+        unsigned ns = us / count * 1000 + us % count * 1000 / count;
+        printf("%-8s total %8d us  %6d ns/call\n", name[i], us, ns);
+    }
+
+    syscall_set_fast(fast);
+    return 0;
+}
+
+// 系统调用的名称，sysstat显示用
+static const struct {
+    int id;
+    const char * name;
+}sysstat_names[] = {
+    {SYS_msleep, "msleep"}, {SYS_getpid, "getpid"}, {SYS_fork, "fork"},
+    {SYS_execve, "execve"}, {SYS_yield, "yield"}, {SYS_exit, "exit"},
+    {SYS_wait, "wait"}, {SYS_waitpid, "waitpid"}, {SYS_vfork, "vfork"},
+    {SYS_spawn, "spawn"}, {SYS_futex, "futex"}, {SYS_clone, "clone"},
+    {SYS_set_tls, "set_tls"}, {SYS_sched_setattr, "sched_setattr"},
+    {SYS_sched_getattr, "sched_getattr"}, {SYS_uring_setup, "uring_setup"},
+    {SYS_uring_enter, "uring_enter"}, {SYS_profil, "profil"},
+    {SYS_clock_gettime, "clock_gettime"}, {SYS_gettimeofday, "gettimeofday"},
+    {SYS_nanosleep, "nanosleep"},
+    {SYS_times, "times"}, {SYS_getrusage, "getrusage"}, {SYS_task_info, "task_info"},
+    {SYS_open, "open"}, {SYS_read, "read"}, {SYS_write, "write"}, {SYS_close, "close"},
+    {SYS_lseek, "lseek"}, {SYS_isatty, "isatty"}, {SYS_sbrk, "sbrk"},
+    {SYS_fstat, "fstat"}, {SYS_dup, "dup"}, {SYS_printmsg, "printmsg"},
+};
+
+static const char * sysstat_name (int id) {
+    for (int i = 0; i < sizeof(sysstat_names) / sizeof(sysstat_names[0]); i++) {
+        if (sysstat_names[i].id == id) {
+            return sysstat_names[i].name;
+        }
+    }
+    return "?";
+}
+
+/**
+ * 显示系统调用的次数、错误数和耗时分布
+ */
+static int do_sysstat (int argc, char ** argv) {
+    int pid = 0, reset = 0, all = 0;
+
+    int ch;
+    while ((ch = getopt(argc, argv, "p:rah")) != -1) {
+        switch (ch) {
+            case 'h':
+                puts("sysstat show syscall counts and latency histograms");
+                puts("Usage: sysstat [-p pid] [-r] [-a]");
+                puts("  -p pid  show one task instead of the whole system");
+                puts("  -r      reset the counters");
+                puts("  -a      also show syscalls never called");
+                optind = 1;
+                return 0;
+            case 'p':
+                pid = atoi(optarg);
+                break;
+            case 'r':
+                reset = 1;
+                break;
+            case 'a':
+                all = 1;
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+        }
+    }
+    optind = 1;
+
+    char path[32];
+    if (pid) {
+        sprintf(path, "/dev/sysstat%d", pid);
+    } else {
+        strcpy(path, "/dev/sysstat");
+    }
+
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        fprintf(stderr, "sysstat: open %s failed\n", path);
+        return -1;
+    }
+
+    if (reset) {
+        int err = write(fd, "0", 1);
+        close(fd);
+        return (err < 0) ? -1 : 0;
+    }
+
+    // 每微秒的周期数，用于换算平均耗时
+    uint32_t mhz = clock_tsc_khz() / 1000;
+
+    printf("%-14s %8s %6s %10s %8s  histogram(log2 cycles:count)\n",
+            "syscall", "calls", "errors", "avg_cyc", "avg_us");
+    syscall_stat_t stat;
+    while (read(fd, &stat, sizeof(stat)) == sizeof(stat)) {
+        if (!stat.count && !all) {
+            continue;
+        }
+
+        // 没有64位除法，总周期数超过32位时同时缩小被除数和除数
+        uint64_t cycles = stat.cycles;
+        uint32_t count = stat.count;
+        while ((cycles >> 32) && count) {
+            cycles >>= 1;
+            count >>= 1;
+        }
+        uint32_t avg = count ? (uint32_t)cycles / count : 0;
+
+        printf("%-14s %8u %6u %10u %8u ", sysstat_name(stat.id), (unsigned)stat.count,
+                (unsigned)stat.errors, (unsigned)avg, mhz ? (unsigned)(avg / mhz) : 0);
+        for (int i = 0; i < SYSCALL_HIST_NR; i++) {
+            if (stat.hist[i]) {
+                printf(" %d:%u", i + SYSCALL_HIST_SHIFT, (unsigned)stat.hist[i]);
+            }
+        }
+        putchar('\n');
+    }
+    close(fd);
+    return 0;
+}
+
+// prof统计的地址
+typedef struct _prof_addr_t {
+    uint32_t addr;
+    int user;                       // 是否为用户态地址
+    int self;                       // 作为被中断处的次数
+    int total;                      // 包括出现在调用栈中的次数
+}prof_addr_t;
+
+static prof_addr_t prof_addrs[PROF_ADDR_MAX];
+static int prof_addr_count;
+static int prof_sort_total;         // 按total排序，否则按self
+
+static void prof_add (uint32_t addr, int user, int self) {
+    prof_addr_t * entry = (prof_addr_t *)0;
+    for (int i = 0; i < prof_addr_count; i++) {
+        if ((prof_addrs[i].addr == addr) && (prof_addrs[i].user == user)) {
+            entry = prof_addrs + i;
+            break;
+        }
+    }
+
+    // 表满后丢弃新地址，热点地址总是先出现
+    if (!entry) {
+        if (prof_addr_count >= PROF_ADDR_MAX) {
+            return;
+        }
+        entry = prof_addrs + prof_addr_count++;
+        entry->addr = addr;
+        entry->user = user;
+        entry->self = entry->total = 0;
+    }
+
+    entry->self += self;
+    entry->total++;
+}
+
+static int prof_compare (const void * a, const void * b) {
+    const prof_addr_t * pa = (const prof_addr_t *)a, * pb = (const prof_addr_t *)b;
+    return prof_sort_total ? (pb->total - pa->total) : (pb->self - pa->self);
+}
+
+/**
+ * 采样一段时间，按地址统计热点，地址可在主机上用script/prof-sym.py符号化
+ */
+static int do_prof (int argc, char ** argv) {
+    int time_ms = PROF_TIME_MS;
+    int show = PROF_SHOW;
+    int callgraph = 0;
+    int pid = 0;
+
+    int ch;
+    while ((ch = getopt(argc, argv, "t:n:p:gh")) != -1) {
+        switch (ch) {
+            case 'h':
+                puts("prof sample eip on every timer tick and show hot addresses");
+                puts("Usage: prof [-t ms] [-n count] [-p pid] [-g]");
+                puts("  -g  walk frame pointers, sort by inclusive count");
+                optind = 1;
+                return 0;
+            case 't':
+                time_ms = atoi(optarg);
+                break;
+            case 'n':
+                show = atoi(optarg);
+                break;
+            case 'p':
+                pid = atoi(optarg);
+                break;
+            case 'g':
+                callgraph = 1;
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+        }
+    }
+    optind = 1;
+
+    int fd = open("/dev/prof", O_RDWR);
+    if (fd < 0) {
+        fprintf(stderr, "prof: open /dev/prof failed\n");
+        return -1;
+    }
+
+    char cmd = callgraph ? PROF_CMD_CALLGRAPH : PROF_CMD_START;
+    if (write(fd, &cmd, 1) < 0) {
+        fprintf(stderr, "prof: start failed\n");
+        close(fd);
+        return -1;
+    }
+
+    prof_addr_count = 0;
+    prof_sort_total = callgraph;
+    int samples = 0;
+    for (int elapsed = 0; elapsed <= time_ms; elapsed += PROF_POLL_MS) {
+        msleep(PROF_POLL_MS);
+
+        prof_sample_t buf[16];
+        int size;
+        while ((size = read(fd, buf, sizeof(buf))) > 0) {
+            for (int i = 0; i < size / sizeof(prof_sample_t); i++) {
+                prof_sample_t * sample = buf + i;
+                if (pid && (sample->pid != pid)) {
+                    continue;
+                }
+
+                int user = (sample->cs & 3) != 0;
+                prof_add(sample->eip, user, 1);
+                for (int j = 0; j < sample->depth; j++) {
+                    prof_add(sample->callchain[j], user, 0);
+                }
+                samples++;
+            }
+        }
+    }
+
+    cmd = PROF_CMD_STOP;
+    write(fd, &cmd, 1);
+    close(fd);
+
+    qsort(prof_addrs, prof_addr_count, sizeof(prof_addr_t), prof_compare);
+    printf("prof: %d samples, %d addresses\n", samples, prof_addr_count);
+    printf("%6s %6s %6s  %s\n", "self", "total", "self%", "address");
+    for (int i = 0; (i < prof_addr_count) && (i < show); i++) {
+        prof_addr_t * entry = prof_addrs + i;
+        printf("%6d %6d %5d%%  %c 0x%08x\n", entry->self, entry->total,
+                samples ? entry->self * 100 / samples : 0, entry->user ? 'u' : 'k', (unsigned)entry->addr);
+    }
+    return 0;
+}
+
+static trace_event_t trace_events[TRACE_SHOW_MAX];
+
+static int trace_compare (const void * a, const void * b) {
+    const trace_event_t * ea = (const trace_event_t *)a, * eb = (const trace_event_t *)b;
+    return (ea->tsc < eb->tsc) ? -1 : (ea->tsc > eb->tsc);
+}
+
+/**
+ * 跟踪一段时间内的内核事件，按时间顺序显示
+ */
+static int do_trace (int argc, char ** argv) {
+    static const char * names[] = {
+        "?", "switch", "wakeup", "sys_enter", "sys_exit", "irq", "page_alloc", "page_free",
+    };
+    uint32_t mask = TRACE_CLASS_ALL;
+    int time_ms = TRACE_TIME_MS;
+    int show = TRACE_SHOW_MAX;
+
+    int ch;
+    while ((ch = getopt(argc, argv, "m:t:n:h")) != -1) {
+        switch (ch) {
+            case 'h':
+                puts("trace record kernel events and show them in time order");
+                puts("Usage: trace [-m mask] [-t ms] [-n count]");
+                puts("  mask: 1-switch 2-wakeup 4-syscall 8-irq 16-page, default all");
+                optind = 1;
+                return 0;
+            case 'm':
+                mask = strtoul(optarg, (char **)0, 0);
+                break;
+            case 't':
+                time_ms = atoi(optarg);
+                break;
+            case 'n':
+                show = atoi(optarg);
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+        }
+    }
+    optind = 1;
+
+    int fd = open("/dev/trace", O_RDWR);
+    if (fd < 0) {
+        fprintf(stderr, "trace: open /dev/trace failed\n");
+        return -1;
+    }
+
+    if (write(fd, &mask, sizeof(mask)) < 0) {
+        fprintf(stderr, "trace: start failed\n");
+        close(fd);
+        return -1;
+    }
+
+    // 超出保存数量的事件读出后丢弃，避免缓冲区满
+    int count = 0, total = 0;
+    for (int elapsed = 0; elapsed <= time_ms; elapsed += TRACE_POLL_MS) {
+        msleep(TRACE_POLL_MS);
+
+        trace_event_t buf[16];
+        int size;
+        while ((size = read(fd, buf, sizeof(buf))) > 0) {
+            for (int i = 0; i < size / sizeof(trace_event_t); i++) {
+                if (count < TRACE_SHOW_MAX) {
+                    trace_events[count++] = buf[i];
+                }
+                total++;
+            }
+        }
+    }
+
+    uint32_t stop = 0;
+    write(fd, &stop, sizeof(stop));
+    close(fd);
+
+    // 各CPU的事件分别读出，按时间合并
+    qsort(trace_events, count, sizeof(trace_event_t), trace_compare);
+    uint32_t mhz = clock_tsc_khz() / 1000;
+    printf("trace: %d events, show %d\n", total, (count < show) ? count : show);
+    printf("%10s %3s %5s %-10s %10s %10s\n", "time_us", "cpu", "pid", "event", "arg0", "arg1");
+    for (int i = 0; (i < count) && (i < show); i++) {
+        trace_event_t * event = trace_events + i;
+        uint32_t us = mhz ? div64(event->tsc - trace_events[0].tsc, mhz) : 0;
+        const char * name = (event->type < sizeof(names) / sizeof(names[0])) ? names[event->type] : "?";
+        printf("%10u %3d %5d %-10s %10x %10x\n", (unsigned)us, event->cpu, event->pid,
+                name, (unsigned)event->arg0, (unsigned)event->arg1);
+    }
+    return 0;
+}
+
+static int lockstat_compare (const void * a, const void * b) {
+    const lock_stat_t * la = (const lock_stat_t *)a, * lb = (const lock_stat_t *)b;
+    if (la->contend != lb->contend) {
+        return (la->contend > lb->contend) ? -1 : 1;
+    }
+    return (la->wait_total > lb->wait_total) ? -1 : (la->wait_total < lb->wait_total);
+}
+
+/**
+ * 显示内核锁的竞争统计，按竞争次数从多到少排序
+ */
+static int do_lockstat (int argc, char ** argv) {
+    int reset = 0;
+
+    int ch;
+    while ((ch = getopt(argc, argv, "rh")) != -1) {
+        switch (ch) {
+            case 'h':
+                puts("lockstat show contention of named kernel locks");
+                puts("Usage: lockstat [-r]");
+                puts("  -r      reset the counters");
+                optind = 1;
+                return 0;
+            case 'r':
+                reset = 1;
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+        }
+    }
+    optind = 1;
+
+    int fd = open("/dev/lockstat", O_RDWR);
+    if (fd < 0) {
+        fprintf(stderr, "lockstat: open /dev/lockstat failed\n");
+        return -1;
+    }
+
+    if (reset) {
+        int err = write(fd, "0", 1);
+        close(fd);
+        return (err < 0) ? -1 : 0;
+    }
+
+    static lock_stat_t stats[LOCK_STAT_NR];
+    int count = 0;
+    while ((count < LOCK_STAT_NR) && (read(fd, stats + count, sizeof(lock_stat_t)) == sizeof(lock_stat_t))) {
+        count++;
+    }
+    close(fd);
+
+    qsort(stats, count, sizeof(lock_stat_t), lockstat_compare);
+    uint32_t mhz = clock_tsc_khz() / 1000;
+    printf("%-12s %5s %8s %8s %10s %10s %10s %10s\n", "lock", "type", "acquire", "contend",
+            "wait_us", "wait_max", "hold_avg", "hold_max");
+    for (int i = 0; i < count; i++) {
+        lock_stat_t * stat = stats + i;
+        uint32_t wait = mhz ? div64(stat->wait_total, mhz) : 0;
+        uint32_t wait_max = mhz ? div64(stat->wait_max, mhz) : 0;
+        printf("%-12s %5s %8u %8u %10u %10u ", stat->name,
+                (stat->type == LOCK_TYPE_MUTEX) ? "mutex" : "sem",
+                (unsigned)stat->acquire, (unsigned)stat->contend, (unsigned)wait, (unsigned)wait_max);
+        if (stat->type == LOCK_TYPE_MUTEX) {
+            uint32_t hold = mhz ? div64(stat->hold_total, mhz) : 0;
+            uint32_t hold_max = mhz ? div64(stat->hold_max, mhz) : 0;
+            printf("%10u %10u\n", stat->acquire ? (unsigned)(hold / stat->acquire) : 0, (unsigned)hold_max);
+        } else {
+            printf("%10s %10s\n", "-", "-");
+        }
+    }
+    return 0;
+}
+
+static int irqlat_compare (const void * a, const void * b) {
+    const irqlat_site_t * sa = (const irqlat_site_t *)a, * sb = (const irqlat_site_t *)b;
+    return (sa->max > sb->max) ? -1 : (sa->max < sb->max);
+}
+
+/**
+ * 显示关中断时间最长的调用位置，地址可用script/prof-sym.py符号化
+ */
+static int do_irqlat (int argc, char ** argv) {
+    int show = IRQLAT_SHOW, threshold = -1;
+
+    int ch;
+    while ((ch = getopt(argc, argv, "n:w:h")) != -1) {
+        switch (ch) {
+            case 'h':
+                puts("irqlat show the longest irq-disabled sections");
+                puts("Usage: irqlat [-n count] [-w us]");
+                puts("  -n count  number of call sites to show");
+                puts("  -w us     set the warning threshold (0 to disable) and reset");
+                optind = 1;
+                return 0;
+            case 'n':
+                show = atoi(optarg);
+                break;
+            case 'w':
+                threshold = atoi(optarg);
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+        }
+    }
+    optind = 1;
+
+    int fd = open("/dev/irqlat", O_RDWR);
+    if (fd < 0) {
+        fprintf(stderr, "irqlat: open /dev/irqlat failed\n");
+        return -1;
+    }
+
+    if (threshold >= 0) {
+        uint32_t us = threshold;
+        int err = write(fd, &us, sizeof(us));
+        close(fd);
+        return (err < 0) ? -1 : 0;
+    }
+
+    static irqlat_site_t sites[IRQLAT_SITE_MAX];
+    int size = read(fd, sites, sizeof(sites));
+    close(fd);
+    int count = (size > 0) ? size / sizeof(irqlat_site_t) : 0;
+
+    qsort(sites, count, sizeof(irqlat_site_t), irqlat_compare);
+    uint32_t mhz = clock_tsc_khz() / 1000;
+    printf("irqlat: %d call sites\n", count);
+    printf("%8s %8s %8s  %s\n", "count", "avg_us", "max_us", "call chain");
+    for (int i = 0; (i < count) && (i < show); i++) {
+        irqlat_site_t * site = sites + i;
+        uint32_t avg = mhz ? div64(site->total, mhz) / site->count : 0;
+        uint32_t max = mhz ? div64(site->max, mhz) : 0;
+        printf("%8u %8u %8u  k 0x%08x\n", (unsigned)site->count, (unsigned)avg, (unsigned)max,
+                (unsigned)site->chain[0]);
+        for (int j = 1; (j < IRQLAT_DEPTH) && site->chain[j]; j++) {
+            printf("%26s  k 0x%08x\n", "", (unsigned)site->chain[j]);
+        }
+    }
+    return 0;
+}
+
+/**
+ * 显示启动各阶段的耗时，时间从上电时TSC为0算起
+ */
+static int do_boottime (int argc, char ** argv) {
+    static const char * names[BOOT_STAGE_NR] = {
+        "bios", "boot", "detect_memory", "enter_protect", "read_disk", "reload_elf",
+        "enable_paging", "cpu_init", "memory_init", "smp_init", "fs_init", "time_init",
+        "task_init", "start_aps", "first_task", "workqueue", "shell",
+    };
+
+    int ch;
+    while ((ch = getopt(argc, argv, "h")) != -1) {
+        switch (ch) {
+            case 'h':
+                puts("boottime show how long each boot stage took");
+                puts("Usage: boottime");
+                optind = 1;
+                return 0;
+            case '?':
+                optind = 1;
+                return -1;
+        }
+    }
+    optind = 1;
+
+    int fd = open("/dev/boottime", O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "boottime: open /dev/boottime failed\n");
+        return -1;
+    }
+
+    uint64_t stage_tsc[BOOT_STAGE_NR];
+    int size = read(fd, stage_tsc, sizeof(stage_tsc));
+    close(fd);
+    if (size != sizeof(stage_tsc)) {
+        fprintf(stderr, "boottime: read failed\n");
+        return -1;
+    }
+
+    uint32_t mhz = clock_tsc_khz() / 1000;
+    if (!mhz) {
+        fprintf(stderr, "boottime: no TSC\n");
+        return -1;
+    }
+
+    // 每个时间戳是该阶段结束的时刻，名称对应其之前的一段
+    printf("%-14s %10s %10s\n", "stage", "end_us", "cost_us");
+    uint64_t prev = 0;
+    for (int i = 0; i < BOOT_STAGE_NR; i++) {
+        if (!stage_tsc[i]) {
+            printf("%-14s %10s %10s\n", names[i], "-", "-");
+            continue;
+        }
+
+        printf("%-14s %10u %10u\n", names[i], (unsigned)div64(stage_tsc[i], mhz),
+                (unsigned)div64(stage_tsc[i] - prev, mhz));
+        prev = stage_tsc[i];
+    }
+    return 0;
+}
+
+/**
+ * 显示平均负载及唤醒到运行的调度延迟
+ */
+static int do_schedstat (int argc, char ** argv) {
+    int pid = 0, reset = 0;
+
+    int ch;
+    while ((ch = getopt(argc, argv, "p:rh")) != -1) {
+        switch (ch) {
+            case 'h':
+                puts("schedstat show load average and wakeup-to-run latency");
+                puts("Usage: schedstat [-p pid] [-r]");
+                puts("  -p pid  show one task instead of the whole system");
+                puts("  -r      reset the latency counters");
+                optind = 1;
+                return 0;
+            case 'p':
+                pid = atoi(optarg);
+                break;
+            case 'r':
+                reset = 1;
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+        }
+    }
+    optind = 1;
+
+    char path[32];
+    if (pid) {
+        sprintf(path, "/dev/schedstat%d", pid);
+    } else {
+        strcpy(path, "/dev/schedstat");
+    }
+
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        fprintf(stderr, "schedstat: open %s failed\n", path);
+        return -1;
+    }
+
+    if (reset) {
+        int err = write(fd, "0", 1);
+        close(fd);
+        return (err < 0) ? -1 : 0;
+    }
+
+    sched_stat_t stat;
+    int size = read(fd, &stat, sizeof(stat));
+    close(fd);
+    if (size != sizeof(stat)) {
+        fprintf(stderr, "schedstat: read %s failed\n", path);
+        return -1;
+    }
+
+    if (!pid) {
+        // 定点数转为两位小数
+        printf("load average:");
+        for (int i = 0; i < 3; i++) {
+            uint32_t load = stat.loadavg[i];
+            uint32_t frac = ((load & ((1 << SCHED_LOAD_SHIFT) - 1)) * 100) >> SCHED_LOAD_SHIFT;
+            printf(" %u.%02u", (unsigned)(load >> SCHED_LOAD_SHIFT), (unsigned)frac);
+        }
+        printf(", running: %u\n", (unsigned)stat.nr_running);
+    }
+
+    uint32_t mhz = clock_tsc_khz() / 1000;
+    sched_wait_t * wait = &stat.wait;
+    uint32_t avg = (mhz && wait->wakeups) ? div64(wait->total, mhz) / wait->wakeups : 0;
+    uint32_t max = mhz ? div64(wait->max, mhz) : 0;
+    printf("wakeups: %u, avg %u us, max %u us\n", (unsigned)wait->wakeups, (unsigned)avg, (unsigned)max);
+    printf("histogram(log2 cycles:count):");
+    for (int i = 0; i < SCHED_HIST_NR; i++) {
+        if (wait->hist[i]) {
+            printf(" %d:%u", i + SCHED_HIST_SHIFT, (unsigned)wait->hist[i]);
+        }
+    }
+    putchar('\n');
+    return 0;
+}
+
 /**
  * 程序退出命令
  */
@@ -122,6 +1090,61 @@ static const cli_cmd_t cmd_list[] = {
 		.useage = "echo [-n count] msg  -- echo something",
 		.do_func = do_echo,
 	},
+    {
+        .name = "time",
+        .useage = "time cmd [args] -- run cmd and show its time",
+        .do_func = do_time,
+    },
+    {
+        .name = "top",
+        .useage = "top [-n count] -- show cpu usage of tasks",
+        .do_func = do_top,
+    },
+    {
+        .name = "rtlat",
+        .useage = "rtlat [-n count] [-p period_ms] [-l load] [-d] -- measure wakeup latency",
+        .do_func = do_rtlat,
+    },
+    {
+        .name = "sysstat",
+        .useage = "sysstat [-p pid] [-r] [-a] -- show syscall statistics",
+        .do_func = do_sysstat,
+    },
+    {
+        .name = "prof",
+        .useage = "prof [-t ms] [-n count] [-p pid] [-g] -- sampling profiler",
+        .do_func = do_prof,
+    },
+    {
+        .name = "trace",
+        .useage = "trace [-m mask] [-t ms] [-n count] -- trace kernel events",
+        .do_func = do_trace,
+    },
+    {
+        .name = "lockstat",
+        .useage = "lockstat [-r] -- show kernel lock contention",
+        .do_func = do_lockstat,
+    },
+    {
+        .name = "irqlat",
+        .useage = "irqlat [-n count] [-w us] -- show longest irq-off sections",
+        .do_func = do_irqlat,
+    },
+    {
+        .name = "boottime",
+        .useage = "boottime -- show time spent in each boot stage",
+        .do_func = do_boottime,
+    },
+    {
+        .name = "schedstat",
+        .useage = "schedstat [-p pid] [-r] -- show load and wakeup latency",
+        .do_func = do_schedstat,
+    },
+    {
+        .name = "sysbench",
+        .useage = "sysbench [-n count] -- measure null syscall cost",
+        .do_func = do_sysbench,
+    },
     {
         .name = "quit",
         .useage = "quit from shell",
@@ -168,32 +1191,22 @@ static void run_builtin (const cli_cmd_t * cmd, int argc, char ** argv) {
 
 
 /**
- * 试图运行当前文件
+ * 试图运行当前文件，成功启动返回0
+ * 由内核直接从文件创建子进程，不需要先fork复制shell的地址空间
  */
-static void run_exec_file (const char * path, int argc, char ** argv) {
-    int pid = fork();
-    if (pid < 0) {
-        fprintf(stderr, "fork failed: %s", path);
-    } else if (pid == 0) {
-        // 以下供测试exit使用
-        for (int i = 0; i < argc; i++) {
-            msleep(1000);
-            printf("arg %d = %s\n", i, argv[i]);
-        }
-        exit(-1);
-
-        // 子进程
-        // int err = execve(path, argv, (char * const *)0);
-        // if (err < 0) {
-        //     fprintf(stderr, "exec failed: %s", path);
-        // }
-        // exit(-1);
-    } else {
-		// 等待子进程执行完毕
-        int status;
-        int pid = wait(&status);
-        fprintf(stderr, "cmd %s result: %d, pid = %d\n", path, status, pid);
+static int run_exec_file (const char * path, int argc, char ** argv) {
+    pid_t pid;
+    int err = posix_spawn(&pid, path, (const posix_spawn_file_actions_t *)0,
+                        (const posix_spawnattr_t *)0, argv, (char * const *)0);
+    if (err) {
+        return -1;
     }
+
+    // 等待子进程执行完毕
+    int status;
+    waitpid(pid, &status, 0);
+    fprintf(stderr, "cmd %s result: %d, pid = %d\n", path, status, pid);
+    return 0;
 }
 
 int main (int argc, char **argv) {
@@ -202,6 +1215,14 @@ int main (int argc, char **argv) {
     dup(0);     // 标准错误输出
 
    	cli_init(promot, cmd_list, sizeof(cmd_list) / sizeof(cli_cmd_t));
+
+    // 记录启动完成的时刻，只有第一个shell的有效
+    int fd = open("/dev/boottime", O_RDWR);
+    if (fd >= 0) {
+        write(fd, "1", 1);
+        close(fd);
+    }
+
 	for (;;) {
         // 显示提示符，开始工作
         show_promot();
@@ -251,15 +1272,10 @@ int main (int argc, char **argv) {
             continue;
         }
 
-        // 测试程序，运行虚拟的程序
-        run_exec_file("", argc, argv);
-
-        // 试图作为外部命令执行。只检查文件是否存在，不考虑是否可执行
-        // const char * path = find_exec_path(argv[0]);
-        // if (path) {
-        //     run_exec_file(path, argc, argv);
-        //     continue;
-        // }
+        // 试图作为外部命令执行
+        if (run_exec_file(argv[0], argc, argv) == 0) {
+            continue;
+        }
 
         // 找不到命令，提示错误
         fprintf(stderr, ESC_COLOR_ERROR"Unknown command: %s\n"ESC_COLOR_DEFAULT, cli.curr_input);
@@ -7,6 +7,29 @@
 #define CLI_INPUT_SIZE              1024            // 输入缓存区
 #define	CLI_MAX_ARG_COUNT		    10			    // 最大接收的参数数量
 
+#define TOP_TASK_MAX                64              // top最多显示的任务数
+#define TOP_INTERVAL_MS             1000            // top的刷新间隔
+
+#define RTLAT_COUNT                 100             // rtlat缺省的测量次数
+#define RTLAT_PERIOD_MS             20              // rtlat缺省的唤醒周期
+#define RTLAT_LOAD                  2               // rtlat缺省的负载线程数
+#define RTLAT_LOAD_MAX              8
+#define RTLAT_FIFO_PRIO             50              // 测量时使用的FIFO优先级
+
+#define SYSBENCH_COUNT              100000          // sysbench缺省的调用次数
+
+#define PROF_TIME_MS                2000            // prof缺省的采样时长
+#define PROF_POLL_MS                100             // 读取样本的间隔，需在缓冲区满之前取走
+#define PROF_ADDR_MAX               256             // 统计的不同地址数上限
+#define PROF_SHOW                   20              // 缺省显示的地址数
+
+#define TRACE_TIME_MS               200             // trace缺省的跟踪时长
+#define TRACE_POLL_MS               20              // 读取事件的间隔
+#define TRACE_SHOW_MAX              128             // 最多保存并显示的事件数
+
+#define IRQLAT_SITE_MAX             128             // 读取的调用位置数上限，与内核表大小相同
+#define IRQLAT_SHOW                 10              // 缺省显示的调用位置数
+
 #define ESC_CMD2(Pn, cmd)		    "\x1b["#Pn#cmd
 #define	ESC_COLOR_ERROR			    ESC_CMD2(31, m)	// 红色错误
 #define	ESC_COLOR_DEFAULT		    ESC_CMD2(39, m)	// 默认颜色
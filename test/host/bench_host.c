@@ -0,0 +1,215 @@
+/**
+ * 内核数据结构在主机上的性能测试
+ * 每一项自动增加迭代次数，直到耗时超过最短测量时间，输出每次操作的耗时及吞吐量。
+ * 用法: bench_host [最短测量时间ms，默认200] [名称过滤]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tools/bitmap.h"
+#include "tools/list.h"
+#include "tools/klib.h"
+#include "dev/tty.h"
+
+#define BITMAP_BITS         32768       // 与128MB内存的页数相同
+#define COPY_SIZE_MAX       65536
+#define LIST_NODES          64
+
+/**
+ * @brief 一项测试，func执行iters次操作，返回不含准备工作的耗时(ns)
+ */
+typedef struct _bench_t {
+    const char * name;
+    uint64_t (*func) (int iters, int arg);
+    int arg;
+    int bytes;                          // 每次操作处理的字节数，不为0时输出吞吐量
+}bench_t;
+
+static uint8_t bitmap_bits[BITMAP_BITS / 8];
+static uint8_t copy_src[COPY_SIZE_MAX], copy_dest[COPY_SIZE_MAX];
+static volatile int sink;               // 保存结果，避免被当作无用的计算
+
+static uint64_t now_ns (void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief 在已使用arg%的位图中分配一页后释放
+ * 物理页从低地址开始分配，已使用的页集中在前面，每次都要扫描过这些位
+ */
+static uint64_t bench_bitmap_alloc (int iters, int arg) {
+    bitmap_t bitmap;
+    bitmap_init(&bitmap, bitmap_bits, BITMAP_BITS, 0);
+    bitmap_set_bit(&bitmap, 0, BITMAP_BITS / 100 * arg, 1);
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < iters; i++) {
+        int index = bitmap_alloc_nbits(&bitmap, 0, 1);
+        bitmap_set_bit(&bitmap, index, 1, 0);
+        sink = index;
+    }
+    return now_ns() - start;
+}
+
+/**
+ * @brief 已使用的页与空闲页交替分布时分配连续16页，前面的空洞都不够大
+ */
+static uint64_t bench_bitmap_alloc_frag (int iters, int arg) {
+    bitmap_t bitmap;
+    bitmap_init(&bitmap, bitmap_bits, BITMAP_BITS, 0);
+    for (int i = 0; i < BITMAP_BITS / 100 * arg; i += 16) {
+        bitmap_set_bit(&bitmap, i, 1, 1);
+    }
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < iters; i++) {
+        int index = bitmap_alloc_nbits(&bitmap, 0, 16);
+        bitmap_set_bit(&bitmap, index, 16, 0);
+        sink = index;
+    }
+    return now_ns() - start;
+}
+
+static uint64_t bench_kernel_memcpy (int iters, int size) {
+    uint64_t start = now_ns();
+    for (int i = 0; i < iters; i++) {
+        kernel_memcpy(copy_dest, copy_src, size);
+    }
+    return now_ns() - start;
+}
+
+// 主机C库的实现，作为对比
+static uint64_t bench_libc_memcpy (int iters, int size) {
+    uint64_t start = now_ns();
+    for (int i = 0; i < iters; i++) {
+        memcpy(copy_dest, copy_src, size);
+        sink = copy_dest[0];
+    }
+    return now_ns() - start;
+}
+
+static uint64_t bench_kernel_memset (int iters, int size) {
+    uint64_t start = now_ns();
+    for (int i = 0; i < iters; i++) {
+        kernel_memset(copy_dest, (uint8_t)i, size);
+    }
+    return now_ns() - start;
+}
+
+static uint64_t bench_kernel_strlen (int iters, int size) {
+    memset(copy_src, 'a', size);
+    copy_src[size] = '\0';
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < iters; i++) {
+        sink = kernel_strlen((const char *)copy_src);
+    }
+    return now_ns() - start;
+}
+
+/**
+ * @brief 就绪队列式的使用：从头部取出后插入到尾部
+ */
+static uint64_t bench_list_rotate (int iters, int arg) {
+    static list_node_t nodes[LIST_NODES];
+    list_t list;
+
+    list_init(&list);
+    for (int i = 0; i < LIST_NODES; i++) {
+        list_insert_last(&list, nodes + i);
+    }
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < iters; i++) {
+        list_insert_last(&list, list_remove_first(&list));
+    }
+    return now_ns() - start;
+}
+
+/**
+ * @brief 写入一个字节后读出，包括加锁和中断保护的开销
+ */
+static uint64_t bench_tty_fifo (int iters, int arg) {
+    tty_fifo_t fifo;
+    char buf[TTY_OBUF_SIZE], c;
+
+    tty_fifo_init(&fifo, buf, sizeof(buf));
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < iters; i++) {
+        tty_fifo_put(&fifo, (char)i);
+        tty_fifo_get(&fifo, &c);
+    }
+    sink = c;
+    return now_ns() - start;
+}
+
+static const bench_t bench_list[] = {
+    {"bitmap_alloc/fill:0", bench_bitmap_alloc, 0, 0},
+    {"bitmap_alloc/fill:50", bench_bitmap_alloc, 50, 0},
+    {"bitmap_alloc/fill:90", bench_bitmap_alloc, 90, 0},
+    {"bitmap_alloc/fill:99", bench_bitmap_alloc, 99, 0},
+    {"bitmap_alloc16/frag:50", bench_bitmap_alloc_frag, 50, 0},
+    {"bitmap_alloc16/frag:90", bench_bitmap_alloc_frag, 90, 0},
+    {"kernel_memcpy/16", bench_kernel_memcpy, 16, 16},
+    {"kernel_memcpy/256", bench_kernel_memcpy, 256, 256},
+    {"kernel_memcpy/4096", bench_kernel_memcpy, 4096, 4096},
+    {"kernel_memcpy/65536", bench_kernel_memcpy, 65536, 65536},
+    {"libc_memcpy/16", bench_libc_memcpy, 16, 16},
+    {"libc_memcpy/256", bench_libc_memcpy, 256, 256},
+    {"libc_memcpy/4096", bench_libc_memcpy, 4096, 4096},
+    {"libc_memcpy/65536", bench_libc_memcpy, 65536, 65536},
+    {"kernel_memset/4096", bench_kernel_memset, 4096, 4096},
+    {"kernel_strlen/64", bench_kernel_strlen, 64, 64},
+    {"list_rotate", bench_list_rotate, 0, 0},
+    {"tty_fifo_put_get", bench_tty_fifo, 0, 1},
+};
+
+/**
+ * @brief 迭代次数从1开始按耗时估算增加，直到超过最短测量时间
+ */
+static void bench_run (const bench_t * bench, uint64_t min_ns) {
+    int iters = 1;
+    uint64_t ns;
+
+    for (;;) {
+        ns = bench->func(iters, bench->arg);
+        if ((ns >= min_ns) || (iters >= (1 << 30))) {
+            break;
+        }
+
+        // 按已有的耗时估算，多加一些余量，每次最多增加到10倍
+        uint64_t next = ns ? (min_ns * 14 / 10) * iters / ns : (uint64_t)iters * 10;
+        next = next > (uint64_t)iters * 10 ? (uint64_t)iters * 10 : next;
+        next = next <= (uint64_t)iters ? (uint64_t)iters + 1 : next;
+        iters = next > (1 << 30) ? (1 << 30) : (int)next;
+    }
+
+    double per_op = (double)ns / iters;
+    printf("%-28s %12d %12.1f", bench->name, iters, per_op);
+    if (bench->bytes) {
+        // 字节/ns即GB/s，换算成MB/s
+        printf(" %12.1f", bench->bytes / per_op * 1000);
+    }
+    printf("\n");
+}
+
+int main (int argc, char ** argv) {
+    uint64_t min_ns = (argc > 1 ? strtoul(argv[1], (char **)0, 10) : 200) * 1000000ull;
+    const char * filter = argc > 2 ? argv[2] : (const char *)0;
+
+    for (int i = 0; i < sizeof(copy_src); i++) {
+        copy_src[i] = (uint8_t)i;
+    }
+
+    printf("%-28s %12s %12s %12s\n", "Benchmark", "Iterations", "ns/op", "MB/s");
+    for (int i = 0; i < sizeof(bench_list) / sizeof(bench_list[0]); i++) {
+        if (!filter || strstr(bench_list[i].name, filter)) {
+            bench_run(bench_list + i, min_ns);
+        }
+    }
+    return 0;
+}
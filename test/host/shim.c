@@ -0,0 +1,63 @@
+/**
+ * 内核接口在主机上的替代实现
+ * 测试都是单线程运行，中断保护和自旋锁只检查是否成对使用，不实际互斥
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include "cpu/irq.h"
+#include "ipc/spinlock.h"
+#include "tools/log.h"
+
+int host_irq_depth;             // 当前中断保护的嵌套层数
+
+irq_state_t irq_enter_protection (void) {
+    return host_irq_depth++;
+}
+
+void irq_leave_protection (irq_state_t state) {
+    host_irq_depth = state;
+}
+
+void spinlock_init (spinlock_t * lock) {
+    lock->locked = 0;
+}
+
+/**
+ * @brief 单线程中重复加锁即为死锁，直接报错
+ */
+void spin_lock (spinlock_t * lock) {
+    if (lock->locked) {
+        fprintf(stderr, "spin_lock: lock %p already held\n", (void *)lock);
+        abort();
+    }
+    lock->locked = 1;
+}
+
+void spin_unlock (spinlock_t * lock) {
+    if (!lock->locked) {
+        fprintf(stderr, "spin_unlock: lock %p not held\n", (void *)lock);
+        abort();
+    }
+    lock->locked = 0;
+}
+
+irq_state_t spin_lock_irqsave (spinlock_t * lock) {
+    irq_state_t state = irq_enter_protection();
+    spin_lock(lock);
+    return state;
+}
+
+void spin_unlock_irqrestore (spinlock_t * lock, irq_state_t state) {
+    spin_unlock(lock);
+    irq_leave_protection(state);
+}
+
+void log_printf (const char * fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
@@ -0,0 +1,10 @@
+/**
+ * 主机上的基本数据类型
+ * 内核的comm/types.h将uint32_t定义为unsigned long，在64位主机上长度不对，且与stdint.h冲突
+ */
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <stdint.h>
+
+#endif
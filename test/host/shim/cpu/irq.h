@@ -0,0 +1,15 @@
+/**
+ * 主机上的中断保护接口，实现见shim.c
+ */
+#ifndef IRQ_H
+#define IRQ_H
+
+#include "comm/types.h"
+
+typedef uint32_t irq_state_t;
+irq_state_t irq_enter_protection (void);
+void irq_leave_protection (irq_state_t state);
+
+extern int host_irq_depth;
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * 主机测试用的检查宏，每个测试程序一个文件，失败时返回非0
+ */
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+static int test_failed;
+
+// 检查失败只记录，继续执行后面的检查
+#define CHECK(cond)     do {                                                        \
+        if (!(cond)) {                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failed++;                                                          \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_EQ(a, b)  CHECK((a) == (b))
+
+// 运行一个测试函数
+#define RUN_TEST(func)  do {                                                        \
+        int failed = test_failed;                                                   \
+        func();                                                                     \
+        printf("%-32s %s\n", #func, (test_failed == failed) ? "ok" : "FAILED");     \
+    } while (0)
+
+static inline int test_result (void) {
+    if (test_failed) {
+        fprintf(stderr, "%d check(s) failed\n", test_failed);
+    }
+    return test_failed ? 1 : 0;
+}
+
+#endif // TEST_H
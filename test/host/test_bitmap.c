@@ -0,0 +1,116 @@
+/**
+ * 位图的测试
+ */
+#include <string.h>
+#include "test.h"
+#include "tools/bitmap.h"
+
+#define BIT_COUNT       100
+
+static uint8_t bits[(BIT_COUNT + 7) / 8];
+static bitmap_t bitmap;
+
+static int count_set (void) {
+    int count = 0;
+    for (int i = 0; i < BIT_COUNT; i++) {
+        count += bitmap_get_bit(&bitmap, i);
+    }
+    return count;
+}
+
+static void test_init (void) {
+    CHECK_EQ(bitmap_byte_count(0), 0);
+    CHECK_EQ(bitmap_byte_count(1), 1);
+    CHECK_EQ(bitmap_byte_count(8), 1);
+    CHECK_EQ(bitmap_byte_count(9), 2);
+
+    bitmap_init(&bitmap, bits, BIT_COUNT, 1);
+    CHECK_EQ(count_set(), BIT_COUNT);
+    bitmap_init(&bitmap, bits, BIT_COUNT, 0);
+    CHECK_EQ(count_set(), 0);
+}
+
+static void test_set_bit (void) {
+    bitmap_init(&bitmap, bits, BIT_COUNT, 0);
+
+    // 跨字节设置
+    bitmap_set_bit(&bitmap, 5, 10, 1);
+    CHECK_EQ(count_set(), 10);
+    CHECK(!bitmap_is_set(&bitmap, 4));
+    CHECK(bitmap_is_set(&bitmap, 5));
+    CHECK(bitmap_is_set(&bitmap, 14));
+    CHECK(!bitmap_is_set(&bitmap, 15));
+
+    bitmap_set_bit(&bitmap, 8, 2, 0);
+    CHECK_EQ(count_set(), 8);
+    CHECK(!bitmap_is_set(&bitmap, 8));
+    CHECK(!bitmap_is_set(&bitmap, 9));
+
+    // 超出范围的部分被忽略，不能写到位图之外
+    bits[sizeof(bits) - 1] = 0;
+    bitmap_set_bit(&bitmap, BIT_COUNT - 2, 10, 1);
+    CHECK(bitmap_is_set(&bitmap, BIT_COUNT - 1));
+    CHECK_EQ(count_set(), 10);
+}
+
+static void test_alloc (void) {
+    bitmap_init(&bitmap, bits, BIT_COUNT, 0);
+
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 1), 0);
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 4), 1);
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 1), 5);
+    CHECK_EQ(count_set(), 6);
+
+    // 释放后的空洞能被重新使用
+    bitmap_set_bit(&bitmap, 1, 4, 0);
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 4), 1);
+
+    // 空洞不够大时不能使用，需跳到后面
+    bitmap_set_bit(&bitmap, 2, 2, 0);
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 3), 6);
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 2), 2);
+}
+
+static void test_alloc_boundary (void) {
+    bitmap_init(&bitmap, bits, BIT_COUNT, 1);
+
+    // 恰好两个连续空闲位，第三位已使用
+    bitmap_set_bit(&bitmap, 10, 2, 0);
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 3), -1);
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 2), 10);
+    CHECK_EQ(count_set(), BIT_COUNT);
+
+    // 间隔的空闲位不能组成连续的两位
+    for (int i = 20; i < 40; i += 2) {
+        bitmap_set_bit(&bitmap, i, 1, 0);
+    }
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 2), -1);
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 1), 20);
+
+    // 末尾的空闲位
+    bitmap_set_bit(&bitmap, BIT_COUNT - 3, 3, 0);
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 4), -1);
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 3), BIT_COUNT - 3);
+}
+
+static void test_alloc_full (void) {
+    bitmap_init(&bitmap, bits, BIT_COUNT, 0);
+
+    for (int i = 0; i < BIT_COUNT; i++) {
+        CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 1), i);
+    }
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 0, 1), -1);
+
+    // 分配置0的位
+    CHECK_EQ(bitmap_alloc_nbits(&bitmap, 1, 5), 0);
+    CHECK_EQ(count_set(), BIT_COUNT - 5);
+}
+
+int main (void) {
+    RUN_TEST(test_init);
+    RUN_TEST(test_set_bit);
+    RUN_TEST(test_alloc);
+    RUN_TEST(test_alloc_boundary);
+    RUN_TEST(test_alloc_full);
+    return test_result();
+}
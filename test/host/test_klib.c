@@ -0,0 +1,95 @@
+/**
+ * 内核字符串及内存函数的测试
+ */
+#include <string.h>
+#include "test.h"
+#include "tools/klib.h"
+
+static void test_string (void) {
+    CHECK_EQ(kernel_strlen(""), 0);
+    CHECK_EQ(kernel_strlen("hello"), 5);
+    CHECK_EQ(kernel_strlen((const char *)0), 0);
+
+    // 某一字符串提前结束也算相同，见kernel_strncmp的说明
+    CHECK_EQ(kernel_strncmp("abc", "abc", 3), 0);
+    CHECK_EQ(kernel_strncmp("abc", "abd", 2), 0);
+    CHECK(kernel_strncmp("abc", "abd", 3) != 0);
+    CHECK_EQ(kernel_strncmp("/dev/tty", "/dev/tty0", 10), 0);
+    CHECK(kernel_strncmp("tty", "sysstat", 3) != 0);
+
+    char buf[8];
+    memset(buf, 'x', sizeof(buf));
+    kernel_strncpy(buf, "hello", sizeof(buf));
+    CHECK(strcmp(buf, "hello") == 0);
+    kernel_strncpy(buf, "hello world", sizeof(buf));
+    CHECK(strcmp(buf, "hello w") == 0);
+
+    char path[] = "/dev/tty0";
+    CHECK(strcmp(get_file_name(path), "tty0") == 0);
+
+    char * strs[] = {"a", "b", "c", (char *)0};
+    CHECK_EQ(strings_count(strs), 3);
+    CHECK_EQ(strings_count((char **)0), 0);
+}
+
+static void test_memory (void) {
+    uint8_t src[300], dest[310];
+    for (int i = 0; i < sizeof(src); i++) {
+        src[i] = (uint8_t)(i * 7);
+    }
+
+    // 检查各种长度及不对齐的情况，且不能写到范围之外
+    for (int offset = 0; offset < 4; offset++) {
+        for (int size = 0; size < sizeof(src); size += 37) {
+            memset(dest, 0xAA, sizeof(dest));
+            kernel_memcpy(dest + offset, src, size);
+            CHECK(memcmp(dest + offset, src, size) == 0);
+            CHECK_EQ(dest[offset + size], 0xAA);
+            CHECK_EQ(kernel_memcmp(dest + offset, src, size), 0);
+        }
+    }
+    CHECK(kernel_memcmp(dest, src, 16) != 0);
+
+    memset(dest, 0, sizeof(dest));
+    kernel_memset(dest + 1, 0x5A, 100);
+    CHECK_EQ(dest[0], 0);
+    CHECK_EQ(dest[1], 0x5A);
+    CHECK_EQ(dest[100], 0x5A);
+    CHECK_EQ(dest[101], 0);
+}
+
+static void test_sprintf (void) {
+    char buf[64];
+
+    kernel_itoa(buf, 0, 10);
+    CHECK(strcmp(buf, "0") == 0);
+    kernel_itoa(buf, -123, 10);
+    CHECK(strcmp(buf, "-123") == 0);
+    kernel_itoa(buf, 255, 16);
+    CHECK(strcmp(buf, "FF") == 0);
+    kernel_itoa(buf, 5, 2);
+    CHECK(strcmp(buf, "101") == 0);
+    kernel_itoa(buf, 5, 3);
+    CHECK(strcmp(buf, "") == 0);
+
+    kernel_sprintf(buf, "%s:%d %x %c", "pid", 42, 0x1f, '!');
+    CHECK(strcmp(buf, "pid:42 1F !") == 0);
+}
+
+static void test_log2_bucket (void) {
+    CHECK_EQ(log2_bucket(0, 7, 16), 0);
+    CHECK_EQ(log2_bucket(255, 7, 16), 0);
+    CHECK_EQ(log2_bucket(256, 7, 16), 1);
+    CHECK_EQ(log2_bucket(511, 7, 16), 1);
+    CHECK_EQ(log2_bucket(1u << 22, 7, 16), 15);
+    CHECK_EQ(log2_bucket(0xFFFFFFFFu, 7, 16), 15);
+    CHECK_EQ(log2_bucket(1ull << 40, 7, 16), 15);
+}
+
+int main (void) {
+    RUN_TEST(test_string);
+    RUN_TEST(test_memory);
+    RUN_TEST(test_sprintf);
+    RUN_TEST(test_log2_bucket);
+    return test_result();
+}
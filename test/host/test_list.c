@@ -0,0 +1,68 @@
+/**
+ * 链表的测试
+ */
+#include "test.h"
+#include "tools/list.h"
+
+#define NODE_COUNT      5
+
+static list_node_t nodes[NODE_COUNT];
+
+// 按顺序检查链表中的结点，同时检查反向的链接
+static int list_matches (list_t * list, int * index, int count) {
+    if (list_count(list) != count) {
+        return 0;
+    }
+
+    list_node_t * node = list_first(list);
+    list_node_t * pre = (list_node_t *)0;
+    for (int i = 0; i < count; i++) {
+        if ((node != nodes + index[i]) || (list_node_pre(node) != pre)) {
+            return 0;
+        }
+        pre = node;
+        node = list_node_next(node);
+    }
+    return (node == (list_node_t *)0) && (list_last(list) == pre);
+}
+
+static void test_insert (void) {
+    list_t list;
+    list_init(&list);
+    CHECK(list_is_empty(&list));
+    CHECK(list_first(&list) == (list_node_t *)0);
+
+    list_insert_last(&list, nodes + 1);
+    list_insert_last(&list, nodes + 2);
+    list_insert_first(&list, nodes + 0);
+    CHECK(list_matches(&list, (int []){0, 1, 2}, 3));
+
+    list_insert_before(&list, nodes + 0, nodes + 3);
+    list_insert_before(&list, nodes + 2, nodes + 4);
+    CHECK(list_matches(&list, (int []){3, 0, 1, 4, 2}, 5));
+}
+
+static void test_remove (void) {
+    list_t list;
+    list_init(&list);
+    for (int i = 0; i < NODE_COUNT; i++) {
+        list_insert_last(&list, nodes + i);
+    }
+
+    CHECK(list_remove_first(&list) == nodes + 0);
+    CHECK(list_remove(&list, nodes + 2) == nodes + 2);
+    CHECK(list_remove(&list, nodes + 4) == nodes + 4);
+    CHECK(list_matches(&list, (int []){1, 3}, 2));
+
+    CHECK(list_remove(&list, nodes + 1) == nodes + 1);
+    CHECK(list_remove_first(&list) == nodes + 3);
+    CHECK(list_is_empty(&list));
+    CHECK(list_last(&list) == (list_node_t *)0);
+    CHECK(list_remove_first(&list) == (list_node_t *)0);
+}
+
+int main (void) {
+    RUN_TEST(test_insert);
+    RUN_TEST(test_remove);
+    return test_result();
+}
@@ -0,0 +1,57 @@
+/**
+ * tty收发缓冲区的测试
+ */
+#include "test.h"
+#include "dev/tty.h"
+
+#define FIFO_SIZE       8
+
+static void test_put_get (void) {
+    tty_fifo_t fifo;
+    char buf[FIFO_SIZE], c;
+
+    tty_fifo_init(&fifo, buf, FIFO_SIZE);
+    CHECK_EQ(tty_fifo_get(&fifo, &c), -1);
+
+    for (int i = 0; i < FIFO_SIZE; i++) {
+        CHECK_EQ(tty_fifo_put(&fifo, 'a' + i), 0);
+    }
+    CHECK_EQ(tty_fifo_put(&fifo, 'z'), -1);
+
+    for (int i = 0; i < FIFO_SIZE; i++) {
+        CHECK_EQ(tty_fifo_get(&fifo, &c), 0);
+        CHECK_EQ(c, 'a' + i);
+    }
+    CHECK_EQ(tty_fifo_get(&fifo, &c), -1);
+
+    // 每次操作后都应退出中断保护并释放锁
+    CHECK_EQ(host_irq_depth, 0);
+    CHECK_EQ(fifo.lock.locked, 0);
+}
+
+static void test_wrap (void) {
+    tty_fifo_t fifo;
+    char buf[FIFO_SIZE], c;
+
+    // 读写位置多次绕回，顺序保持不变
+    tty_fifo_init(&fifo, buf, FIFO_SIZE);
+    int next_put = 0, next_get = 0;
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 5; i++) {
+            CHECK_EQ(tty_fifo_put(&fifo, (char)next_put++), 0);
+        }
+        for (int i = 0; i < 5; i++) {
+            CHECK_EQ(tty_fifo_get(&fifo, &c), 0);
+            CHECK_EQ(c, (char)next_get++);
+        }
+        CHECK_EQ(fifo.count, 0);
+    }
+    CHECK((fifo.read >= 0) && (fifo.read < FIFO_SIZE));
+    CHECK_EQ(fifo.read, fifo.write);
+}
+
+int main (void) {
+    RUN_TEST(test_put_get);
+    RUN_TEST(test_wrap);
+    return test_result();
+}